@@ -1,12 +1,28 @@
 #include "core/Game.h"
 
-#include "systems/Input.h"
 #include "raylib.h"
+#include "sim/Profiler.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 
 Game::Game()
-    : renderer_(tilePixelSize_) {
+    : simulation_(tilePixelSize_),
+      renderer_(tilePixelSize_) {
+}
+
+namespace {
+    // Teleports (respawns, match resets) would otherwise slide across the map.
+    Vector2 Interpolate(Vector2 from, Vector2 to, float alpha, float snapDistance) {
+        const float dx = to.x - from.x;
+        const float dy = to.y - from.y;
+        if (dx * dx + dy * dy > snapDistance * snapDistance) {
+            return to;
+        }
+        return Vector2{ from.x + dx * alpha, from.y + dy * alpha };
+    }
 }
 
 void Game::Run() {
@@ -15,263 +31,310 @@ void Game::Run() {
         return;
     }
 
-    while (!WindowShouldClose()) {
-        const float deltaSeconds = GetFrameTime();
-        Update(deltaSeconds);
-
-        BeginDrawing();
-        ClearBackground(Color{ 10, 10, 18, 255 }); // background once per frame
-        Draw();
-        EndDrawing();
+    Profiler::SetThreadName("main");
+    if (rollback_ != nullptr) {
+        rollback_->SetMetrics(&metrics_);
+    } else {
+        simulation_.SetMetrics(&metrics_);
     }
-
-    CloseWindow();
-}
-
-bool Game::Initialize() {
-    if (!map_.LoadFromFile(mapPath_)) {
-        return false;
+    if (!metricsExporter_.Start(metrics_, metricsOptions_)) {
+        TraceLog(LOG_WARNING, "Could not serve metrics on 127.0.0.1:%d", metricsOptions_.port);
+    } else if (metricsExporter_.IsServing()) {
+        TraceLog(LOG_INFO, "Metrics at http://127.0.0.1:%d/metrics", metricsOptions_.port);
     }
+    if (!sampler_.Start()) {
+        TraceLog(LOG_INFO, "No thread-safe key state on this platform; sampling input once per frame.");
+    }
+    InputLogHeader header{ mapPath_, tilePixelSize_, simulation_.GetGhostCount() };
+    header.ghostSchedule = simulation_.GetGhostSchedule();
+    header.ghostScheduleRules = simulation_.GetGhostScheduleRules();
+    header.ghostTargeting = simulation_.GetGhostTargeting();
+    header.ghostSpawnRules = simulation_.GetGhostSpawnRules();
+    recorder_.Begin(header);
+
+    // Publish the menu before the thread starts so the first frame has
+    // something to draw.
+    const int64_t stepNs = static_cast<int64_t>(fixedDeltaSeconds_ * 1e9f);
+    snapshotWriter_.BeginStep(simulation_);
+    snapshotWriter_.Write(simulation_, InputSampler::Now() - stepNs, stepNs, snapshots_.GetWriteSlot());
+    snapshots_.Publish();
+    simulationThread_ = std::thread([this] { SimulationLoop(); });
+
+    const int64_t refreshNs = 1000000000 / targetFps_;
+    int64_t lastFrameStartNs = 0;
+    while (!WindowShouldClose()) {
+        // Measured from frame start to frame start, so time spent waiting on
+        // the frame cap or a stalled driver shows up as well as our own work.
+        const int64_t frameStartNs = InputSampler::Now();
+        if (lastFrameStartNs != 0) {
+            const int64_t frameNs = frameStartNs - lastFrameStartNs;
+            metrics_.frameTime.Record(frameNs);
+            const int64_t refreshes = (frameNs + refreshNs / 2) / refreshNs;
+            if (refreshes > 1) {
+                metrics_.droppedFrames.fetch_add(static_cast<uint64_t>(refreshes - 1), std::memory_order_relaxed);
+            }
+        }
+        lastFrameStartNs = frameStartNs;
+        metrics_.frames.fetch_add(1, std::memory_order_relaxed);
 
-    mapPixelWidth_ = map_.GetWidth() * tilePixelSize_;
-    mapPixelHeight_ = map_.GetHeight() * tilePixelSize_;
-    screenWidth_ = mapPixelWidth_ + uiPanelWidth_;
-    screenHeight_ = mapPixelHeight_;
-
-    InitWindow(screenWidth_, screenHeight_, "Pacmen");
-    SetTargetFPS(60);
-
-    playerA_.radius = tilePixelSize_ * 0.35f;
-    playerA_.speed = tilePixelSize_ * 6.0f;
-    playerA_.color = YELLOW;
-
-    playerB_.radius = tilePixelSize_ * 0.35f;
-    playerB_.speed = tilePixelSize_ * 6.0f;
-    playerB_.color = GREEN;
-
-    ResetSession();
+        const RenderSnapshot& snapshot = snapshots_.AcquireLatest();
 
-    TraceLog(LOG_INFO, "tileSize=%d screen=%dx%d map=%dx%d",
-         tilePixelSize_, screenWidth_, screenHeight_, map_.GetWidth(), map_.GetHeight());
+        // Start/reset are edge-triggered; the simulation thread clears them
+        // when a step consumes them, so a press is never lost between steps.
+        const InputFrame input = SampleInput(snapshot.state);
+        if (input.startPressed) {
+            startRequested_.store(true, std::memory_order_relaxed);
+        }
+        if (input.resetPressed) {
+            resetRequested_.store(true, std::memory_order_relaxed);
+        }
 
-    return true;
-}
+        sampler_.SetFocused(IsWindowFocused());
+        if (!sampler_.IsThreaded()) {
+            sampler_.Submit(input.player1Direction, input.player2Direction);
+        }
 
-void Game::Update(float deltaSeconds) {
-    if (IsKeyPressed(KEY_R)) {
-        ResetToMenu();
-        return;
-    }
+        // The snapshot holds the state at the end of its step; drawing it
+        // that far into the step keeps motion smooth at any refresh rate.
+        const float alpha = std::clamp(
+            static_cast<float>(InputSampler::Now() - snapshot.stepStartNs) / static_cast<float>(snapshot.stepNs),
+            0.0f, 1.0f);
 
-    if (state_ == GameState::Menu) {
-        const Rectangle startRect = GetStartButtonRect();
-        const Vector2 mouse = GetMousePosition();
-        const bool hovered = IsPointInRect(mouse, startRect);
-        const bool clicked = hovered && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+        BeginDrawing();
+        ClearBackground(Color{ 10, 10, 18, 255 }); // background once per frame
+        Draw(snapshot, alpha);
+        {
+            PACMEN_PROFILE_ZONE("EndDrawing");
+            EndDrawing();
+        }
 
-        if (clicked || Input::IsStartPressed()) {
-            ResetSession();
-            state_ = GameState::Playing;
+        if (Profiler::kEnabled && Input::IsTraceDumpPressed()) {
+            WriteTrace();
         }
-        return;
     }
 
-    if (state_ == GameState::GameOver || state_ == GameState::Win) {
-        return;
+    simulationStopping_.store(true, std::memory_order_relaxed);
+    simulationThread_.join();
+    if (rollback_) {
+        // The recording stops at the last tick both inputs were known for.
+        rollback_->RewindToConfirmed();
+        const RollbackStats& stats = rollback_->GetStats();
+        TraceLog(LOG_INFO, "netplay: %llu ticks, %llu rollbacks, %llu re-simulated, %llu stalls",
+                 static_cast<unsigned long long>(stats.ticks), static_cast<unsigned long long>(stats.rollbacks),
+                 static_cast<unsigned long long>(stats.resimulatedTicks),
+                 static_cast<unsigned long long>(stats.stalls));
     }
-
-    playerA_.invulnerableSeconds = std::max(0.0f, playerA_.invulnerableSeconds - deltaSeconds);
-    playerB_.invulnerableSeconds = std::max(0.0f, playerB_.invulnerableSeconds - deltaSeconds);
-
-    TryMovePlayer(playerA_, Input::GetPlayer1Direction(), deltaSeconds);
-    TryMovePlayer(playerB_, Input::GetPlayer2Direction(), deltaSeconds);
-
-    HandlePelletPickup(playerA_);
-    HandlePelletPickup(playerB_);
-
-    if (map_.GetRemainingPellets() == 0) {
-        state_ = GameState::Win;
-        return;
+    sampler_.Stop();
+    metricsExporter_.Stop();
+    LogInputLatency();
+    if (Profiler::kEnabled) {
+        WriteTrace();
     }
-
-    ghostSystem_.Update(ghosts_, map_, playerA_, playerB_, deltaSeconds, tilePixelSize_);
-
-    if (playerA_.lives <= 0 && playerB_.lives <= 0) {
-        state_ = GameState::GameOver;
+    if (!recorder_.Save(recordPath_, simulation_.ComputeStateHash())) {
+        TraceLog(LOG_WARNING, "Could not write session recording to %s", recordPath_.c_str());
     }
+    renderer_.Unload();
+    CloseWindow();
 }
 
-void Game::Draw() const {
-    renderer_.DrawMap(map_);
-    renderer_.DrawPlayer(playerA_);
-    renderer_.DrawPlayer(playerB_);
-    for (const Ghost& ghost : ghosts_) {
-        renderer_.DrawGhost(ghost);
-    }
+void Game::SimulationLoop() {
+    using Clock = std::chrono::steady_clock;
+
+    Profiler::SetThreadName("simulation");
+    const int64_t stepNs = static_cast<int64_t>(fixedDeltaSeconds_ * 1e9f);
+    InputFrame input{};
+
+    // Steps are scheduled on a fixed wall-clock grid. Each one covers
+    // [stepStartNs, stepStartNs + stepNs) and takes the direction changes
+    // sampled up to the end of that interval.
+    int64_t stepStartNs = InputSampler::Now();
+    while (!simulationStopping_.load(std::memory_order_relaxed)) {
+        {
+            PACMEN_PROFILE_ZONE("Game::Update");
+            sampler_.Consume(stepStartNs + stepNs, input, inputLatency_);
+            input.startPressed = startRequested_.exchange(false, std::memory_order_relaxed);
+            input.resetPressed = resetRequested_.exchange(false, std::memory_order_relaxed);
+
+            snapshotWriter_.BeginStep(simulation_);
+            const int64_t updateStartNs = InputSampler::Now();
+            if (rollback_) {
+                // Poll may roll back; doing it after BeginStep lets the
+                // frame blend from the predicted positions to the corrected
+                // ones instead of jumping.
+                InputFrame local = input;
+                if (local.player1Direction.x == 0.0f && local.player1Direction.y == 0.0f) {
+                    local.player1Direction = input.player2Direction;
+                }
+                local.player2Direction = local.player1Direction;
+                rollback_->Poll();
+                rollback_->Advance(local);
+            } else {
+                recorder_.Record(input, fixedDeltaSeconds_);
+                simulation_.Update(input, fixedDeltaSeconds_);
+            }
+            metrics_.updateTime.Record(InputSampler::Now() - updateStartNs);
+            snapshotWriter_.Write(simulation_, stepStartNs, stepNs, snapshots_.GetWriteSlot());
+            snapshots_.Publish();
+        }
 
-    const Rectangle startRect = GetStartButtonRect();
-    const Vector2 mouse = GetMousePosition();
-    const bool hovered = IsPointInRect(mouse, startRect);
-    const bool showStart = (state_ == GameState::Menu);
-    const bool showGameOver = (state_ == GameState::GameOver);
-    const bool showWin = (state_ == GameState::Win);
-    renderer_.DrawUI(map_, playerA_, playerB_, uiPanelWidth_, uiPadding_, rowHeight_,
-                     showStart, startRect, hovered, showGameOver, showWin);
+        stepStartNs += stepNs;
+        const int64_t now = InputSampler::Now();
+        if (now - stepStartNs > stepNs * maxStepsBehind_) {
+            // Too far behind (debugger, suspended laptop): drop the time
+            // instead of running a burst of steps to catch up.
+            stepStartNs = now;
+        }
+        if (stepStartNs > now) {
+            std::this_thread::sleep_until(Clock::time_point(std::chrono::nanoseconds(stepStartNs)));
+        }
+    }
 }
 
+bool Game::Initialize() {
+    simulation_.SetGhostTargeting(GhostTargeting::Mixed);
+    if (!simulation_.LoadMap(mapPath_)) {
+        TraceLog(LOG_ERROR, "Failed to load map: %s", mapPath_.c_str());
+        return false;
+    }
 
-void Game::TryMovePlayer(Player& player, Vector2 direction, float deltaSeconds) {
-    if (direction.x == 0.0f && direction.y == 0.0f) {
-        return;
+    if (netplayOptions_.localPlayer == 1 || netplayOptions_.localPlayer == 2) {
+        if (!transport_.Open(netplayOptions_.localPort, netplayOptions_.peer)) {
+            TraceLog(LOG_ERROR, "Could not open UDP port %d to %s", netplayOptions_.localPort,
+                     netplayOptions_.peer.c_str());
+            return false;
+        }
+        rollback_ = std::make_unique<RollbackSession>(simulation_, transport_, netplayOptions_.localPlayer - 1,
+                                                      fixedDeltaSeconds_);
+        rollback_->SetInputDelay(netplayOptions_.inputDelay);
+        rollback_->SetRecorder(&recorder_);
+        TraceLog(LOG_INFO, "netplay: player %d on port %d, peer %s", netplayOptions_.localPlayer,
+                 netplayOptions_.localPort, netplayOptions_.peer.c_str());
     }
 
-    Vector2 next = {
-        player.position.x + direction.x * player.speed * deltaSeconds,
-        player.position.y + direction.y * player.speed * deltaSeconds
-    };
+    const TileMap& map = simulation_.GetMap();
+    mapPixelWidth_ = simulation_.GetMapPixelWidth();
+    mapPixelHeight_ = simulation_.GetMapPixelHeight();
+    viewportWidth_ = std::min(mapPixelWidth_, maxViewportWidth_);
+    viewportHeight_ = std::min(mapPixelHeight_, maxViewportHeight_);
+    screenWidth_ = viewportWidth_ + uiPanelWidth_;
+    screenHeight_ = viewportHeight_;
 
-    int tileX = static_cast<int>(next.x / tilePixelSize_);
-    int tileY = static_cast<int>(next.y / tilePixelSize_);
+    InitWindow(screenWidth_, screenHeight_, "Pacmen");
+    SetTargetFPS(targetFps_);
 
-    if (!map_.IsWall(tileX, tileY)) {
-        player.position = next;
-    }
+    startButtonRect_ = ComputeStartButtonRect();
+    const Rectangle panel{ static_cast<float>(viewportWidth_), 0.0f,
+                           static_cast<float>(uiPanelWidth_), static_cast<float>(screenHeight_) };
+    renderer_.SetUILayout(panel, uiPadding_, rowHeight_, startButtonRect_);
 
-    player.position.x = std::clamp(player.position.x, player.radius, mapPixelWidth_ - player.radius);
-    player.position.y = std::clamp(player.position.y, player.radius, mapPixelHeight_ - player.radius);
-}
+    TraceLog(LOG_INFO, "tileSize=%d screen=%dx%d map=%dx%d",
+         tilePixelSize_, screenWidth_, screenHeight_, map.GetWidth(), map.GetHeight());
 
-Vector2 Game::TileToWorldCenter(Vector2 tile) const {
-    return {
-        (tile.x + 0.5f) * tilePixelSize_,
-        (tile.y + 0.5f) * tilePixelSize_
-    };
+    return true;
 }
 
-void Game::InitializeGhosts() {
-    ghosts_.clear();
-    ghosts_.reserve(6);
-
-    std::vector<Vector2> spawnTiles = map_.GetGhostSpawns();
-    if (spawnTiles.size() > 6) {
-        spawnTiles.resize(6);
+void Game::WriteTrace() const {
+    if (Profiler::WriteChromeTrace(tracePath_)) {
+        TraceLog(LOG_INFO, "Wrote profiler trace to %s", tracePath_.c_str());
+    } else {
+        TraceLog(LOG_WARNING, "Could not write profiler trace to %s", tracePath_.c_str());
     }
+}
 
-    if (spawnTiles.size() < 6) {
-        const int needed = 6 - static_cast<int>(spawnTiles.size());
-        std::vector<Vector2> fallback = FindFallbackGhostSpawns(needed, spawnTiles);
-        spawnTiles.insert(spawnTiles.end(), fallback.begin(), fallback.end());
+void Game::LogInputLatency() const {
+    if (inputLatency_.GetSampleCount() == 0) {
+        return;
     }
 
-    const Color ghostColors[6] = {
-        Color{ 230, 70, 60, 255 },
-        Color{ 255, 140, 0, 255 },
-        Color{ 255, 105, 180, 255 },
-        Color{ 80, 160, 255, 255 },
-        Color{ 170, 90, 255, 255 },
-        Color{ 60, 220, 120, 255 }
-    };
-
-    for (size_t i = 0; i < spawnTiles.size() && i < 6; ++i) {
-        Ghost ghost{};
-        ghost.radius = tilePixelSize_ * 0.33f;
-        ghost.speed = playerA_.speed * 0.25f;
-        ghost.color = ghostColors[i];
-        ghost.position = TileToWorldCenter(spawnTiles[i]);
-        ghost.currentDirection = { 0.0f, 0.0f };
-        ghosts_.push_back(ghost);
-    }
+    TraceLog(LOG_INFO, "input latency (ms) over %d changes: p50=%.2f p95=%.2f p99=%.2f max=%.2f dropped=%d",
+             static_cast<int>(inputLatency_.GetSampleCount()),
+             inputLatency_.Percentile(50.0) / 1e6, inputLatency_.Percentile(95.0) / 1e6,
+             inputLatency_.Percentile(99.0) / 1e6, inputLatency_.Max() / 1e6,
+             static_cast<int>(sampler_.GetDroppedCount()));
 }
 
-std::vector<Vector2> Game::FindFallbackGhostSpawns(int needed, const std::vector<Vector2>& usedTiles) const {
-    std::vector<Vector2> results;
-    results.reserve(needed);
-
-    const int centerX = map_.GetWidth() / 2;
-    const int centerY = map_.GetHeight() / 2;
-    const int maxRadius = std::max(map_.GetWidth(), map_.GetHeight());
-
-    auto tileUsed = [&usedTiles](int x, int y) {
-        for (const Vector2& tile : usedTiles) {
-            if (static_cast<int>(tile.x) == x && static_cast<int>(tile.y) == y) {
-                return true;
-            }
-        }
-        return false;
-    };
+InputFrame Game::SampleInput(GameState state) {
+    InputFrame input = keyboard_.Poll();
 
-    for (int radius = 0; radius <= maxRadius && static_cast<int>(results.size()) < needed; ++radius) {
-        for (int y = centerY - radius; y <= centerY + radius && static_cast<int>(results.size()) < needed; ++y) {
-            for (int x = centerX - radius; x <= centerX + radius && static_cast<int>(results.size()) < needed; ++x) {
-                if (x < 0 || y < 0 || x >= map_.GetWidth() || y >= map_.GetHeight()) {
-                    continue;
-                }
-                if (map_.IsWall(x, y)) {
-                    continue;
-                }
-                if (tileUsed(x, y)) {
-                    continue;
-                }
-                if (map_.HasPlayerSpawnA() &&
-                    static_cast<int>(map_.GetPlayerSpawnA().x) == x &&
-                    static_cast<int>(map_.GetPlayerSpawnA().y) == y) {
-                    continue;
-                }
-                if (map_.HasPlayerSpawnB() &&
-                    static_cast<int>(map_.GetPlayerSpawnB().x) == x &&
-                    static_cast<int>(map_.GetPlayerSpawnB().y) == y) {
-                    continue;
-                }
-
-                results.push_back(Vector2{ static_cast<float>(x), static_cast<float>(y) });
-            }
-        }
+    if (state == GameState::Menu) {
+        const Vector2 mouse = GetMousePosition();
+        const bool hovered = IsPointInRect(mouse, startButtonRect_);
+        input.startPressed = input.startPressed || (hovered && IsMouseButtonPressed(MOUSE_LEFT_BUTTON));
     }
 
-    return results;
+    return input;
 }
 
-void Game::ResetSession() {
-    map_.ResetTiles();
-
-    if (map_.HasPlayerSpawnA()) {
-        playerA_.position = TileToWorldCenter(map_.GetPlayerSpawnA());
-    } else {
-        playerA_.position = { tilePixelSize_ * 1.5f, tilePixelSize_ * 1.5f };
-    }
-    playerA_.spawnPosition = playerA_.position;
-    playerA_.lives = 3;
-    playerA_.score = 0;
-    playerA_.invulnerableSeconds = 0.0f;
+void Game::Draw(const RenderSnapshot& snapshot, float alpha) const {
+    // Walls never change after loading, so reading them while the
+    // simulation thread runs is safe; everything else comes from the snapshot.
+    const TileMap& map = simulation_.GetMap();
+    const GameState state = snapshot.state;
+    const float snapDistance = static_cast<float>(tilePixelSize_);
+
+    Player playerA = snapshot.playerA;
+    Player playerB = snapshot.playerB;
+    playerA.position = Interpolate(snapshot.previousPlayerA, playerA.position, alpha, snapDistance);
+    playerB.position = Interpolate(snapshot.previousPlayerB, playerB.position, alpha, snapDistance);
+
+    const Camera2D camera = ComputeCamera(Vector2{ (playerA.position.x + playerB.position.x) * 0.5f,
+                                                   (playerA.position.y + playerB.position.y) * 0.5f });
+    const Rectangle view{ camera.target.x - camera.offset.x, camera.target.y - camera.offset.y,
+                          static_cast<float>(viewportWidth_), static_cast<float>(viewportHeight_) };
+
+    renderer_.PrepareMap(map, view);
+    BeginMode2D(camera);
+    renderer_.DrawMap(map, snapshot.pellets.data(), view);
+    renderer_.DrawPlayer(playerA);
+    renderer_.DrawPlayer(playerB);
+
+    for (size_t i = 0; i < snapshot.ghostX.size(); ++i) {
+        const float radius = snapshot.ghostRadius[i];
+        const float x = snapshot.ghostX[i];
+        const float y = snapshot.ghostY[i];
+        if (x + radius + snapDistance < view.x || x - radius - snapDistance > view.x + view.width ||
+            y + radius + snapDistance < view.y || y - radius - snapDistance > view.y + view.height) {
+            continue;
+        }
 
-    if (map_.HasPlayerSpawnB()) {
-        playerB_.position = TileToWorldCenter(map_.GetPlayerSpawnB());
-    } else {
-        playerB_.position = { mapPixelWidth_ - tilePixelSize_ * 1.5f, mapPixelHeight_ - tilePixelSize_ * 1.5f };
+        Ghost ghost{};
+        ghost.position = Interpolate(Vector2{ snapshot.previousGhostX[i], snapshot.previousGhostY[i] },
+                                     Vector2{ x, y }, alpha, snapDistance);
+        ghost.radius = radius;
+        ghost.color = snapshot.ghostColor[i];
+        renderer_.DrawGhost(ghost);
     }
-    playerB_.spawnPosition = playerB_.position;
-    playerB_.lives = 3;
-    playerB_.score = 0;
-    playerB_.invulnerableSeconds = 0.0f;
-
-    InitializeGhosts();
-}
-
-void Game::ResetToMenu() {
-    ResetSession();
-    state_ = GameState::Menu;
+    EndMode2D();
+
+    UiState ui{};
+    ui.scoreA = playerA.score;
+    ui.scoreB = playerB.score;
+    ui.livesA = playerA.lives;
+    ui.livesB = playerB.lives;
+    ui.showStartButton = (state == GameState::Menu);
+    ui.startHovered = ui.showStartButton && IsPointInRect(GetMousePosition(), startButtonRect_);
+    ui.showGameOver = (state == GameState::GameOver);
+    ui.showWin = (state == GameState::Win);
+    renderer_.DrawUI(ui);
 }
 
-void Game::HandlePelletPickup(Player& player) {
-    const int tileX = static_cast<int>(player.position.x / tilePixelSize_);
-    const int tileY = static_cast<int>(player.position.y / tilePixelSize_);
-    if (map_.ConsumePelletAt(tileX, tileY)) {
-        player.score += 10;
-    }
+Camera2D Game::ComputeCamera(Vector2 focus) const {
+    // Centre on the focus but keep the view inside the map. Whole pixels
+    // keep the wall chunks from shimmering as the camera moves.
+    const float halfWidth = viewportWidth_ * 0.5f;
+    const float halfHeight = viewportHeight_ * 0.5f;
+    Camera2D camera{};
+    camera.offset = Vector2{ halfWidth, halfHeight };
+    camera.target = Vector2{
+        std::round(std::clamp(focus.x, halfWidth, std::max(halfWidth, mapPixelWidth_ - halfWidth))),
+        std::round(std::clamp(focus.y, halfHeight, std::max(halfHeight, mapPixelHeight_ - halfHeight)))
+    };
+    camera.zoom = 1.0f;
+    return camera;
 }
 
-Rectangle Game::GetStartButtonRect() const {
-    const float panelLeft = static_cast<float>(mapPixelWidth_);
+Rectangle Game::ComputeStartButtonRect() const {
+    const float panelLeft = static_cast<float>(viewportWidth_);
     const float padding = static_cast<float>(uiPadding_);
     const float buttonWidth = static_cast<float>(uiPanelWidth_) - padding * 2.0f;
     const float buttonHeight = static_cast<float>(rowHeight_ * 2);
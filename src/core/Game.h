@@ -1,58 +1,116 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
-#include <vector>
+#include <thread>
 
-#include "game/TileMap.h"
 #include "render/Renderer.h"
-#include "systems/GhostSystem.h"
-#include "entities/Ghost.h"
-#include "entities/Player.h"
+#include "sim/InputLog.h"
+#include "sim/LatencyStats.h"
+#include "sim/Metrics.h"
+#include "sim/MetricsExporter.h"
+#include "sim/NetTransport.h"
+#include "sim/RenderSnapshot.h"
+#include "sim/RollbackSession.h"
+#include "sim/Simulation.h"
+#include "sim/TripleBuffer.h"
+#include "systems/Input.h"
+#include "systems/InputSampler.h"
+
+struct NetplayOptions {
+    // 1 or 2 plays online as that player; 0 keeps both players on this
+    // keyboard. Online, either set of movement keys steers the local player.
+    int localPlayer = 0;
+    int localPort = 7777;
+    // "host:port" of the other player's game.
+    std::string peer{};
+    // Ticks of input lag traded for fewer rollbacks.
+    int inputDelay = 2;
+};
 
 class Game {
 public:
     Game();
+    // Takes effect at the next Run.
+    void SetMetricsOptions(const MetricsExportOptions& options) { metricsOptions_ = options; }
+    void SetNetplayOptions(const NetplayOptions& options) { netplayOptions_ = options; }
+    // A map file or "builtin:<name>"; see TileMap::LoadFromFile.
+    void SetMapPath(const std::string& path) { mapPath_ = path; }
     void Run();
 
 private:
-    enum class GameState {
-        Menu,
-        Playing,
-        GameOver,
-        Win
-    };
-
     bool Initialize();
-    void Update(float deltaSeconds);
-    void Draw() const;
-    void TryMovePlayer(Player& player, Vector2 direction, float deltaSeconds);
-    Vector2 TileToWorldCenter(Vector2 tile) const;
-    void InitializeGhosts();
-    std::vector<Vector2> FindFallbackGhostSpawns(int needed, const std::vector<Vector2>& usedTiles) const;
-    void ResetSession();
-    void ResetToMenu();
-    void HandlePelletPickup(Player& player);
-    Rectangle GetStartButtonRect() const;
+    void SimulationLoop();
+    InputFrame SampleInput(GameState state);
+    void WriteTrace() const;
+    void LogInputLatency() const;
+    void Draw(const RenderSnapshot& snapshot, float alpha) const;
+    Camera2D ComputeCamera(Vector2 focus) const;
+    Rectangle ComputeStartButtonRect() const;
     bool IsPointInRect(Vector2 point, Rectangle rect) const;
 
-    TileMap map_;
-
     const int tileSize_ = 24;
     const int uiPanelWidth_ = 260;
     const int uiPadding_ = 12;
     const int rowHeight_ = 24;
     const int tilePixelSize_ = tileSize_;
 
+    // The simulation runs on its own thread in steps of this size, whatever
+    // the display refresh rate. After falling this many steps behind it
+    // drops the time instead of catching up.
+    const float fixedDeltaSeconds_ = 1.0f / 120.0f;
+    const int maxStepsBehind_ = 10;
+    // Frames longer than this many display refreshes count as dropped ones.
+    const int targetFps_ = 60;
+
+    Simulation simulation_;
     Renderer renderer_;
-    Player playerA_{};
-    Player playerB_{};
-    std::vector<Ghost> ghosts_{};
-    GhostSystem ghostSystem_{};
+    KeyboardInputSource keyboard_{};
+    // Movement keys are sampled at 1 kHz off the main thread where the OS
+    // allows it; start/reset and the mouse stay on per-frame polling.
+    InputSampler sampler_{};
+    // Time from a direction change being sampled to the step that applies it.
+    LatencyStats inputLatency_{};
+    InputRecorder recorder_{};
+    // Frame, step and ghost update times plus match counters, recorded by
+    // the render and simulation threads and published on localhost.
+    Metrics metrics_{};
+    MetricsExportOptions metricsOptions_{};
+    MetricsExporter metricsExporter_{};
+    // Both set only when playing online; the session then owns stepping
+    // simulation_ and feeds recorder_ the confirmed ticks.
+    NetplayOptions netplayOptions_{};
+    UdpTransport transport_{};
+    std::unique_ptr<RollbackSession> rollback_{};
+
+    // simulation_, recorder_ and inputLatency_ belong to the simulation
+    // thread while it runs; the render thread only sees published snapshots
+    // and the map's walls.
+    std::thread simulationThread_{};
+    std::atomic<bool> simulationStopping_{ false };
+    std::atomic<bool> startRequested_{ false };
+    std::atomic<bool> resetRequested_{ false };
+    SnapshotWriter snapshotWriter_{};
+    TripleBuffer<RenderSnapshot> snapshots_{};
+
+    // The map view is at most this large; bigger maps scroll with a camera
+    // that follows the players.
+    const int maxViewportWidth_ = 1280;
+    const int maxViewportHeight_ = 768;
 
     int screenWidth_ = 0;
     int screenHeight_ = 0;
+    int viewportWidth_ = 0;
+    int viewportHeight_ = 0;
     int mapPixelWidth_ = 0;
     int mapPixelHeight_ = 0;
-    GameState state_ = GameState::Menu;
-    std::string mapPath_ = "assets/maps/level1.txt";
+    // Fixed once the window is open; the panel layout never changes.
+    Rectangle startButtonRect_{};
+    // Built into the binary, so the game starts from any working directory.
+    std::string mapPath_ = "builtin:level1";
+    // Written on F9 and on exit when built with PACMEN_PROFILE.
+    std::string tracePath_ = "pacmen_trace.json";
+    // Every session's inputs, replayable with pacmen_headless --replay.
+    std::string recordPath_ = "pacmen_last_session.pmr";
 };
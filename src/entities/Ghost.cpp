@@ -1 +1,49 @@
 #include "entities/Ghost.h"
+
+void GhostArray::Clear() {
+    positionX.clear();
+    positionY.clear();
+    directionX.clear();
+    directionY.clear();
+    speed.clear();
+    radius.clear();
+    color.clear();
+    role.clear();
+    waypoint.clear();
+}
+
+void GhostArray::Reserve(size_t count) {
+    positionX.reserve(count);
+    positionY.reserve(count);
+    directionX.reserve(count);
+    directionY.reserve(count);
+    speed.reserve(count);
+    radius.reserve(count);
+    color.reserve(count);
+    role.reserve(count);
+    waypoint.reserve(count);
+}
+
+void GhostArray::Add(const Ghost& ghost) {
+    positionX.push_back(ghost.position.x);
+    positionY.push_back(ghost.position.y);
+    directionX.push_back(ghost.currentDirection.x);
+    directionY.push_back(ghost.currentDirection.y);
+    speed.push_back(ghost.speed);
+    radius.push_back(ghost.radius);
+    color.push_back(ghost.color);
+    role.push_back(ghost.role);
+    waypoint.push_back(ghost.waypoint);
+}
+
+Ghost GhostArray::Get(size_t index) const {
+    Ghost ghost{};
+    ghost.position = { positionX[index], positionY[index] };
+    ghost.currentDirection = { directionX[index], directionY[index] };
+    ghost.speed = speed[index];
+    ghost.radius = radius[index];
+    ghost.color = color[index];
+    ghost.role = role[index];
+    ghost.waypoint = waypoint[index];
+    return ghost;
+}
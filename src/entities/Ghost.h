@@ -1,11 +1,62 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "raylib.h"
 
+// What a ghost heads for. Chasers share the per-player flow fields; every
+// other role has a destination of its own and is routed by the
+// hierarchical pathfinder.
+enum class GhostRole : uint8_t {
+    // The nearest player by path distance.
+    Chase,
+    // A few tiles ahead of the nearest player, in the direction they last moved.
+    Ambush,
+    // A fixed corner of the map.
+    Scatter,
+    // The map corners in turn, moving on as each is reached.
+    Patrol
+};
+
+// How roles are handed out when ghosts spawn.
+enum class GhostTargeting : uint8_t {
+    // Every ghost chases.
+    ChaseOnly,
+    // Chase, Ambush, Scatter and Patrol in turn.
+    Mixed
+};
+
 struct Ghost {
     Vector2 position{};
     float radius = 8.0f;
     float speed = 90.0f;
     Color color = RED;
     Vector2 currentDirection{ 0.0f, 0.0f };
+    GhostRole role = GhostRole::Chase;
+    // Scatter and Patrol: index of the corner currently headed for.
+    uint8_t waypoint = 0;
+};
+
+// Structure-of-arrays ghost storage: each field lives in its own contiguous
+// array so the movement kernel can load eight ghosts' worth of a field at once.
+struct GhostArray {
+    std::vector<float> positionX{};
+    std::vector<float> positionY{};
+    std::vector<float> directionX{};
+    std::vector<float> directionY{};
+    std::vector<float> speed{};
+    std::vector<float> radius{};
+    std::vector<Color> color{};
+    std::vector<GhostRole> role{};
+    std::vector<uint8_t> waypoint{};
+
+    size_t Size() const { return positionX.size(); }
+    bool Empty() const { return positionX.empty(); }
+
+    void Clear();
+    void Reserve(size_t count);
+    void Add(const Ghost& ghost);
+    Ghost Get(size_t index) const;
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "raylib.h"
 
 struct Player {
@@ -11,4 +13,9 @@ struct Player {
     int lives = 3;
     int score = 0;
     float invulnerableSeconds = 0.0f;
+    // Last non-zero direction the player moved in; ambushing ghosts aim ahead of it.
+    Vector2 heading{ 0.0f, 0.0f };
+    // Bumped each time a ghost sends the player back to its spawn, so the
+    // renderer can tell that jump from a move and not slide across it.
+    uint32_t respawns = 0;
 };
@@ -0,0 +1,39 @@
+#include "game/EmbeddedLevels.h"
+
+// Generated by CMake: kEmbeddedLevelText_<name> for each embedded map and
+// the PACMEN_EMBEDDED_LEVELS(X) list of names.
+#include "game/EmbeddedLevelText.h"
+#include "game/LevelParser.h"
+
+namespace {
+    template <const std::string_view& Text>
+    constexpr EmbeddedLevel MakeEmbeddedLevel(std::string_view name) {
+        using Level = ParsedLevel<Text>;
+        EmbeddedLevel level;
+        level.name = name;
+        level.width = Level::kShape.width;
+        level.height = Level::kShape.height;
+        level.wordsPerRow = Level::kImage.kWordsPerRow;
+        level.walls = Level::kImage.walls.data();
+        level.pellets = Level::kImage.pellets.data();
+        level.pelletCount = Level::kImage.pelletCount;
+        level.spawnA = Level::kImage.spawnA;
+        level.spawnB = Level::kImage.spawnB;
+        level.ghostSpawns = Level::kImage.ghostSpawns.data();
+        level.ghostSpawnCount = Level::kShape.ghostSpawnCount;
+        return level;
+    }
+
+#define PACMEN_EMBED_LEVEL(name) MakeEmbeddedLevel<kEmbeddedLevelText_##name>(#name),
+    constexpr EmbeddedLevel kEmbeddedLevels[] = { PACMEN_EMBEDDED_LEVELS(PACMEN_EMBED_LEVEL) };
+#undef PACMEN_EMBED_LEVEL
+}
+
+const EmbeddedLevel* FindEmbeddedLevel(std::string_view name) {
+    for (const EmbeddedLevel& level : kEmbeddedLevels) {
+        if (level.name == name) {
+            return &level;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "raylib.h"
+
+// A level built into the binary, already laid out the way TileMap keeps a
+// loaded map (see LevelParser.h). Every pointer is into static storage.
+struct EmbeddedLevel {
+    std::string_view name{};
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    const uint64_t* walls = nullptr;
+    const uint64_t* pellets = nullptr;
+    int pelletCount = 0;
+    Vector2 spawnA{};
+    Vector2 spawnB{};
+    const Vector2* ghostSpawns = nullptr;
+    int ghostSpawnCount = 0;
+};
+
+// Map paths starting with this name an embedded level, e.g. "builtin:level1".
+// Every file in assets/maps that CMakeLists.txt lists is embedded under its
+// file name without the extension.
+inline constexpr std::string_view kEmbeddedLevelPrefix = "builtin:";
+
+// Null when no level has that name.
+const EmbeddedLevel* FindEmbeddedLevel(std::string_view name);
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "raylib.h"
+
+// Compile-time counterpart of TileMap's text loader, for the levels built
+// into the binary (see EmbeddedLevels.cpp). The compiler parses the level,
+// checks it and lays it out as TileMap's bit planes, so a broken level fails
+// the build rather than the game.
+//
+// The runtime loader takes whatever it is given. Embedded levels are held
+// to more: rows all the same width, walls all round the border, exactly one
+// P and one Q, only # . P Q G and spaces, and Q, every G and every pellet
+// reachable from P.
+// Blank lines at the end are kept as empty rows, as the runtime loader keeps
+// them, but are left out of those checks.
+//
+// Constant evaluation is slow, so this is meant for hand-made levels, not
+// generated mazes thousands of tiles wide.
+
+struct LevelShape {
+    int width = 0;
+    int height = 0;
+    // Rows up to and including the last one that is not blank.
+    int contentHeight = 0;
+    int ghostSpawnCount = 0;
+    bool rectangular = true;
+};
+
+struct LevelCheck {
+    bool knownSymbols = true;
+    bool closedBorder = true;
+    int spawnACount = 0;
+    int spawnBCount = 0;
+    int pelletCount = 0;
+    bool spawnBReachable = false;
+    bool ghostSpawnsReachable = true;
+    bool pelletsReachable = true;
+};
+
+// The same planes TileMap::LoadText builds, as constants.
+template <int Width, int Height, int GhostSpawnCount>
+struct LevelImage {
+    static constexpr int kWordsPerRow = (Width + 63) / 64;
+    static constexpr size_t kWordCount = static_cast<size_t>(kWordsPerRow) * Height;
+
+    std::array<uint64_t, kWordCount> walls{};
+    std::array<uint64_t, kWordCount> pellets{};
+    std::array<Vector2, GhostSpawnCount> ghostSpawns{};
+    Vector2 spawnA{};
+    Vector2 spawnB{};
+    int pelletCount = 0;
+};
+
+// Calls visit(row, y) for each line, split the way std::getline splits a
+// file, with a trailing '\r' dropped.
+template <typename Visit>
+constexpr void ForEachLevelRow(std::string_view text, Visit&& visit) {
+    size_t start = 0;
+    int y = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view row = text.substr(start, end - start);
+        if (!row.empty() && row.back() == '\r') {
+            row.remove_suffix(1);
+        }
+        visit(row, y++);
+        start = end + 1;
+    }
+}
+
+constexpr LevelShape MeasureLevel(std::string_view text) {
+    LevelShape shape;
+    ForEachLevelRow(text, [&](std::string_view row, int y) {
+        if (static_cast<int>(row.size()) > shape.width) {
+            shape.width = static_cast<int>(row.size());
+        }
+        if (!row.empty()) {
+            shape.contentHeight = y + 1;
+        }
+        for (char c : row) {
+            shape.ghostSpawnCount += c == 'G' ? 1 : 0;
+        }
+        shape.height = y + 1;
+    });
+    ForEachLevelRow(text, [&](std::string_view row, int y) {
+        if (y < shape.contentHeight && static_cast<int>(row.size()) != shape.width) {
+            shape.rectangular = false;
+        }
+    });
+    return shape;
+}
+
+// Row-major symbols; short rows are padded with spaces.
+template <int Width, int Height>
+constexpr std::array<char, static_cast<size_t>(Width) * Height> ReadLevelGrid(std::string_view text) {
+    std::array<char, static_cast<size_t>(Width) * Height> grid{};
+    for (char& c : grid) {
+        c = ' ';
+    }
+    ForEachLevelRow(text, [&](std::string_view row, int y) {
+        for (size_t x = 0; x < row.size(); ++x) {
+            grid[static_cast<size_t>(y) * Width + x] = row[x];
+        }
+    });
+    return grid;
+}
+
+template <int Width, int Height>
+constexpr LevelCheck CheckLevel(const std::array<char, static_cast<size_t>(Width) * Height>& grid,
+                                int contentHeight) {
+    LevelCheck check;
+    int start = -1;
+    for (int y = 0; y < contentHeight; ++y) {
+        for (int x = 0; x < Width; ++x) {
+            const char c = grid[static_cast<size_t>(y) * Width + x];
+            const bool border = x == 0 || y == 0 || x == Width - 1 || y == contentHeight - 1;
+            if (c != '#' && c != '.' && c != 'P' && c != 'Q' && c != 'G' && c != ' ') {
+                check.knownSymbols = false;
+            }
+            if (border && c != '#') {
+                check.closedBorder = false;
+            }
+            if (c == 'P') {
+                ++check.spawnACount;
+                start = y * Width + x;
+            } else if (c == 'Q') {
+                ++check.spawnBCount;
+            } else if (c == '.') {
+                ++check.pelletCount;
+            }
+        }
+    }
+    if (start < 0) {
+        check.ghostSpawnsReachable = false;
+        check.pelletsReachable = false;
+        return check;
+    }
+
+    // Breadth-first flood from P over every tile that is not a wall.
+    std::array<bool, static_cast<size_t>(Width) * Height> reached{};
+    std::array<int, static_cast<size_t>(Width) * Height> queue{};
+    size_t head = 0;
+    size_t tail = 0;
+    reached[start] = true;
+    queue[tail++] = start;
+    while (head < tail) {
+        const int tile = queue[head++];
+        const int x = tile % Width;
+        const int y = tile / Width;
+        const int neighbours[4][2] = { { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+        for (const auto& next : neighbours) {
+            if (next[0] < 0 || next[1] < 0 || next[0] >= Width || next[1] >= Height) {
+                continue;
+            }
+            const int index = next[1] * Width + next[0];
+            if (!reached[index] && grid[index] != '#') {
+                reached[index] = true;
+                queue[tail++] = index;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < grid.size(); ++i) {
+        if (grid[i] == 'Q' && reached[i]) {
+            check.spawnBReachable = true;
+        } else if (grid[i] == 'G' && !reached[i]) {
+            check.ghostSpawnsReachable = false;
+        } else if (grid[i] == '.' && !reached[i]) {
+            check.pelletsReachable = false;
+        }
+    }
+    return check;
+}
+
+template <int Width, int Height, int GhostSpawnCount>
+constexpr LevelImage<Width, Height, GhostSpawnCount> BuildLevelImage(
+    const std::array<char, static_cast<size_t>(Width) * Height>& grid) {
+    using Image = LevelImage<Width, Height, GhostSpawnCount>;
+    Image image;
+    int ghost = 0;
+    for (int y = 0; y < Height; ++y) {
+        for (int x = 0; x < Width; ++x) {
+            const char c = grid[static_cast<size_t>(y) * Width + x];
+            const size_t word = static_cast<size_t>(y) * Image::kWordsPerRow + (x >> 6);
+            const uint64_t bit = uint64_t{ 1 } << (x & 63);
+            if (c == 'P') {
+                image.spawnA = Vector2{ static_cast<float>(x), static_cast<float>(y) };
+            } else if (c == 'Q') {
+                image.spawnB = Vector2{ static_cast<float>(x), static_cast<float>(y) };
+            } else if (c == 'G') {
+                image.ghostSpawns[ghost++] = Vector2{ static_cast<float>(x), static_cast<float>(y) };
+            } else if (c == '#') {
+                image.walls[word] |= bit;
+            } else if (c == '.') {
+                image.pellets[word] |= bit;
+                ++image.pelletCount;
+            }
+        }
+    }
+    return image;
+}
+
+// Everything about one level, worked out by the compiler. `Text` has to be a
+// constexpr string_view with static storage; a failed check stops the build
+// with one of the messages below, and the instantiation note names the level.
+template <const std::string_view& Text>
+struct ParsedLevel {
+    static constexpr LevelShape kShape = MeasureLevel(Text);
+    static_assert(kShape.width > 0 && kShape.contentHeight > 0, "embedded level is empty");
+    static_assert(kShape.rectangular, "embedded level rows must all be the same width");
+
+    static constexpr auto kGrid = ReadLevelGrid<kShape.width, kShape.height>(Text);
+    static constexpr LevelCheck kCheck = CheckLevel<kShape.width, kShape.height>(kGrid, kShape.contentHeight);
+    static_assert(kCheck.knownSymbols, "embedded level may only use '#', '.', 'P', 'Q', 'G' and spaces");
+    static_assert(kCheck.closedBorder, "embedded level must be walled in on every side");
+    static_assert(kCheck.spawnACount == 1, "embedded level needs exactly one 'P' spawn");
+    static_assert(kCheck.spawnBCount == 1, "embedded level needs exactly one 'Q' spawn");
+    static_assert(kCheck.pelletCount > 0, "embedded level has no pellets to collect");
+    static_assert(kCheck.spawnBReachable, "embedded level's 'Q' spawn cannot be reached from 'P'");
+    static_assert(kCheck.ghostSpawnsReachable, "embedded level has a 'G' spawn that cannot be reached from 'P'");
+    static_assert(kCheck.pelletsReachable, "embedded level has a pellet that cannot be reached from 'P', so it cannot be won");
+
+    static constexpr auto kImage =
+        BuildLevelImage<kShape.width, kShape.height, kShape.ghostSpawnCount>(kGrid);
+};
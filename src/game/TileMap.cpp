@@ -1,10 +1,113 @@
 #include "game/TileMap.h"
 
+#include <bit>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "game/EmbeddedLevels.h"
+#include "game/MappedFile.h"
+
+// Compiled map (.pmap) layout, little-endian, every section 8-byte aligned
+// so the planes can be used straight out of the mapping:
+//   CompiledMapHeader
+//   walls:        wordsPerRow * height uint64 words
+//   pellets:      wordsPerRow * height uint64 words (the starting pellets)
+//   ghost spawns: ghostSpawnCount pairs of float tile coordinates
+
+namespace {
+    constexpr char kCompiledMagic[4] = { 'P', 'M', 'A', 'P' };
+    constexpr uint32_t kCompiledVersion = 1;
+    constexpr uint32_t kHasSpawnA = 1;
+    constexpr uint32_t kHasSpawnB = 2;
+
+    struct CompiledMapHeader {
+        char magic[4];
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        uint32_t wordsPerRow;
+        uint32_t pelletCount;
+        uint32_t flags;
+        uint32_t ghostSpawnCount;
+        float spawnA[2];
+        float spawnB[2];
+        uint64_t wallsOffset;
+        uint64_t pelletsOffset;
+        uint64_t ghostSpawnsOffset;
+    };
+    static_assert(sizeof(CompiledMapHeader) % 8 == 0, "sections after the header must stay 8-byte aligned");
+
+    struct TextPlanes {
+        std::vector<uint64_t> walls;
+        std::vector<uint64_t> pellets;
+    };
+
+    int CountBits(const uint64_t* plane, size_t wordCount) {
+        int count = 0;
+        for (size_t i = 0; i < wordCount; ++i) {
+            count += std::popcount(plane[i]);
+        }
+        return count;
+    }
+
+    bool SectionFits(uint64_t offset, uint64_t bytes, size_t fileSize) {
+        return offset % 8 == 0 && offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    // A spawn read from a .pmap must be what the text loader could have
+    // produced: whole tile coordinates on the map, not inside a wall.
+    bool IsOpenTile(float x, float y, const uint64_t* walls, int wordsPerRow, int width, int height) {
+        if (!(x >= 0.0f && y >= 0.0f && x < static_cast<float>(width) && y < static_cast<float>(height)) ||
+            x != std::floor(x) || y != std::floor(y)) {
+            return false;
+        }
+        const int tileX = static_cast<int>(x);
+        const int tileY = static_cast<int>(y);
+        const uint64_t word = walls[static_cast<size_t>(tileY) * wordsPerRow + (tileX >> 6)];
+        return ((word >> (tileX & 63)) & 1u) == 0;
+    }
+
+    // True when no bit is set past the end of a row.
+    bool RowPaddingClear(const uint64_t* plane, int wordsPerRow, int width, int height) {
+        if (width % 64 == 0) {
+            return true;
+        }
+        const uint64_t padding = ~((uint64_t{ 1 } << (width % 64)) - 1);
+        for (int y = 0; y < height; ++y) {
+            if ((plane[static_cast<size_t>(y) * wordsPerRow + wordsPerRow - 1] & padding) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
 bool TileMap::LoadFromFile(const std::string& path) {
+    if (std::string_view(path).starts_with(kEmbeddedLevelPrefix)) {
+        const EmbeddedLevel* level = FindEmbeddedLevel(std::string_view(path).substr(kEmbeddedLevelPrefix.size()));
+        if (level == nullptr) return false;
+        LoadEmbedded(*level);
+        return true;
+    }
+
+    char magic[4] = {};
+    {
+        std::ifstream probe(path, std::ios::binary);
+        if (!probe.is_open()) return false;
+        probe.read(magic, sizeof(magic));
+    }
+
+    if (std::memcmp(magic, kCompiledMagic, sizeof(magic)) == 0) {
+        return LoadCompiled(path);
+    }
+    return LoadText(path);
+}
+
+bool TileMap::LoadText(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) return false;
 
@@ -22,76 +125,251 @@ bool TileMap::LoadFromFile(const std::string& path) {
 
     width_ = maxWidth;
     height_ = (int)lines.size();
-    tiles_.assign(height_, std::string(width_, ' '));
+    wordsPerRow_ = (width_ + 63) / 64;
+
+    auto planes = std::make_shared<TextPlanes>();
+    planes->walls.assign(GetWordCount(), 0);
+    planes->pellets.assign(GetWordCount(), 0);
 
     hasSpawnA_ = false;
     hasSpawnB_ = false;
     ghostSpawns_.clear();
-    remainingPellets_ = 0;
 
     for (int y = 0; y < height_; ++y) {
         const std::string& src = lines[y];
         for (int x = 0; x < (int)src.size(); ++x) {
-            char c = src[x];
+            const char c = src[x];
+            const uint64_t bit = uint64_t{ 1 } << (x & 63);
 
             if (c == 'P') {
                 spawnA_ = Vector2{ (float)x, (float)y };
                 hasSpawnA_ = true;
-                c = ' ';
             } else if (c == 'Q') {
                 spawnB_ = Vector2{ (float)x, (float)y };
                 hasSpawnB_ = true;
-                c = ' ';
             } else if (c == 'G') {
                 ghostSpawns_.push_back(Vector2{ (float)x, (float)y });
-                c = ' ';
+            } else if (c == '#') {
+                planes->walls[WordIndex(x, y)] |= bit;
+            } else if (c == '.') {
+                planes->pellets[WordIndex(x, y)] |= bit;
             }
+        }
+    }
 
-            tiles_[y][x] = c;
-            if (c == '.') {
-                ++remainingPellets_;
-            }
+    walls_ = planes->walls.data();
+    originalPellets_ = planes->pellets.data();
+    backing_ = std::move(planes);
+    originalPelletCount_ = CountBits(originalPellets_, GetWordCount());
+
+    pellets_.assign(originalPellets_, originalPellets_ + GetWordCount());
+    remainingPellets_ = originalPelletCount_;
+    ++layoutRevision_;
+
+    return true;
+}
+
+bool TileMap::LoadCompiled(const std::string& path) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(path) || file->GetSize() < sizeof(CompiledMapHeader)) {
+        return false;
+    }
+
+    CompiledMapHeader header;
+    std::memcpy(&header, file->GetData(), sizeof(header));
+    if (std::memcmp(header.magic, kCompiledMagic, sizeof(header.magic)) != 0 ||
+        header.version != kCompiledVersion ||
+        header.width <= 0 || header.height <= 0 ||
+        header.wordsPerRow != static_cast<uint32_t>((header.width + 63) / 64)) {
+        return false;
+    }
+
+    const uint64_t planeBytes = static_cast<uint64_t>(header.wordsPerRow) * static_cast<uint64_t>(header.height) * 8;
+    const uint64_t spawnBytes = static_cast<uint64_t>(header.ghostSpawnCount) * 2 * sizeof(float);
+    if (!SectionFits(header.wallsOffset, planeBytes, file->GetSize()) ||
+        !SectionFits(header.pelletsOffset, planeBytes, file->GetSize()) ||
+        !SectionFits(header.ghostSpawnsOffset, spawnBytes, file->GetSize())) {
+        return false;
+    }
+
+    // Everything the simulation indexes with is checked before any of it
+    // is taken: spawns, the pellet count and stray bits past the row ends.
+    const uint8_t* data = file->GetData();
+    const uint64_t* walls = reinterpret_cast<const uint64_t*>(data + header.wallsOffset);
+    const uint64_t* pellets = reinterpret_cast<const uint64_t*>(data + header.pelletsOffset);
+    const int wordsPerRow = static_cast<int>(header.wordsPerRow);
+    const size_t wordCount = static_cast<size_t>(wordsPerRow) * header.height;
+    auto isOpen = [&](float x, float y) {
+        return IsOpenTile(x, y, walls, wordsPerRow, header.width, header.height);
+    };
+    const bool hasSpawnA = (header.flags & kHasSpawnA) != 0;
+    const bool hasSpawnB = (header.flags & kHasSpawnB) != 0;
+    if ((hasSpawnA && !isOpen(header.spawnA[0], header.spawnA[1])) ||
+        (hasSpawnB && !isOpen(header.spawnB[0], header.spawnB[1])) ||
+        !RowPaddingClear(walls, wordsPerRow, header.width, header.height) ||
+        !RowPaddingClear(pellets, wordsPerRow, header.width, header.height) ||
+        static_cast<uint64_t>(CountBits(pellets, wordCount)) != header.pelletCount) {
+        return false;
+    }
+    std::vector<Vector2> ghostSpawns(header.ghostSpawnCount);
+    if (spawnBytes > 0) {
+        std::memcpy(ghostSpawns.data(), data + header.ghostSpawnsOffset, spawnBytes);
+    }
+    for (const Vector2& spawn : ghostSpawns) {
+        if (!isOpen(spawn.x, spawn.y)) {
+            return false;
         }
     }
 
-    originalTiles_ = tiles_;
+    width_ = header.width;
+    height_ = header.height;
+    wordsPerRow_ = wordsPerRow;
+
+    hasSpawnA_ = hasSpawnA;
+    hasSpawnB_ = hasSpawnB;
+    spawnA_ = Vector2{ header.spawnA[0], header.spawnA[1] };
+    spawnB_ = Vector2{ header.spawnB[0], header.spawnB[1] };
+    ghostSpawns_ = std::move(ghostSpawns);
+
+    walls_ = walls;
+    originalPellets_ = pellets;
+    backing_ = std::move(file);
+    originalPelletCount_ = static_cast<int>(header.pelletCount);
+
+    pellets_.assign(originalPellets_, originalPellets_ + GetWordCount());
+    remainingPellets_ = originalPelletCount_;
+    ++layoutRevision_;
 
     return true;
 }
 
-char TileMap::GetTile(int x, int y) const {
-    if (x < 0 || y < 0 || x >= width_ || y >= height_) return '#';
-    return tiles_[y][x];
+void TileMap::LoadEmbedded(const EmbeddedLevel& level) {
+    width_ = level.width;
+    height_ = level.height;
+    wordsPerRow_ = level.wordsPerRow;
+
+    // Checked at compile time to have both spawns.
+    hasSpawnA_ = true;
+    hasSpawnB_ = true;
+    spawnA_ = level.spawnA;
+    spawnB_ = level.spawnB;
+    ghostSpawns_.assign(level.ghostSpawns, level.ghostSpawns + level.ghostSpawnCount);
+
+    // Static storage; nothing to keep alive.
+    walls_ = level.walls;
+    originalPellets_ = level.pellets;
+    backing_.reset();
+    originalPelletCount_ = level.pelletCount;
+
+    pellets_.assign(originalPellets_, originalPellets_ + GetWordCount());
+    remainingPellets_ = originalPelletCount_;
+    ++layoutRevision_;
+}
+
+bool TileMap::SaveCompiled(const std::string& path) const {
+    if (walls_ == nullptr) {
+        return false;
+    }
+
+    const uint64_t planeBytes = static_cast<uint64_t>(GetWordCount()) * 8;
+
+    CompiledMapHeader header{};
+    std::memcpy(header.magic, kCompiledMagic, sizeof(header.magic));
+    header.version = kCompiledVersion;
+    header.width = width_;
+    header.height = height_;
+    header.wordsPerRow = static_cast<uint32_t>(wordsPerRow_);
+    header.pelletCount = static_cast<uint32_t>(originalPelletCount_);
+    header.flags = (hasSpawnA_ ? kHasSpawnA : 0) | (hasSpawnB_ ? kHasSpawnB : 0);
+    header.ghostSpawnCount = static_cast<uint32_t>(ghostSpawns_.size());
+    header.spawnA[0] = spawnA_.x;
+    header.spawnA[1] = spawnA_.y;
+    header.spawnB[0] = spawnB_.x;
+    header.spawnB[1] = spawnB_.y;
+    header.wallsOffset = sizeof(CompiledMapHeader);
+    header.pelletsOffset = header.wallsOffset + planeBytes;
+    header.ghostSpawnsOffset = header.pelletsOffset + planeBytes;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(walls_), static_cast<std::streamsize>(planeBytes));
+    file.write(reinterpret_cast<const char*>(originalPellets_), static_cast<std::streamsize>(planeBytes));
+    for (const Vector2& spawn : ghostSpawns_) {
+        const float tile[2] = { spawn.x, spawn.y };
+        file.write(reinterpret_cast<const char*>(tile), sizeof(tile));
+    }
+    return static_cast<bool>(file);
 }
 
-bool TileMap::IsWall(int x, int y) const {
-    return GetTile(x, y) == '#';
+char TileMap::GetTile(int x, int y) const {
+    if (IsWall(x, y)) return '#';
+    return TestBit(pellets_.data(), x, y) ? '.' : ' ';
 }
 
 bool TileMap::ConsumePelletAt(int x, int y) {
-    if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    if (static_cast<unsigned>(x) >= static_cast<unsigned>(width_) ||
+        static_cast<unsigned>(y) >= static_cast<unsigned>(height_)) {
+        return false;
+    }
+
+    uint64_t& word = pellets_[WordIndex(x, y)];
+    const uint64_t bit = uint64_t{ 1 } << (x & 63);
+    if ((word & bit) == 0) {
         return false;
     }
 
-    if (tiles_[y][x] == '.') {
-        tiles_[y][x] = ' ';
-        if (remainingPellets_ > 0) {
-            --remainingPellets_;
+    word &= ~bit;
+    --remainingPellets_;
+    consumedPellets_.push_back(static_cast<uint32_t>(y) * static_cast<uint32_t>(width_) + static_cast<uint32_t>(x));
+    return true;
+}
+
+void TileMap::SyncPelletPlane(std::vector<uint64_t>& plane, uint32_t& generation, size_t& applied) const {
+    if (plane.size() != pellets_.size() || generation != pelletGeneration_ || applied > consumedPellets_.size()) {
+        plane.assign(pellets_.begin(), pellets_.end());
+        generation = pelletGeneration_;
+    } else {
+        const uint32_t width = static_cast<uint32_t>(width_);
+        for (size_t i = applied; i < consumedPellets_.size(); ++i) {
+            const int x = static_cast<int>(consumedPellets_[i] % width);
+            const int y = static_cast<int>(consumedPellets_[i] / width);
+            plane[WordIndex(x, y)] &= ~(uint64_t{ 1 } << (x & 63));
         }
-        return true;
     }
+    applied = consumedPellets_.size();
+}
 
-    return false;
+void TileMap::RestorePellets(const std::vector<uint64_t>& plane, int remaining, uint32_t generation,
+                             size_t consumedCount) {
+    if (generation == pelletGeneration_ && consumedCount <= consumedPellets_.size()) {
+        const uint32_t width = static_cast<uint32_t>(width_);
+        for (size_t i = consumedCount; i < consumedPellets_.size(); ++i) {
+            const int x = static_cast<int>(consumedPellets_[i] % width);
+            const int y = static_cast<int>(consumedPellets_[i] / width);
+            pellets_[WordIndex(x, y)] |= uint64_t{ 1 } << (x & 63);
+        }
+        consumedPellets_.resize(consumedCount);
+    } else if (plane.size() == pellets_.size()) {
+        std::memcpy(pellets_.data(), plane.data(), pellets_.size() * sizeof(uint64_t));
+        // The log now only counts from here.
+        consumedPellets_.clear();
+    }
+    remainingPellets_ = remaining;
+    ++pelletGeneration_;
 }
 
 void TileMap::ResetTiles() {
-    tiles_ = originalTiles_;
-    remainingPellets_ = 0;
-    for (const std::string& row : tiles_) {
-        for (char c : row) {
-            if (c == '.') {
-                ++remainingPellets_;
-            }
-        }
+    // Walls never change during a match, so only the pellet plane is restored.
+    if (!pellets_.empty()) {
+        std::memcpy(pellets_.data(), originalPellets_, pellets_.size() * sizeof(uint64_t));
     }
+    remainingPellets_ = originalPelletCount_;
+    // Reserved up front so consuming pellets never allocates mid-match.
+    consumedPellets_.clear();
+    consumedPellets_.reserve(static_cast<size_t>(originalPelletCount_));
+    ++pelletGeneration_;
 }
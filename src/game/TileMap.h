@@ -1,18 +1,50 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include "raylib.h"
 
+struct EmbeddedLevel;
+
+// Walls and pellets are kept as row-major bit planes (one bit per tile,
+// rows padded to whole 64-bit words), so a 4096x4096 map costs 2 MiB per
+// plane and a tile test is a shift and a mask.
+//
+// Walls and the starting pellets never change after loading. They are read
+// from shared storage, either planes parsed from a text map, a memory-mapped
+// .pmap used in place or an embedded level's constants, so copies of a
+// TileMap share them and only carry their own live pellet plane.
 class TileMap {
 public:
+    // Accepts text maps and compiled .pmap files, told apart by their first
+    // bytes, and "builtin:<name>" for a level embedded at build time (see
+    // EmbeddedLevels.h), which needs no file at all.
     bool LoadFromFile(const std::string& path);
+    // Writes the loaded map as a .pmap (see TileMap.cpp for the layout).
+    bool SaveCompiled(const std::string& path) const;
 
     int GetWidth() const { return width_; }
     int GetHeight() const { return height_; }
 
     char GetTile(int x, int y) const;
-    bool IsWall(int x, int y) const;
+    bool IsWall(int x, int y) const {
+        // Out-of-range coordinates wrap to huge unsigned values, so one
+        // compare per axis covers both sides and they read as walls.
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(width_) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(height_)) {
+            return true;
+        }
+        return TestBit(walls_, x, y);
+    }
+    bool HasPelletAt(int x, int y) const {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(width_) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(height_)) {
+            return false;
+        }
+        return TestBit(pellets_.data(), x, y);
+    }
     bool ConsumePelletAt(int x, int y);
     void ResetTiles();
 
@@ -23,12 +55,57 @@ public:
     const std::vector<Vector2>& GetGhostSpawns() const { return ghostSpawns_; }
     int GetRemainingPellets() const { return remainingPellets_; }
 
+    // Raw wall plane for vectorised readers: row y starts at word
+    // y * GetWordsPerRow(), and bit (x & 63) of word (x >> 6) is tile x.
+    const uint64_t* GetWallWords() const { return walls_; }
+    const uint64_t* GetPelletWords() const { return pellets_.data(); }
+    int GetWordsPerRow() const { return wordsPerRow_; }
+
+    // Bumped whenever the wall layout changes, so derived data can tell when it is stale.
+    uint32_t GetLayoutRevision() const { return layoutRevision_; }
+
+    // Tiles emptied since the last ResetTiles, in order, as y * width + x,
+    // and a counter bumped by every ResetTiles and RestorePellets. A copy of
+    // the pellet plane stays current by replaying the new tail of the log,
+    // and only needs a full copy when the generation has moved on.
+    const std::vector<uint32_t>& GetConsumedPellets() const { return consumedPellets_; }
+    uint32_t GetPelletGeneration() const { return pelletGeneration_; }
+    // Brings such a copy up to date. `generation` and `applied` say where
+    // `plane` was last synced and are moved on to now.
+    void SyncPelletPlane(std::vector<uint64_t>& plane, uint32_t& generation, size_t& applied) const;
+
+    // Rollback: makes the pellet plane `plane` again, with `remaining`
+    // pellets. `plane` is a copy taken when the log held `consumedCount`
+    // entries of `generation`; while the log still starts that way only the
+    // pellets consumed since are put back, otherwise the whole plane is
+    // copied. Pellets reappear, so the generation moves on either way.
+    void RestorePellets(const std::vector<uint64_t>& plane, int remaining, uint32_t generation, size_t consumedCount);
+
 private:
+    size_t WordIndex(int x, int y) const {
+        return static_cast<size_t>(y) * wordsPerRow_ + (static_cast<unsigned>(x) >> 6);
+    }
+    bool TestBit(const uint64_t* plane, int x, int y) const {
+        return (plane[WordIndex(x, y)] >> (x & 63)) & 1u;
+    }
+    size_t GetWordCount() const { return static_cast<size_t>(wordsPerRow_) * height_; }
+    bool LoadText(const std::string& path);
+    bool LoadCompiled(const std::string& path);
+    void LoadEmbedded(const EmbeddedLevel& level);
+
     int width_ = 0;
     int height_ = 0;
-    std::vector<std::string> tiles_;
-    std::vector<std::string> originalTiles_;
+    int wordsPerRow_ = 0;
+    // Keeps whatever walls_ and originalPellets_ point into alive.
+    std::shared_ptr<const void> backing_;
+    const uint64_t* walls_ = nullptr;
+    const uint64_t* originalPellets_ = nullptr;
+    std::vector<uint64_t> pellets_;
+    int originalPelletCount_ = 0;
     int remainingPellets_ = 0;
+    uint32_t layoutRevision_ = 0;
+    std::vector<uint32_t> consumedPellets_{};
+    uint32_t pelletGeneration_ = 0;
 
     Vector2 spawnA_{ 0.0f, 0.0f };
     Vector2 spawnB_{ 0.0f, 0.0f };
@@ -1,7 +1,46 @@
 #include "core/Game.h"
 
-int main() {
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv) {
+    MetricsExportOptions metrics{};
+    metrics.port = MetricsExportOptions::kDefaultPort;
+    NetplayOptions netplay{};
+    std::string mapPath{};
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--map") == 0 && hasValue) {
+            mapPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-port") == 0 && hasValue) {
+            metrics.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--metrics-log") == 0 && hasValue) {
+            metrics.logPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-interval") == 0 && hasValue) {
+            metrics.logIntervalSeconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-local") == 0 && hasValue) {
+            netplay.localPlayer = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-port") == 0 && hasValue) {
+            netplay.localPort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-peer") == 0 && hasValue) {
+            netplay.peer = argv[++i];
+        } else if (std::strcmp(argv[i], "--net-delay") == 0 && hasValue) {
+            netplay.inputDelay = std::atoi(argv[++i]);
+        } else {
+            std::printf("usage: %s [--map path] [--metrics-port N] [--metrics-log path] [--metrics-interval seconds]"
+                        " [--net-local 1|2 --net-peer host:port] [--net-port N] [--net-delay ticks]\n", argv[0]);
+            return 1;
+        }
+    }
+
     Game game;
+    game.SetMetricsOptions(metrics);
+    game.SetNetplayOptions(netplay);
+    if (!mapPath.empty()) {
+        game.SetMapPath(mapPath);
+    }
     game.Run();
     return 0;
 }
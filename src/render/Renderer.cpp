@@ -1,36 +1,206 @@
 #include "render/Renderer.h"
 
 #include "raylib.h"
+#include "sim/Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
 
 Renderer::Renderer(int tilePixelSize)
     : tilePixelSize_(tilePixelSize) {
 }
 
-void Renderer::DrawMap(const TileMap& map) const {
+namespace {
+    uint64_t ChunkKey(int chunkX, int chunkY) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(chunkY)) << 32) | static_cast<uint32_t>(chunkX);
+    }
+}
+
+void Renderer::Unload() {
+    ReleaseWallChunks();
+    ReleaseUI();
+}
+
+void Renderer::ReleaseWallChunks() const {
+    for (auto& entry : wallChunks_) {
+        if (entry.second.texture.id != 0) {
+            UnloadRenderTexture(entry.second.texture);
+        }
+    }
+    wallChunks_.clear();
+    wallChunkMap_ = nullptr;
+}
+
+bool Renderer::VisibleTiles(const TileMap& map, const Rectangle& view, int& minX, int& minY, int& maxX, int& maxY) const {
+    minX = std::max(0, static_cast<int>(std::floor(view.x / tilePixelSize_)));
+    minY = std::max(0, static_cast<int>(std::floor(view.y / tilePixelSize_)));
+    maxX = std::min(map.GetWidth() - 1, static_cast<int>(std::floor((view.x + view.width) / tilePixelSize_)));
+    maxY = std::min(map.GetHeight() - 1, static_cast<int>(std::floor((view.y + view.height) / tilePixelSize_)));
+    return minX <= maxX && minY <= maxY;
+}
+
+void Renderer::PrepareMap(const TileMap& map, const Rectangle& view) const {
+    PACMEN_PROFILE_ZONE("Renderer::PrepareMap");
+    ++frame_;
+    InvalidateChunksIfStale(map);
+
+    int minX, minY, maxX, maxY;
+    if (VisibleTiles(map, view, minX, minY, maxX, maxY)) {
+        for (int chunkY = minY / kChunkTiles; chunkY <= maxY / kChunkTiles; ++chunkY) {
+            for (int chunkX = minX / kChunkTiles; chunkX <= maxX / kChunkTiles; ++chunkX) {
+                EnsureWallChunk(map, chunkX, chunkY);
+            }
+        }
+    }
+    EvictWallChunks();
+}
+
+void Renderer::DrawMap(const TileMap& map, const uint64_t* pellets, const Rectangle& view) const {
+    PACMEN_PROFILE_ZONE("Renderer::DrawMap");
+
+    int minX, minY, maxX, maxY;
+    if (!VisibleTiles(map, view, minX, minY, maxX, maxY)) {
+        return;
+    }
+
+    const int chunkPixels = kChunkTiles * tilePixelSize_;
+    for (int chunkY = minY / kChunkTiles; chunkY <= maxY / kChunkTiles; ++chunkY) {
+        for (int chunkX = minX / kChunkTiles; chunkX <= maxX / kChunkTiles; ++chunkX) {
+            const auto found = wallChunkMap_ == &map ? wallChunks_.find(ChunkKey(chunkX, chunkY)) : wallChunks_.end();
+            if (found == wallChunks_.end() || found->second.texture.id == 0) {
+                DrawWalls(map, std::max(minX, chunkX * kChunkTiles), std::max(minY, chunkY * kChunkTiles),
+                          std::min(maxX, (chunkX + 1) * kChunkTiles - 1), std::min(maxY, (chunkY + 1) * kChunkTiles - 1));
+                continue;
+            }
+            const RenderTexture2D& texture = found->second.texture;
+            // Render textures are stored bottom-up, so flip the source rectangle.
+            const Rectangle source{ 0.0f, 0.0f,
+                                    static_cast<float>(texture.texture.width),
+                                    -static_cast<float>(texture.texture.height) };
+            DrawTextureRec(texture.texture, source,
+                           Vector2{ static_cast<float>(chunkX * chunkPixels), static_cast<float>(chunkY * chunkPixels) },
+                           WHITE);
+        }
+    }
+
+    Color pelletColor { 255, 210, 120, 255 };
+
+    // Walk only the words covering the visible columns, masking off the
+    // columns either side of the view.
+    const int wordsPerRow = map.GetWordsPerRow();
+    const int firstWord = minX >> 6;
+    const int lastWord = maxX >> 6;
+    for (int y = minY; y <= maxY; ++y) {
+        const uint64_t* row = pellets + static_cast<size_t>(y) * wordsPerRow;
+        for (int w = firstWord; w <= lastWord; ++w) {
+            uint64_t bits = row[w];
+            if (w == firstWord) {
+                bits &= ~uint64_t{ 0 } << (minX & 63);
+            }
+            if (w == lastWord && (maxX & 63) != 63) {
+                bits &= (uint64_t{ 1 } << ((maxX & 63) + 1)) - 1;
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                const int x = w * 64 + std::countr_zero(bits);
+                DrawCircle(x * tilePixelSize_ + tilePixelSize_ / 2,
+                           y * tilePixelSize_ + tilePixelSize_ / 2,
+                           tilePixelSize_ * 0.15f,
+                           pelletColor);
+            }
+        }
+    }
+}
+
+void Renderer::InvalidateChunksIfStale(const TileMap& map) const {
+    if (wallChunkMap_ == &map &&
+        wallChunkRevision_ == map.GetLayoutRevision() &&
+        wallChunkTileSize_ == tilePixelSize_) {
+        return;
+    }
+
+    ReleaseWallChunks();
+    wallChunkMap_ = &map;
+    wallChunkRevision_ = map.GetLayoutRevision();
+    wallChunkTileSize_ = tilePixelSize_;
+}
+
+void Renderer::EnsureWallChunk(const TileMap& map, int chunkX, int chunkY) const {
+    auto found = wallChunks_.find(ChunkKey(chunkX, chunkY));
+    if (found != wallChunks_.end()) {
+        found->second.lastUsedFrame = frame_;
+        return;
+    }
+
+    const int size = kChunkTiles * tilePixelSize_;
+    WallChunk chunk{};
+    chunk.lastUsedFrame = frame_;
+    chunk.texture = LoadRenderTexture(size, size);
+    if (chunk.texture.id == 0) {
+        TraceLog(LOG_WARNING, "Wall chunk %dx%d unavailable, drawing walls directly.", size, size);
+        wallChunks_.emplace(ChunkKey(chunkX, chunkY), chunk);
+        return;
+    }
+
+    // Called between BeginDrawing and EndDrawing but outside any BeginMode2D:
+    // raylib flushes the pending batch on the switch and restores the screen
+    // target afterwards, resetting the transform. The chunk's own camera
+    // shifts its tiles to the texture origin.
+    const int firstX = chunkX * kChunkTiles;
+    const int firstY = chunkY * kChunkTiles;
+    Camera2D chunkCamera{};
+    chunkCamera.target = Vector2{ static_cast<float>(firstX * tilePixelSize_), static_cast<float>(firstY * tilePixelSize_) };
+    chunkCamera.zoom = 1.0f;
+    BeginTextureMode(chunk.texture);
+    ClearBackground(BLANK);
+    BeginMode2D(chunkCamera);
+    DrawWalls(map, firstX, firstY,
+              std::min(map.GetWidth(), firstX + kChunkTiles) - 1,
+              std::min(map.GetHeight(), firstY + kChunkTiles) - 1);
+    EndMode2D();
+    EndTextureMode();
+
+    wallChunks_.emplace(ChunkKey(chunkX, chunkY), chunk);
+}
+
+void Renderer::EvictWallChunks() const {
+    // Never evicts a chunk in view this frame, so a viewport that needs more
+    // than the budget still draws completely; it just holds more for a while.
+    while (wallChunks_.size() > kChunkBudget) {
+        auto oldest = wallChunks_.end();
+        for (auto it = wallChunks_.begin(); it != wallChunks_.end(); ++it) {
+            if (oldest == wallChunks_.end() || it->second.lastUsedFrame < oldest->second.lastUsedFrame) {
+                oldest = it;
+            }
+        }
+        if (oldest->second.lastUsedFrame == frame_) {
+            return;
+        }
+        if (oldest->second.texture.id != 0) {
+            UnloadRenderTexture(oldest->second.texture);
+        }
+        wallChunks_.erase(oldest);
+    }
+}
+
+void Renderer::DrawWalls(const TileMap& map, int minX, int minY, int maxX, int maxY) const {
 
     // Use strong contrast so walls are clearly visible against the background.
     // In the previous version, wallFill was a bright blue that could blend into
     // a similar blue background, making walls look "invisible".
     Color wallFill    { 0, 40, 140, 255 };        // darker blue
     Color wallOutline { 255, 255, 255, 255 };     // white outline
-    Color pelletColor { 255, 210, 120, 255 };
 
-    for (int y = 0; y < map.GetHeight(); ++y) {
-        for (int x = 0; x < map.GetWidth(); ++x) {
-            const char tile = map.GetTile(x, y);
-            const int worldX = x * tilePixelSize_;
-            const int worldY = y * tilePixelSize_;
-
-            if (tile == '#') {
-                Rectangle r{ (float)worldX, (float)worldY, (float)tilePixelSize_, (float)tilePixelSize_ };
-                DrawRectangleRec(r, wallFill);
-                DrawRectangleLinesEx(r, 2.0f, wallOutline);
-            } else if (tile == '.') {
-                DrawCircle(worldX + tilePixelSize_ / 2,
-                           worldY + tilePixelSize_ / 2,
-                           tilePixelSize_ * 0.15f,
-                           pelletColor);
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            if (!map.IsWall(x, y)) {
+                continue;
             }
+
+            Rectangle r{ (float)(x * tilePixelSize_), (float)(y * tilePixelSize_),
+                         (float)tilePixelSize_, (float)tilePixelSize_ };
+            DrawRectangleRec(r, wallFill);
+            DrawRectangleLinesEx(r, 2.0f, wallOutline);
         }
     }
 }
@@ -44,76 +214,124 @@ void Renderer::DrawGhost(const Ghost& ghost) const {
 }
 
 namespace {
-    void DrawButton(const Rectangle& rect, const char* label, bool hovered) {
-        const Color fill = hovered ? Color{ 90, 120, 220, 255 } : Color{ 70, 95, 190, 255 };
-        const Color border = hovered ? RAYWHITE : Color{ 220, 220, 220, 255 };
-        DrawRectangleRec(rect, fill);
-        DrawRectangleLinesEx(rect, 2.0f, border);
+    constexpr int kButtonFontSize = 28;
+    constexpr const char* kStartLabel = "START";
+}
+
+void Renderer::ReleaseUI() const {
+    if (uiTexture_.id != 0) {
+        UnloadRenderTexture(uiTexture_);
+    }
+    uiTexture_ = RenderTexture2D{};
+    uiTextureTried_ = false;
+    uiDrawnValid_ = false;
+}
+
+void Renderer::SetUILayout(const Rectangle& panel, int uiPadding, int rowHeight, const Rectangle& startButton) {
+    ReleaseUI();
+
+    UiLayout layout{};
+    layout.panel = panel;
+    layout.startButton = startButton;
+    layout.textX = static_cast<int>(panel.x) + uiPadding;
 
-        const int fontSize = 28;
-        const int textWidth = MeasureText(label, fontSize);
-        const int textX = static_cast<int>(rect.x + (rect.width - textWidth) * 0.5f);
-        const int textY = static_cast<int>(rect.y + (rect.height - fontSize) * 0.5f);
-        DrawText(label, textX, textY, fontSize, RAYWHITE);
-    }
-}
-
-void Renderer::DrawUI(const TileMap& map,
-                      const Player& playerA,
-                      const Player& playerB,
-                      int uiPanelWidth,
-                      int uiPadding,
-                      int rowHeight,
-                      bool showStartButton,
-                      const Rectangle& startButton,
-                      bool startHovered,
-                      bool showGameOver,
-                      bool showWin) const {
-    const int mapPixelWidth = map.GetWidth() * tilePixelSize_;
-    Rectangle panel{ static_cast<float>(mapPixelWidth), 0.0f,
-                     static_cast<float>(uiPanelWidth),
-                     static_cast<float>(map.GetHeight() * tilePixelSize_) };
-
-    DrawRectangleRec(panel, Color{ 20, 22, 32, 255 });
-    DrawRectangleLinesEx(panel, 2.0f, Color{ 50, 55, 75, 255 });
-
-    int textX = mapPixelWidth + uiPadding;
     int textY = uiPadding;
-    const int lineHeight = rowHeight;
-
-    DrawText("Scoreboard", textX, textY, 22, RAYWHITE);
-    textY += lineHeight + 4;
-
-    DrawText(TextFormat("P1 Score: %d", playerA.score), textX, textY, 20, RAYWHITE);
-    textY += lineHeight;
-    DrawText(TextFormat("P2 Score: %d", playerB.score), textX, textY, 20, RAYWHITE);
-    textY += lineHeight + 4;
-    DrawText(TextFormat("P1 Lives: %d", playerA.lives), textX, textY, 20, RAYWHITE);
-    textY += lineHeight;
-    DrawText(TextFormat("P2 Lives: %d", playerB.lives), textX, textY, 20, RAYWHITE);
-    textY += lineHeight + uiPadding;
-
-    DrawText("P1 WASD | P2 Arrows", textX, textY, 18, Color{ 180, 190, 210, 255 });
-    textY += lineHeight;
-    DrawText("Enter/Space: Start", textX, textY, 18, Color{ 180, 190, 210, 255 });
-    textY += lineHeight;
-
-    if (showWin) {
-        DrawText("YOU WIN", textX, textY, 26, Color{ 120, 220, 150, 255 });
-        textY += lineHeight + 4;
-        DrawText("Press R for Menu", textX, textY, 18, Color{ 200, 200, 200, 255 });
-        textY += lineHeight;
-        DrawText("Press Esc to Quit", textX, textY, 18, Color{ 200, 200, 200, 255 });
-        textY += lineHeight;
-    }
-
-    if (showGameOver) {
-        DrawText("GAME OVER", textX, textY, 24, Color{ 255, 120, 90, 255 });
-        textY += lineHeight;
-        DrawText("Press R to return to Menu", textX, textY, 18, Color{ 200, 200, 200, 255 });
-    }
-
-    if (showStartButton) {
-        DrawButton(startButton, "START", startHovered);
+    layout.titleY = textY;
+    textY += rowHeight + 4;
+    layout.scoreAY = textY;
+    textY += rowHeight;
+    layout.scoreBY = textY;
+    textY += rowHeight + 4;
+    layout.livesAY = textY;
+    textY += rowHeight;
+    layout.livesBY = textY;
+    textY += rowHeight + uiPadding;
+    layout.controlsY = textY;
+    textY += rowHeight;
+    layout.startHintY = textY;
+    textY += rowHeight;
+    layout.messageY = textY;
+    layout.winHintY = textY + rowHeight + 4;
+    layout.winQuitY = layout.winHintY + rowHeight;
+    layout.gameOverHintY = textY + rowHeight;
+
+    const int labelWidth = MeasureText(kStartLabel, kButtonFontSize);
+    layout.startLabelX = static_cast<int>(startButton.x + (startButton.width - labelWidth) * 0.5f);
+    layout.startLabelY = static_cast<int>(startButton.y + (startButton.height - kButtonFontSize) * 0.5f);
+    uiLayout_ = layout;
+}
+
+void Renderer::DrawUI(const UiState& state) const {
+    PACMEN_PROFILE_ZONE("Renderer::DrawUI");
+    const Rectangle& panel = uiLayout_.panel;
+
+    if (!uiTextureTried_) {
+        uiTextureTried_ = true;
+        uiTexture_ = LoadRenderTexture(static_cast<int>(panel.width), static_cast<int>(panel.height));
+        if (uiTexture_.id == 0) {
+            TraceLog(LOG_WARNING, "UI panel texture unavailable, drawing the panel directly.");
+        }
+    }
+    if (uiTexture_.id == 0) {
+        DrawPanel(state);
+        return;
+    }
+
+    if (!uiDrawnValid_ || state != uiDrawn_) {
+        PACMEN_PROFILE_ZONE("Renderer::RedrawUI");
+        // The panel keeps its screen coordinates; the camera moves them to
+        // the texture origin, as for wall chunks.
+        Camera2D panelCamera{};
+        panelCamera.target = Vector2{ panel.x, panel.y };
+        panelCamera.zoom = 1.0f;
+        BeginTextureMode(uiTexture_);
+        ClearBackground(BLANK);
+        BeginMode2D(panelCamera);
+        DrawPanel(state);
+        EndMode2D();
+        EndTextureMode();
+        uiDrawn_ = state;
+        uiDrawnValid_ = true;
+    }
+
+    // Render textures are stored bottom-up, so flip the source rectangle.
+    const Rectangle source{ 0.0f, 0.0f,
+                            static_cast<float>(uiTexture_.texture.width),
+                            -static_cast<float>(uiTexture_.texture.height) };
+    DrawTextureRec(uiTexture_.texture, source, Vector2{ panel.x, panel.y }, WHITE);
+}
+
+void Renderer::DrawPanel(const UiState& state) const {
+    const UiLayout& layout = uiLayout_;
+    DrawRectangleRec(layout.panel, Color{ 20, 22, 32, 255 });
+    DrawRectangleLinesEx(layout.panel, 2.0f, Color{ 50, 55, 75, 255 });
+
+    const int textX = layout.textX;
+    DrawText("Scoreboard", textX, layout.titleY, 22, RAYWHITE);
+    DrawText(TextFormat("P1 Score: %d", state.scoreA), textX, layout.scoreAY, 20, RAYWHITE);
+    DrawText(TextFormat("P2 Score: %d", state.scoreB), textX, layout.scoreBY, 20, RAYWHITE);
+    DrawText(TextFormat("P1 Lives: %d", state.livesA), textX, layout.livesAY, 20, RAYWHITE);
+    DrawText(TextFormat("P2 Lives: %d", state.livesB), textX, layout.livesBY, 20, RAYWHITE);
+
+    DrawText("P1 WASD | P2 Arrows", textX, layout.controlsY, 18, Color{ 180, 190, 210, 255 });
+    DrawText("Enter/Space: Start", textX, layout.startHintY, 18, Color{ 180, 190, 210, 255 });
+
+    if (state.showWin) {
+        DrawText("YOU WIN", textX, layout.messageY, 26, Color{ 120, 220, 150, 255 });
+        DrawText("Press R for Menu", textX, layout.winHintY, 18, Color{ 200, 200, 200, 255 });
+        DrawText("Press Esc to Quit", textX, layout.winQuitY, 18, Color{ 200, 200, 200, 255 });
+    }
+    if (state.showGameOver) {
+        DrawText("GAME OVER", textX, layout.messageY, 24, Color{ 255, 120, 90, 255 });
+        DrawText("Press R to return to Menu", textX, layout.gameOverHintY, 18, Color{ 200, 200, 200, 255 });
+    }
+
+    if (state.showStartButton) {
+        const Rectangle& rect = layout.startButton;
+        const Color fill = state.startHovered ? Color{ 90, 120, 220, 255 } : Color{ 70, 95, 190, 255 };
+        const Color border = state.startHovered ? RAYWHITE : Color{ 220, 220, 220, 255 };
+        DrawRectangleRec(rect, fill);
+        DrawRectangleLinesEx(rect, 2.0f, border);
+        DrawText(kStartLabel, layout.startLabelX, layout.startLabelY, kButtonFontSize, RAYWHITE);
     }
 }
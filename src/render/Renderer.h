@@ -1,29 +1,113 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
 #include "game/TileMap.h"
 #include "entities/Ghost.h"
 #include "entities/Player.h"
 
+// Everything the side panel shows.
+struct UiState {
+    int scoreA = 0;
+    int scoreB = 0;
+    int livesA = 0;
+    int livesB = 0;
+    bool showStartButton = false;
+    bool startHovered = false;
+    bool showGameOver = false;
+    bool showWin = false;
+
+    bool operator==(const UiState&) const = default;
+};
+
 class Renderer {
 public:
     explicit Renderer(int tilePixelSize);
 
-    void DrawMap(const TileMap& map) const;
+    // Releases GPU resources; call while the window is still open.
+    void Unload();
+
+    // `view` is the world-space rectangle on screen. Only tiles inside it
+    // are drawn, so the cost follows the viewport rather than the map.
+    // PrepareMap builds any wall chunks coming into view; call it once per
+    // frame after BeginDrawing and before BeginMode2D, since drawing into a
+    // chunk resets the camera transform.
+    void PrepareMap(const TileMap& map, const Rectangle& view) const;
+    void DrawMap(const TileMap& map, const Rectangle& view) const { DrawMap(map, map.GetPelletWords(), view); }
+    // Walls from the map, pellets from a plane in the map's layout, such as
+    // a snapshot taken on another thread.
+    void DrawMap(const TileMap& map, const uint64_t* pellets, const Rectangle& view) const;
     void DrawPlayer(const Player& player) const;
     void DrawGhost(const Ghost& ghost) const;
-    void DrawUI(const TileMap& map,
-                const Player& playerA,
-                const Player& playerB,
-                int uiPanelWidth,
-                int uiPadding,
-                int rowHeight,
-                bool showStartButton,
-                const Rectangle& startButton,
-                bool startHovered,
-                bool showGameOver,
-                bool showWin) const;
+    // Fixes where the side panel, its text and the start button sit; call
+    // once the window is open, since it measures text.
+    void SetUILayout(const Rectangle& panel, int uiPadding, int rowHeight, const Rectangle& startButton);
+    // The panel is drawn into a texture of its own and only redrawn when
+    // `state` differs from the last one drawn; other frames just blit it.
+    // Call outside BeginMode2D, like PrepareMap.
+    void DrawUI(const UiState& state) const;
     int GetTilePixelSize() const { return tilePixelSize_; }
+    void SetTilePixelSize(int tilePixelSize) { tilePixelSize_ = tilePixelSize; }
+
+    // Square wall chunks, in tiles, and how many stay cached.
+    static constexpr int kChunkTiles = 16;
+    static constexpr size_t kChunkBudget = 64;
 
 private:
+    struct WallChunk {
+        RenderTexture2D texture{};
+        uint64_t lastUsedFrame = 0;
+    };
+
+    bool VisibleTiles(const TileMap& map, const Rectangle& view, int& minX, int& minY, int& maxX, int& maxY) const;
+    void ReleaseWallChunks() const;
+    void InvalidateChunksIfStale(const TileMap& map) const;
+    void EnsureWallChunk(const TileMap& map, int chunkX, int chunkY) const;
+    void EvictWallChunks() const;
+    void DrawWalls(const TileMap& map, int minX, int minY, int maxX, int maxY) const;
+    void ReleaseUI() const;
+    void DrawPanel(const UiState& state) const;
+
+    // Screen positions worked out by SetUILayout.
+    struct UiLayout {
+        Rectangle panel{};
+        Rectangle startButton{};
+        int textX = 0;
+        int titleY = 0;
+        int scoreAY = 0;
+        int scoreBY = 0;
+        int livesAY = 0;
+        int livesBY = 0;
+        int controlsY = 0;
+        int startHintY = 0;
+        int messageY = 0;
+        int winHintY = 0;
+        int winQuitY = 0;
+        int gameOverHintY = 0;
+        int startLabelX = 0;
+        int startLabelY = 0;
+    };
+
     int tilePixelSize_ = 24;
+
+    // Walls never change during a match, so each chunk of them is drawn once
+    // into an off-screen texture when it first comes into view and blitted
+    // after that. Chunks that have been off screen longest are released once
+    // more than kChunkBudget are cached. Everything is rebuilt when the map
+    // layout or the tile size changes.
+    mutable std::unordered_map<uint64_t, WallChunk> wallChunks_{};
+    mutable const TileMap* wallChunkMap_ = nullptr;
+    mutable uint32_t wallChunkRevision_ = 0;
+    mutable int wallChunkTileSize_ = 0;
+    mutable uint64_t frame_ = 0;
+
+    UiLayout uiLayout_{};
+    // The panel as last drawn; uiDrawnValid_ is false until the first draw
+    // and after the layout changes. Without a texture it is drawn directly.
+    mutable RenderTexture2D uiTexture_{};
+    mutable bool uiTextureTried_ = false;
+    mutable UiState uiDrawn_{};
+    mutable bool uiDrawnValid_ = false;
 };
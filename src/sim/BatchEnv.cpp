@@ -0,0 +1,212 @@
+#include "sim/BatchEnv.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const Vector2 kActionDirections[5] = {
+        { 0.0f, 0.0f },
+        { -1.0f, 0.0f },
+        { 0.0f, -1.0f },
+        { 1.0f, 0.0f },
+        { 0.0f, 1.0f }
+    };
+
+    Vector2 DecodeAction(uint8_t action) {
+        return action < 5 ? kActionDirections[action] : kActionDirections[PACMEN_ACTION_NONE];
+    }
+
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    int TotalScore(const Simulation& simulation) {
+        return simulation.GetPlayerA().score + simulation.GetPlayerB().score;
+    }
+}
+
+BatchEnv::~BatchEnv() {
+    StopWorkers();
+}
+
+bool BatchEnv::Initialize(const Config& config) {
+    StopWorkers();
+    sessions_.clear();
+    chunks_.clear();
+    deltaSeconds_ = config.deltaSeconds;
+
+    for (int i = 0; i < config.sessionCount; ++i) {
+        auto simulation = std::make_unique<Simulation>();
+        simulation->SetGhostCount(config.ghostCount);
+        if (!simulation->LoadMap(config.mapPath)) {
+            sessions_.clear();
+            return false;
+        }
+        sessions_.push_back(std::move(simulation));
+    }
+
+    if (sessions_.empty()) {
+        return false;
+    }
+
+    const TileMap& map = sessions_.front()->GetMap();
+    layout_ = PacmenObservationLayout{};
+    layout_.width = map.GetWidth();
+    layout_.height = map.GetHeight();
+    layout_.words_per_row = map.GetWordsPerRow();
+    layout_.ghost_capacity = static_cast<size_t>(std::max(0, config.ghostCount));
+    layout_.ghosts_offset = sizeof(PacmenObservationHeader);
+    layout_.pellets_offset = AlignUp(layout_.ghosts_offset + layout_.ghost_capacity * 2 * sizeof(float), 8);
+    layout_.stride = layout_.pellets_offset
+        + static_cast<size_t>(layout_.words_per_row) * layout_.height * sizeof(uint64_t);
+
+    if (config.threadCount > 1) {
+        // A few chunks per thread lets whoever finishes first take up the
+        // slack of uneven sessions.
+        const size_t chunkCount = std::min(sessions_.size(), static_cast<size_t>(config.threadCount) * 4);
+        chunks_.assign(chunkCount, Chunk{});
+        for (size_t i = 0; i < chunkCount; ++i) {
+            chunks_[i].begin = sessions_.size() * i / chunkCount;
+            chunks_[i].end = sessions_.size() * (i + 1) / chunkCount;
+        }
+        StartWorkers(config.threadCount - 1);
+    }
+
+    return true;
+}
+
+const uint64_t* BatchEnv::GetWalls() const {
+    return sessions_.empty() ? nullptr : sessions_.front()->GetMap().GetWallWords();
+}
+
+void BatchEnv::Reset(void* observations) {
+    uint8_t* out = static_cast<uint8_t*>(observations);
+    for (size_t i = 0; i < sessions_.size(); ++i) {
+        sessions_[i]->StartMatch();
+        WriteObservation(*sessions_[i], 0.0f, false, out + i * layout_.stride);
+    }
+}
+
+void BatchEnv::Step(const uint8_t* actions, void* observations) {
+    uint8_t* out = static_cast<uint8_t*>(observations);
+    if (workers_.empty()) {
+        StepRange(0, sessions_.size(), actions, out);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stepActions_ = actions;
+        stepObservations_ = out;
+        nextChunk_.store(0, std::memory_order_relaxed);
+        busyWorkers_ = workers_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+    StepChunks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busyWorkers_ == 0; });
+}
+
+void BatchEnv::StartWorkers(int count) {
+    stopping_ = false;
+    for (int i = 0; i < count; ++i) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+void BatchEnv::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void BatchEnv::WorkerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+        StepChunks();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busyWorkers_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+void BatchEnv::StepChunks() {
+    for (size_t i = nextChunk_.fetch_add(1, std::memory_order_relaxed); i < chunks_.size();
+         i = nextChunk_.fetch_add(1, std::memory_order_relaxed)) {
+        StepRange(chunks_[i].begin, chunks_[i].end, stepActions_, stepObservations_);
+    }
+}
+
+void BatchEnv::StepRange(size_t begin, size_t end, const uint8_t* actions, uint8_t* observations) {
+    for (size_t i = begin; i < end; ++i) {
+        Simulation& simulation = *sessions_[i];
+
+        InputFrame frame{};
+        frame.player1Direction = DecodeAction(actions[i * 2]);
+        frame.player2Direction = DecodeAction(actions[i * 2 + 1]);
+
+        const int scoreBefore = TotalScore(simulation);
+        simulation.Update(frame, deltaSeconds_);
+        const GameState state = simulation.GetState();
+        const bool done = state == GameState::GameOver || state == GameState::Win;
+
+        WriteObservation(simulation, static_cast<float>(TotalScore(simulation) - scoreBefore), done,
+                         observations + i * layout_.stride);
+        if (done) {
+            simulation.StartMatch();
+        }
+    }
+}
+
+void BatchEnv::WriteObservation(const Simulation& simulation, float reward, bool done, uint8_t* out) const {
+    const Player& playerA = simulation.GetPlayerA();
+    const Player& playerB = simulation.GetPlayerB();
+    const GhostArray& ghosts = simulation.GetGhosts();
+    const TileMap& map = simulation.GetMap();
+
+    PacmenObservationHeader header{};
+    header.state = static_cast<int32_t>(simulation.GetState());
+    header.done = done ? 1 : 0;
+    header.remaining_pellets = map.GetRemainingPellets();
+    header.ghost_count = static_cast<int32_t>(std::min(ghosts.Size(), layout_.ghost_capacity));
+    header.reward = reward;
+    header.player_x[0] = playerA.position.x;
+    header.player_y[0] = playerA.position.y;
+    header.player_x[1] = playerB.position.x;
+    header.player_y[1] = playerB.position.y;
+    header.score[0] = playerA.score;
+    header.score[1] = playerB.score;
+    header.lives[0] = playerA.lives;
+    header.lives[1] = playerB.lives;
+    header.invulnerable_seconds[0] = playerA.invulnerableSeconds;
+    header.invulnerable_seconds[1] = playerB.invulnerableSeconds;
+    std::memcpy(out, &header, sizeof(header));
+
+    float* ghostOut = reinterpret_cast<float*>(out + layout_.ghosts_offset);
+    const size_t count = static_cast<size_t>(header.ghost_count);
+    for (size_t g = 0; g < count; ++g) {
+        ghostOut[g * 2] = ghosts.positionX[g];
+        ghostOut[g * 2 + 1] = ghosts.positionY[g];
+    }
+    std::fill(ghostOut + count * 2, ghostOut + layout_.ghost_capacity * 2, 0.0f);
+
+    std::memcpy(out + layout_.pellets_offset, map.GetPelletWords(),
+                static_cast<size_t>(layout_.words_per_row) * layout_.height * sizeof(uint64_t));
+}
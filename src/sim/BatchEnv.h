@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sim/PacmenEnv.h"
+#include "sim/Simulation.h"
+
+// Steps many sessions in lockstep for agent training. Each step decodes one
+// action byte per player, advances every session one fixed tick and writes
+// its observation straight into the caller's buffer at a fixed stride (see
+// PacmenEnv.h for the record layout). Once every session has started a
+// match, steps allocate nothing, restarts included, and copy nothing beyond
+// the observation itself.
+class BatchEnv {
+public:
+    struct Config {
+        std::string mapPath = "builtin:level1";
+        int sessionCount = 1;
+        int ghostCount = 6;
+        float deltaSeconds = 1.0f / 60.0f;
+        // Above 1, sessions are split into chunks stepped on this many
+        // threads, the caller's included.
+        int threadCount = 1;
+    };
+
+    BatchEnv() = default;
+    ~BatchEnv();
+
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    bool Initialize(const Config& config);
+
+    int GetSessionCount() const { return static_cast<int>(sessions_.size()); }
+    const PacmenObservationLayout& GetLayout() const { return layout_; }
+    // Shared by every session; valid as long as the environment lives.
+    const uint64_t* GetWalls() const;
+
+    void Reset(void* observations);
+    void Step(const uint8_t* actions, void* observations);
+
+private:
+    struct Chunk {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void StartWorkers(int count);
+    void StopWorkers();
+    void WorkerLoop();
+    // Steps chunks until none are left unclaimed.
+    void StepChunks();
+    void StepRange(size_t begin, size_t end, const uint8_t* actions, uint8_t* observations);
+    void WriteObservation(const Simulation& simulation, float reward, bool done, uint8_t* out) const;
+
+    std::vector<std::unique_ptr<Simulation>> sessions_{};
+    std::vector<Chunk> chunks_{};
+    PacmenObservationLayout layout_{};
+    float deltaSeconds_ = 1.0f / 60.0f;
+
+    // A fixed parallel-for rather than a task queue, so a step hands out
+    // work without allocating: the workers wake on a new generation, claim
+    // chunks by bumping nextChunk_, and the last one to finish wakes the
+    // caller. The step's arguments are set under mutex_ before waking them.
+    std::vector<std::thread> workers_{};
+    std::mutex mutex_{};
+    std::condition_variable wake_{};
+    std::condition_variable done_{};
+    uint64_t generation_ = 0;
+    size_t busyWorkers_ = 0;
+    bool stopping_ = false;
+    std::atomic<size_t> nextChunk_{ 0 };
+    const uint8_t* stepActions_ = nullptr;
+    uint8_t* stepObservations_ = nullptr;
+};
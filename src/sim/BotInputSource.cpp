@@ -0,0 +1,42 @@
+#include "sim/BotInputSource.h"
+
+namespace {
+    const Vector2 kDirections[5] = {
+        { 0.0f, 0.0f },
+        { -1.0f, 0.0f },
+        { 0.0f, -1.0f },
+        { 1.0f, 0.0f },
+        { 0.0f, 1.0f }
+    };
+}
+
+BotInputSource::BotInputSource(uint64_t seed)
+    : state_(seed ? seed : 0x9E3779B97F4A7C15ull) {
+}
+
+InputFrame BotInputSource::Poll() {
+    InputFrame frame{};
+    Advance(bot1_);
+    Advance(bot2_);
+    frame.player1Direction = bot1_.direction;
+    frame.player2Direction = bot2_.direction;
+    return frame;
+}
+
+void BotInputSource::Advance(Bot& bot) {
+    if (bot.ticksLeft > 0) {
+        --bot.ticksLeft;
+        return;
+    }
+
+    bot.direction = kDirections[NextRandom() % 5];
+    bot.ticksLeft = 10 + static_cast<int>(NextRandom() % 50);
+}
+
+uint32_t BotInputSource::NextRandom() {
+    // xorshift64*: cheap, and identical on every platform for a given seed.
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return static_cast<uint32_t>((state_ * 0x2545F4914F6CDD1Dull) >> 32);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sim/InputSource.h"
+
+// Deterministic stand-in for two players: each bot holds a random cardinal
+// direction for a random number of ticks, then picks a new one.
+class BotInputSource : public InputSource {
+public:
+    explicit BotInputSource(uint64_t seed);
+
+    InputFrame Poll() override;
+
+private:
+    struct Bot {
+        Vector2 direction{ 0.0f, 0.0f };
+        int ticksLeft = 0;
+    };
+
+    void Advance(Bot& bot);
+    uint32_t NextRandom();
+
+    uint64_t state_;
+    Bot bot1_{};
+    Bot bot2_{};
+};
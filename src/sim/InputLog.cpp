@@ -0,0 +1,394 @@
+#include "sim/InputLog.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+// Layout, all integers little-endian:
+//   "PMRL", u8 version
+//   varint tilePixelSize, varint ghostCount, varint length + bytes of map path
+//   [version 2+] varint ghost schedule, varint near/mid tiles, varint
+//                mid/far interval, varint decision budget
+//   [version 3+] varint ghost targeting
+//   [version 4+] varint ghost spawn separation, varint distance from players
+//   runs: varint repeat (0 ends the list), u8 directions, u8 flags,
+//         [f32 dt if kChangedDelta], [2 x f32 per raw direction]
+//   varint tick count, u64 final state hash
+
+namespace {
+    constexpr char kMagic[4] = { 'P', 'M', 'R', 'L' };
+    constexpr uint8_t kVersion = 4;
+
+    constexpr uint8_t kRawDirection = 15;
+    constexpr uint8_t kStartPressed = 1;
+    constexpr uint8_t kResetPressed = 2;
+    constexpr uint8_t kChangedDelta = 4;
+
+    // Index (dy + 1) * 3 + (dx + 1), normalised exactly as Input does it.
+    struct DirectionTable {
+        Vector2 directions[9];
+
+        DirectionTable() {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    Vector2 value{ static_cast<float>(dx), static_cast<float>(dy) };
+                    const float length = std::sqrt(value.x * value.x + value.y * value.y);
+                    if (length > 0.0f) {
+                        value = { value.x / length, value.y / length };
+                    }
+                    directions[(dy + 1) * 3 + (dx + 1)] = value;
+                }
+            }
+        }
+    };
+
+    const DirectionTable& Directions() {
+        static const DirectionTable table;
+        return table;
+    }
+
+    bool SameBits(float a, float b) {
+        return std::memcmp(&a, &b, sizeof(float)) == 0;
+    }
+
+    bool SameFrame(const InputFrame& a, const InputFrame& b) {
+        return SameBits(a.player1Direction.x, b.player1Direction.x)
+            && SameBits(a.player1Direction.y, b.player1Direction.y)
+            && SameBits(a.player2Direction.x, b.player2Direction.x)
+            && SameBits(a.player2Direction.y, b.player2Direction.y)
+            && a.startPressed == b.startPressed
+            && a.resetPressed == b.resetPressed;
+    }
+
+    uint8_t EncodeDirection(Vector2 direction) {
+        const DirectionTable& table = Directions();
+        for (uint8_t code = 0; code < 9; ++code) {
+            if (SameBits(direction.x, table.directions[code].x) &&
+                SameBits(direction.y, table.directions[code].y)) {
+                return code;
+            }
+        }
+        return kRawDirection;
+    }
+
+    void WriteVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void WriteU32(std::vector<uint8_t>& out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void WriteU64(std::vector<uint8_t>& out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void WriteFloat(std::vector<uint8_t>& out, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        WriteU32(out, bits);
+    }
+
+    // Bounds-checked reader; any read past the end latches `ok` to false.
+    struct Reader {
+        const std::vector<uint8_t>& bytes;
+        size_t& cursor;
+        bool ok = true;
+
+        uint8_t U8() {
+            if (cursor >= bytes.size()) {
+                ok = false;
+                return 0;
+            }
+            return bytes[cursor++];
+        }
+
+        uint64_t Varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                const uint8_t byte = U8();
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            ok = false;
+            return 0;
+        }
+
+        uint64_t U64() {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value |= static_cast<uint64_t>(U8()) << (i * 8);
+            }
+            return value;
+        }
+
+        float Float() {
+            uint32_t bits = 0;
+            for (int i = 0; i < 4; ++i) {
+                bits |= static_cast<uint32_t>(U8()) << (i * 8);
+            }
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        Vector2 Direction(uint8_t code) {
+            if (code == kRawDirection) {
+                const float x = Float();
+                const float y = Float();
+                return { x, y };
+            }
+            if (code >= 9) {
+                ok = false;
+                return { 0.0f, 0.0f };
+            }
+            return Directions().directions[code];
+        }
+    };
+}
+
+void InputRecorder::Begin(const InputLogHeader& header) {
+    header_ = header;
+    bytes_.clear();
+    runLength_ = 0;
+    tickCount_ = 0;
+    lastDeltaSeconds_ = 0.0f;
+}
+
+void InputRecorder::Record(const InputFrame& frame, float deltaSeconds) {
+    if (runLength_ > 0 && SameFrame(frame, runFrame_) && SameBits(deltaSeconds, runDeltaSeconds_)) {
+        ++runLength_;
+    } else {
+        FlushRun();
+        runFrame_ = frame;
+        runDeltaSeconds_ = deltaSeconds;
+        runLength_ = 1;
+    }
+    ++tickCount_;
+}
+
+void InputRecorder::FlushRun() {
+    if (runLength_ == 0) {
+        return;
+    }
+
+    const uint8_t code1 = EncodeDirection(runFrame_.player1Direction);
+    const uint8_t code2 = EncodeDirection(runFrame_.player2Direction);
+    const bool changedDelta = !SameBits(runDeltaSeconds_, lastDeltaSeconds_);
+
+    uint8_t flags = 0;
+    flags |= runFrame_.startPressed ? kStartPressed : 0;
+    flags |= runFrame_.resetPressed ? kResetPressed : 0;
+    flags |= changedDelta ? kChangedDelta : 0;
+
+    WriteVarint(bytes_, runLength_);
+    bytes_.push_back(static_cast<uint8_t>(code1 | (code2 << 4)));
+    bytes_.push_back(flags);
+    if (changedDelta) {
+        WriteFloat(bytes_, runDeltaSeconds_);
+        lastDeltaSeconds_ = runDeltaSeconds_;
+    }
+    if (code1 == kRawDirection) {
+        WriteFloat(bytes_, runFrame_.player1Direction.x);
+        WriteFloat(bytes_, runFrame_.player1Direction.y);
+    }
+    if (code2 == kRawDirection) {
+        WriteFloat(bytes_, runFrame_.player2Direction.x);
+        WriteFloat(bytes_, runFrame_.player2Direction.y);
+    }
+
+    runLength_ = 0;
+}
+
+bool InputRecorder::Save(const std::string& path, uint64_t finalStateHash) {
+    std::vector<uint8_t> out;
+    Serialize(finalStateHash, out);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+void InputRecorder::Serialize(uint64_t finalStateHash, std::vector<uint8_t>& out) {
+    FlushRun();
+
+    out.clear();
+    out.reserve(bytes_.size() + header_.mapPath.size() + 32);
+    out.insert(out.end(), std::begin(kMagic), std::end(kMagic));
+    out.push_back(kVersion);
+    WriteVarint(out, static_cast<uint64_t>(header_.tilePixelSize));
+    WriteVarint(out, static_cast<uint64_t>(header_.ghostCount));
+    WriteVarint(out, header_.mapPath.size());
+    out.insert(out.end(), header_.mapPath.begin(), header_.mapPath.end());
+    const GhostScheduleRules& rules = header_.ghostScheduleRules;
+    WriteVarint(out, static_cast<uint64_t>(header_.ghostSchedule));
+    WriteVarint(out, static_cast<uint64_t>(rules.nearTiles));
+    WriteVarint(out, static_cast<uint64_t>(rules.midTiles));
+    WriteVarint(out, static_cast<uint64_t>(rules.midInterval));
+    WriteVarint(out, static_cast<uint64_t>(rules.farInterval));
+    WriteVarint(out, static_cast<uint64_t>(rules.decisionBudget));
+    WriteVarint(out, static_cast<uint64_t>(header_.ghostTargeting));
+    WriteVarint(out, static_cast<uint64_t>(header_.ghostSpawnRules.minSeparation));
+    WriteVarint(out, static_cast<uint64_t>(header_.ghostSpawnRules.minDistanceFromPlayers));
+    out.insert(out.end(), bytes_.begin(), bytes_.end());
+    WriteVarint(out, 0);
+    WriteVarint(out, tickCount_);
+    WriteU64(out, finalStateHash);
+}
+
+bool InputLog::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    bytes_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return Parse();
+}
+
+bool InputLog::LoadFromBytes(std::vector<uint8_t> bytes) {
+    bytes_ = std::move(bytes);
+    return Parse();
+}
+
+bool InputLog::Parse() {
+    size_t cursor = 0;
+    Reader reader{ bytes_, cursor };
+    for (char expected : kMagic) {
+        if (reader.U8() != static_cast<uint8_t>(expected)) {
+            return false;
+        }
+    }
+    // Older versions predate the fields they lack, which then take the
+    // behaviour of the time: every ghost deciding every tick, all chasing,
+    // default spawn placement.
+    const uint8_t version = reader.U8();
+    if (version < 1 || version > kVersion) {
+        return false;
+    }
+
+    header_.tilePixelSize = static_cast<int>(reader.Varint());
+    header_.ghostCount = static_cast<int>(reader.Varint());
+    const uint64_t pathLength = reader.Varint();
+    if (!reader.ok || pathLength > bytes_.size() - cursor) {
+        return false;
+    }
+    header_.mapPath.assign(reinterpret_cast<const char*>(bytes_.data() + cursor), pathLength);
+    cursor += pathLength;
+
+    header_.ghostSchedule = GhostSchedule::Full;
+    header_.ghostScheduleRules = {};
+    if (version >= 2) {
+        GhostScheduleRules& rules = header_.ghostScheduleRules;
+        const uint64_t schedule = reader.Varint();
+        rules.nearTiles = static_cast<int>(reader.Varint());
+        rules.midTiles = static_cast<int>(reader.Varint());
+        rules.midInterval = static_cast<int>(reader.Varint());
+        rules.farInterval = static_cast<int>(reader.Varint());
+        rules.decisionBudget = static_cast<int>(reader.Varint());
+        if (!reader.ok || schedule > static_cast<uint64_t>(GhostSchedule::Budgeted)) {
+            return false;
+        }
+        header_.ghostSchedule = static_cast<GhostSchedule>(schedule);
+    }
+    header_.ghostTargeting = GhostTargeting::ChaseOnly;
+    if (version >= 3) {
+        const uint64_t targeting = reader.Varint();
+        if (!reader.ok || targeting > static_cast<uint64_t>(GhostTargeting::Mixed)) {
+            return false;
+        }
+        header_.ghostTargeting = static_cast<GhostTargeting>(targeting);
+    }
+    header_.ghostSpawnRules = {};
+    if (version >= 4) {
+        header_.ghostSpawnRules.minSeparation = static_cast<int>(reader.Varint());
+        header_.ghostSpawnRules.minDistanceFromPlayers = static_cast<int>(reader.Varint());
+        if (!reader.ok) {
+            return false;
+        }
+    }
+    recordsBegin_ = cursor;
+
+    // Skip over the runs to reach the trailer.
+    cursor_ = recordsBegin_;
+    runDeltaSeconds_ = 0.0f;
+    while (ReadRun()) {
+    }
+    if (cursor_ == 0) {
+        return false;
+    }
+
+    Reader trailer{ bytes_, cursor_ };
+    tickCount_ = trailer.Varint();
+    finalStateHash_ = trailer.U64();
+    if (!trailer.ok) {
+        return false;
+    }
+
+    Rewind();
+    return true;
+}
+
+bool InputLog::Next(InputFrame& frame, float& deltaSeconds) {
+    if (runRemaining_ == 0 && !ReadRun()) {
+        return false;
+    }
+
+    --runRemaining_;
+    frame = runFrame_;
+    deltaSeconds = runDeltaSeconds_;
+    return true;
+}
+
+void InputLog::Rewind() {
+    cursor_ = recordsBegin_;
+    runRemaining_ = 0;
+    runDeltaSeconds_ = 0.0f;
+}
+
+// Decodes the run at cursor_. Returns false at the end marker, or on a
+// corrupt log, in which case cursor_ is reset to 0.
+bool InputLog::ReadRun() {
+    Reader reader{ bytes_, cursor_ };
+    const uint64_t repeat = reader.Varint();
+    if (!reader.ok || repeat == 0) {
+        if (!reader.ok) {
+            cursor_ = 0;
+        }
+        return false;
+    }
+
+    const uint8_t codes = reader.U8();
+    const uint8_t flags = reader.U8();
+    if (flags & kChangedDelta) {
+        runDeltaSeconds_ = reader.Float();
+    }
+
+    InputFrame frame{};
+    frame.player1Direction = reader.Direction(codes & 0x0F);
+    frame.player2Direction = reader.Direction(codes >> 4);
+    frame.startPressed = (flags & kStartPressed) != 0;
+    frame.resetPressed = (flags & kResetPressed) != 0;
+    if (!reader.ok) {
+        cursor_ = 0;
+        return false;
+    }
+
+    runFrame_ = frame;
+    runRemaining_ = repeat;
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "entities/Ghost.h"
+#include "sim/InputSource.h"
+#include "systems/GhostScheduler.h"
+#include "systems/SpawnPlacer.h"
+
+// What a replay needs, besides the inputs, to rebuild the recorded session.
+struct InputLogHeader {
+    std::string mapPath;
+    int tilePixelSize = 24;
+    int ghostCount = 6;
+    GhostSchedule ghostSchedule = GhostSchedule::Full;
+    GhostScheduleRules ghostScheduleRules{};
+    GhostTargeting ghostTargeting = GhostTargeting::ChaseOnly;
+    // Where ghosts the map has no spawn for are placed.
+    SpawnPlacementRules ghostSpawnRules{};
+};
+
+// Records one InputFrame and step size per simulation tick in a compact
+// binary log. Consecutive identical ticks collapse into a single run, and
+// keyboard directions (the eight normalised compass vectors and zero) take
+// four bits each, so a held key costs a few bytes no matter how long it is
+// held. Any other direction is stored as raw floats.
+class InputRecorder {
+public:
+    void Begin(const InputLogHeader& header);
+    void Record(const InputFrame& frame, float deltaSeconds);
+    // Writes the log with the state hash the replay must reproduce.
+    bool Save(const std::string& path, uint64_t finalStateHash);
+    // The bytes Save writes, for replaying without a file.
+    void Serialize(uint64_t finalStateHash, std::vector<uint8_t>& out);
+
+    uint64_t GetTickCount() const { return tickCount_; }
+
+private:
+    void FlushRun();
+
+    InputLogHeader header_{};
+    std::vector<uint8_t> bytes_{};
+    InputFrame runFrame_{};
+    float runDeltaSeconds_ = 0.0f;
+    float lastDeltaSeconds_ = 0.0f;
+    uint64_t runLength_ = 0;
+    uint64_t tickCount_ = 0;
+};
+
+// Reads a log written by InputRecorder and plays its ticks back in order.
+class InputLog {
+public:
+    bool Load(const std::string& path);
+    // Takes the contents of a log file, e.g. from InputRecorder::Serialize.
+    bool LoadFromBytes(std::vector<uint8_t> bytes);
+
+    const InputLogHeader& GetHeader() const { return header_; }
+    uint64_t GetTickCount() const { return tickCount_; }
+    uint64_t GetFinalStateHash() const { return finalStateHash_; }
+
+    // Produces the next recorded tick; false once every tick has been read.
+    bool Next(InputFrame& frame, float& deltaSeconds);
+    void Rewind();
+
+private:
+    bool ReadRun();
+    bool Parse();
+
+    InputLogHeader header_{};
+    std::vector<uint8_t> bytes_{};
+    size_t recordsBegin_ = 0;
+    size_t cursor_ = 0;
+    InputFrame runFrame_{};
+    float runDeltaSeconds_ = 0.0f;
+    uint64_t runRemaining_ = 0;
+    uint64_t tickCount_ = 0;
+    uint64_t finalStateHash_ = 0;
+};
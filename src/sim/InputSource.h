@@ -0,0 +1,19 @@
+#pragma once
+
+#include "raylib.h"
+
+// Everything the simulation needs from the outside world for one tick.
+struct InputFrame {
+    Vector2 player1Direction{ 0.0f, 0.0f };
+    Vector2 player2Direction{ 0.0f, 0.0f };
+    bool startPressed = false;
+    bool resetPressed = false;
+};
+
+// Supplies one InputFrame per tick. The windowed game samples the keyboard,
+// headless runs plug in scripted or bot sources instead.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+    virtual InputFrame Poll() = 0;
+};
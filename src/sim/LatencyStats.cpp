@@ -0,0 +1,40 @@
+#include "sim/LatencyStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+LatencyStats::LatencyStats(size_t capacity)
+    : samples_(std::max<size_t>(capacity, 1)) {
+}
+
+void LatencyStats::Add(int64_t nanoseconds) {
+    samples_[next_] = nanoseconds;
+    next_ = (next_ + 1) % samples_.size();
+    count_ = std::min(count_ + 1, samples_.size());
+    ++total_;
+}
+
+void LatencyStats::Clear() {
+    next_ = 0;
+    count_ = 0;
+    total_ = 0;
+}
+
+int64_t LatencyStats::Percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    std::vector<int64_t> sorted(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(count_));
+    const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(count_ - 1);
+    const auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(std::lround(rank));
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+int64_t LatencyStats::Max() const {
+    if (count_ == 0) {
+        return 0;
+    }
+    return *std::max_element(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(count_));
+}
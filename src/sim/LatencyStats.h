@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Keeps the most recent latency samples in a fixed ring and reports
+// percentiles over them on demand. Adding a sample never allocates.
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity = 4096);
+
+    void Add(int64_t nanoseconds);
+    void Clear();
+
+    size_t GetSampleCount() const { return count_; }
+    uint64_t GetTotalCount() const { return total_; }
+    // p in [0, 100]; 0 when there are no samples.
+    int64_t Percentile(double p) const;
+    int64_t Max() const;
+
+private:
+    std::vector<int64_t> samples_{};
+    size_t next_ = 0;
+    size_t count_ = 0;
+    uint64_t total_ = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Map with a fixed number of entries that drops the least recently used one
+// to make room. Find and Insert both count as a use. Pointers and references
+// to values stay valid until that entry is evicted or erased.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity = 1024)
+        : capacity_(capacity > 0 ? capacity : 1) {
+    }
+
+    void SetCapacity(size_t capacity) {
+        capacity_ = capacity > 0 ? capacity : 1;
+        while (entries_.size() > capacity_) {
+            EvictOldest();
+        }
+    }
+    size_t GetCapacity() const { return capacity_; }
+    size_t Size() const { return entries_.size(); }
+
+    Value* Find(const Key& key) {
+        const auto found = index_.find(key);
+        if (found == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return &found->second->second;
+    }
+
+    // Replaces any value already stored under key.
+    Value& Insert(const Key& key, Value value) {
+        const auto found = index_.find(key);
+        if (found != index_.end()) {
+            found->second->second = std::move(value);
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return found->second->second;
+        }
+
+        if (entries_.size() >= capacity_) {
+            EvictOldest();
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_.emplace(key, entries_.begin());
+        return entries_.front().second;
+    }
+
+    // Erases every entry for which predicate(key, value) holds.
+    template <typename Predicate>
+    size_t EraseIf(Predicate predicate) {
+        size_t erased = 0;
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (predicate(it->first, it->second)) {
+                index_.erase(it->first);
+                it = entries_.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
+        return erased;
+    }
+
+    void Clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    void EvictOldest() {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+
+    // Most recently used first.
+    std::list<Entry> entries_{};
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_{};
+    size_t capacity_;
+};
@@ -0,0 +1,357 @@
+#include "sim/MazeGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "sim/Profiler.h"
+#include "sim/ThreadPool.h"
+
+namespace {
+    constexpr int kMinSize = 5;
+    constexpr int kMaxSize = 8192;
+
+    uint64_t SplitMix(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // xorshift64*, as the bots use: identical on every platform for a given seed.
+    struct Rng {
+        uint64_t state;
+
+        explicit Rng(uint64_t seed) : state(SplitMix(seed) | 1) {}
+
+        uint32_t Next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+        }
+    };
+
+    // A fixed draw in [0, 1) for one tile, the same whichever task asks.
+    double TileChance(uint64_t seed, int x, int y) {
+        const uint64_t key = SplitMix(seed ^ 0x6C6F6F70ull) ^ (static_cast<uint64_t>(x) << 32 | static_cast<uint32_t>(y));
+        return static_cast<double>(SplitMix(key) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    constexpr int kDx[4] = { 1, 0, -1, 0 };
+    constexpr int kDy[4] = { 0, 1, 0, -1 };
+
+    struct Layout {
+        int width = 0;
+        int height = 0;
+        // Cells sit on odd tiles: cell (i, j) is tile (2i + 1, 2j + 1).
+        int cellsX = 0;
+        int cellsY = 0;
+        int regionCells = 0;
+        int regionsX = 0;
+        int regionsY = 0;
+
+        size_t TileIndex(int x, int y) const { return static_cast<size_t>(y) * width + x; }
+        size_t CellTile(int i, int j) const { return TileIndex(2 * i + 1, 2 * j + 1); }
+        // The wall tile between cell (i, j) and its neighbour in direction d.
+        size_t WallTile(int i, int j, int d) const { return TileIndex(2 * i + 1 + kDx[d], 2 * j + 1 + kDy[d]); }
+    };
+
+    struct Region {
+        int cellX = 0;
+        int cellY = 0;
+        int cellsX = 0;
+        int cellsY = 0;
+        // Cells that must stay open: door ends and player spawns.
+        std::vector<uint32_t> keep{};
+    };
+
+    // Perfect maze over the region's cells by randomised depth-first search,
+    // then dead ends filled back in down to the density, then loops.
+    void CarveRegion(const MazeSettings& settings, const Layout& layout, const Region& region, uint64_t regionSeed,
+                     std::vector<char>& tiles) {
+        PACMEN_PROFILE_ZONE("MazeGenerator::CarveRegion");
+        const int w = region.cellsX;
+        const int h = region.cellsY;
+        const size_t cellCount = static_cast<size_t>(w) * h;
+        auto tileOf = [&](size_t cell) {
+            return layout.CellTile(region.cellX + static_cast<int>(cell % w), region.cellY + static_cast<int>(cell / w));
+        };
+        auto wallOf = [&](size_t cell, int d) {
+            return layout.WallTile(region.cellX + static_cast<int>(cell % w), region.cellY + static_cast<int>(cell / w), d);
+        };
+        auto neighbour = [&](size_t cell, int d, size_t& next) {
+            const int x = static_cast<int>(cell % w) + kDx[d];
+            const int y = static_cast<int>(cell / w) + kDy[d];
+            if (x < 0 || y < 0 || x >= w || y >= h) {
+                return false;
+            }
+            next = static_cast<size_t>(y) * w + x;
+            return true;
+        };
+
+        Rng rng(regionSeed);
+        std::vector<uint8_t> degree(cellCount, 0);
+        std::vector<uint8_t> visited(cellCount, 0);
+        std::vector<uint32_t> stack;
+        stack.reserve(cellCount);
+        visited[0] = 1;
+        tiles[tileOf(0)] = '.';
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const size_t cell = stack.back();
+            int options[4];
+            int optionCount = 0;
+            for (int d = 0; d < 4; ++d) {
+                size_t next;
+                if (neighbour(cell, d, next) && !visited[next]) {
+                    options[optionCount++] = d;
+                }
+            }
+            if (optionCount == 0) {
+                stack.pop_back();
+                continue;
+            }
+            const int d = options[rng.Next() % static_cast<uint32_t>(optionCount)];
+            size_t next = 0;
+            neighbour(cell, d, next);
+            visited[next] = 1;
+            tiles[wallOf(cell, d)] = '.';
+            tiles[tileOf(next)] = '.';
+            ++degree[cell];
+            ++degree[next];
+            stack.push_back(static_cast<uint32_t>(next));
+        }
+
+        // Fill dead ends back in, in a shuffled order, until only the
+        // density's share of cells is left. Kept cells are never filled, so
+        // doors and spawns stay joined.
+        std::vector<uint8_t>& keep = visited;
+        std::fill(keep.begin(), keep.end(), 0);
+        for (const uint32_t cell : region.keep) {
+            keep[cell] = 1;
+        }
+        const size_t target = static_cast<size_t>(std::ceil(std::clamp(settings.density, 0.0f, 1.0f) * cellCount));
+        size_t openCells = cellCount;
+        if (openCells > target) {
+            std::vector<uint32_t>& queue = stack;
+            for (size_t cell = 0; cell < cellCount; ++cell) {
+                if (degree[cell] == 1 && !keep[cell]) {
+                    queue.push_back(static_cast<uint32_t>(cell));
+                }
+            }
+            for (size_t i = queue.size(); i > 1; --i) {
+                std::swap(queue[i - 1], queue[rng.Next() % i]);
+            }
+            for (size_t head = 0; head < queue.size() && openCells > target; ++head) {
+                const size_t cell = queue[head];
+                if (degree[cell] != 1 || keep[cell]) {
+                    continue;
+                }
+                for (int d = 0; d < 4; ++d) {
+                    size_t next;
+                    if (neighbour(cell, d, next) && tiles[wallOf(cell, d)] == '.') {
+                        tiles[wallOf(cell, d)] = '#';
+                        degree[cell] = 0;
+                        if (--degree[next] == 1 && !keep[next]) {
+                            queue.push_back(static_cast<uint32_t>(next));
+                        }
+                        break;
+                    }
+                }
+                tiles[tileOf(cell)] = '#';
+                --openCells;
+            }
+        }
+
+        // Loops inside the region; walls on its right and bottom edges are
+        // handled once every region is carved.
+        if (settings.loopRate > 0.0f) {
+            for (size_t cell = 0; cell < cellCount; ++cell) {
+                for (int d = 0; d < 2; ++d) {
+                    size_t next;
+                    const size_t wall = wallOf(cell, d);
+                    if (neighbour(cell, d, next) && tiles[wall] == '#' && tiles[tileOf(cell)] == '.'
+                        && tiles[tileOf(next)] == '.'
+                        && TileChance(settings.seed, static_cast<int>(wall % layout.width),
+                                      static_cast<int>(wall / layout.width)) < settings.loopRate) {
+                        tiles[wall] = '.';
+                    }
+                }
+            }
+        }
+    }
+
+    // Knocks through the walls along a region's right and bottom edges
+    // where both sides are open, at the loop rate.
+    void LoopRegionEdges(const MazeSettings& settings, const Layout& layout, const Region& region,
+                         std::vector<char>& tiles) {
+        auto tryOpen = [&](int i, int j, int d) {
+            const int ni = i + kDx[d];
+            const int nj = j + kDy[d];
+            if (ni >= layout.cellsX || nj >= layout.cellsY) {
+                return;
+            }
+            const size_t wall = layout.WallTile(i, j, d);
+            if (tiles[wall] == '#' && tiles[layout.CellTile(i, j)] == '.' && tiles[layout.CellTile(ni, nj)] == '.'
+                && TileChance(settings.seed, static_cast<int>(wall % layout.width),
+                              static_cast<int>(wall / layout.width)) < settings.loopRate) {
+                tiles[wall] = '.';
+            }
+        };
+        const int right = region.cellX + region.cellsX - 1;
+        const int bottom = region.cellY + region.cellsY - 1;
+        for (int j = region.cellY; j <= bottom; ++j) {
+            tryOpen(right, j, 0);
+        }
+        for (int i = region.cellX; i <= right; ++i) {
+            tryOpen(i, bottom, 1);
+        }
+    }
+}
+
+uint64_t Maze::ComputeHash() const {
+    uint64_t hash = 1469598103934665603ull;
+    for (const char tile : tiles) {
+        hash = (hash ^ static_cast<uint8_t>(tile)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool Maze::SaveText(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = true;
+    for (int y = 0; y < height && ok; ++y) {
+        ok = std::fwrite(tiles.data() + static_cast<size_t>(y) * width, 1, static_cast<size_t>(width), file)
+                == static_cast<size_t>(width)
+            && std::fputc('\n', file) != EOF;
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+void GenerateMaze(const MazeSettings& settings, ThreadPool& pool, Maze& out) {
+    PACMEN_PROFILE_ZONE("GenerateMaze");
+    Layout layout;
+    layout.width = std::clamp(settings.width, kMinSize, kMaxSize);
+    layout.height = std::clamp(settings.height, kMinSize, kMaxSize);
+    layout.cellsX = (layout.width - 1) / 2;
+    layout.cellsY = (layout.height - 1) / 2;
+    layout.regionCells = std::clamp(settings.regionCells, 4, 4096);
+    layout.regionsX = (layout.cellsX + layout.regionCells - 1) / layout.regionCells;
+    layout.regionsY = (layout.cellsY + layout.regionCells - 1) / layout.regionCells;
+
+    out.width = layout.width;
+    out.height = layout.height;
+    out.tiles.assign(static_cast<size_t>(layout.width) * layout.height, '#');
+
+    std::vector<Region> regions(static_cast<size_t>(layout.regionsX) * layout.regionsY);
+    for (int ry = 0; ry < layout.regionsY; ++ry) {
+        for (int rx = 0; rx < layout.regionsX; ++rx) {
+            Region& region = regions[static_cast<size_t>(ry) * layout.regionsX + rx];
+            region.cellX = rx * layout.regionCells;
+            region.cellY = ry * layout.regionCells;
+            region.cellsX = std::min(layout.regionCells, layout.cellsX - region.cellX);
+            region.cellsY = std::min(layout.regionCells, layout.cellsY - region.cellY);
+        }
+    }
+    auto keepCell = [&](int i, int j) {
+        Region& region = regions[static_cast<size_t>(j / layout.regionCells) * layout.regionsX + i / layout.regionCells];
+        region.keep.push_back(static_cast<uint32_t>((j - region.cellY) * region.cellsX + (i - region.cellX)));
+    };
+
+    // The regions themselves form a maze: a random spanning tree over the
+    // region grid, with one door on a random cell of each shared edge.
+    struct Door {
+        int i = 0;
+        int j = 0;
+        int direction = 0;
+    };
+    std::vector<Door> doors;
+    {
+        Rng rng(settings.seed);
+        std::vector<uint8_t> visited(regions.size(), 0);
+        std::vector<uint32_t> stack{ 0 };
+        visited[0] = 1;
+        while (!stack.empty()) {
+            const int rx = static_cast<int>(stack.back() % layout.regionsX);
+            const int ry = static_cast<int>(stack.back() / layout.regionsX);
+            int options[4];
+            int optionCount = 0;
+            for (int d = 0; d < 4; ++d) {
+                const int nx = rx + kDx[d];
+                const int ny = ry + kDy[d];
+                if (nx >= 0 && ny >= 0 && nx < layout.regionsX && ny < layout.regionsY
+                    && !visited[static_cast<size_t>(ny) * layout.regionsX + nx]) {
+                    options[optionCount++] = d;
+                }
+            }
+            if (optionCount == 0) {
+                stack.pop_back();
+                continue;
+            }
+            const int d = options[rng.Next() % static_cast<uint32_t>(optionCount)];
+            const Region& from = regions[static_cast<size_t>(ry) * layout.regionsX + rx];
+            const size_t next = static_cast<size_t>(ry + kDy[d]) * layout.regionsX + (rx + kDx[d]);
+            const Region& to = regions[next];
+            // Along the shared edge, on the side of `from`.
+            Door door;
+            door.direction = d;
+            if (kDx[d] != 0) {
+                door.i = kDx[d] > 0 ? from.cellX + from.cellsX - 1 : from.cellX;
+                door.j = from.cellY + static_cast<int>(rng.Next() % static_cast<uint32_t>(std::min(from.cellsY, to.cellsY)));
+            } else {
+                door.i = from.cellX + static_cast<int>(rng.Next() % static_cast<uint32_t>(std::min(from.cellsX, to.cellsX)));
+                door.j = kDy[d] > 0 ? from.cellY + from.cellsY - 1 : from.cellY;
+            }
+            doors.push_back(door);
+            keepCell(door.i, door.j);
+            keepCell(door.i + kDx[d], door.j + kDy[d]);
+            visited[next] = 1;
+            stack.push_back(static_cast<uint32_t>(next));
+        }
+    }
+
+    // Players start side by side in the middle.
+    const int spawnI = layout.cellsX / 2;
+    const int spawnJ = layout.cellsY / 2;
+    const int partnerI = spawnI + 1 < layout.cellsX ? spawnI + 1 : spawnI - 1;
+    keepCell(spawnI, spawnJ);
+    keepCell(partnerI, spawnJ);
+
+    for (size_t r = 0; r < regions.size(); ++r) {
+        pool.Submit([&, r] {
+            CarveRegion(settings, layout, regions[r], settings.seed + 0x9E3779B97F4A7C15ull * (r + 1), out.tiles);
+        });
+    }
+    pool.Wait();
+
+    for (const Door& door : doors) {
+        out.tiles[layout.WallTile(door.i, door.j, door.direction)] = '.';
+    }
+    if (settings.loopRate > 0.0f) {
+        for (size_t r = 0; r < regions.size(); ++r) {
+            pool.Submit([&, r] { LoopRegionEdges(settings, layout, regions[r], out.tiles); });
+        }
+        pool.Wait();
+    }
+
+    out.tiles[layout.CellTile(spawnI, spawnJ)] = 'P';
+    out.tiles[layout.CellTile(partnerI, spawnJ)] = 'Q';
+
+    // Ghosts on random open cells. When the maze is nearly full, give up
+    // after a bounded number of misses rather than scanning for the last ones.
+    Rng rng(settings.seed ^ 0x47686F7374ull);
+    const uint64_t cellCount = static_cast<uint64_t>(layout.cellsX) * layout.cellsY;
+    int placed = 0;
+    for (uint64_t attempt = 0; placed < settings.ghostCount && attempt < 64ull * settings.ghostCount + 1024; ++attempt) {
+        const uint64_t cell = ((static_cast<uint64_t>(rng.Next()) << 32) | rng.Next()) % cellCount;
+        char& tile = out.tiles[layout.CellTile(static_cast<int>(cell % layout.cellsX), static_cast<int>(cell / layout.cellsX))];
+        if (tile == '.') {
+            tile = 'G';
+            ++placed;
+        }
+    }
+}
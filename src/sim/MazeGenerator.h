@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct MazeSettings {
+    // In tiles, border included; clamped to [5, 8192]. Corridors run along
+    // odd rows and columns, so an even size leaves a double wall on the far
+    // side.
+    int width = 255;
+    int height = 255;
+    uint64_t seed = 1;
+    // Share of corridor kept, in (0, 1]. At 1 every cell is reachable and
+    // corridors fill about half the map; lower values fill dead ends back in.
+    float density = 1.0f;
+    // Chance that a wall between two corridors is knocked through. 0 gives a
+    // perfect maze (exactly one route between any two cells).
+    float loopRate = 0.05f;
+    int ghostCount = 4;
+    // Side of the square of cells each parallel task carves.
+    int regionCells = 64;
+};
+
+// Generated map in TileMap's text format: one symbol per tile, row-major.
+struct Maze {
+    int width = 0;
+    int height = 0;
+    std::vector<char> tiles{};
+
+    char At(int x, int y) const { return tiles[static_cast<size_t>(y) * width + x]; }
+    // FNV-1a over the tiles, to compare runs.
+    uint64_t ComputeHash() const;
+    bool SaveText(const std::string& path) const;
+};
+
+// Carves the maze in regions of regionCells x regionCells cells, one task
+// per region on `pool`. Regions are joined by a spanning tree of doors
+// picked up front, and every random choice is seeded from the settings and
+// the region or tile it concerns, so the result does not depend on the
+// number of threads or the order tasks run in.
+void GenerateMaze(const MazeSettings& settings, ThreadPool& pool, Maze& out);
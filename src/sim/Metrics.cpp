@@ -0,0 +1,134 @@
+#include "sim/Metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    // Bucket bounds exported to Prometheus: 2^14 ns (16 us) to 2^34 ns (17 s).
+    constexpr int kFirstExportedBound = 14;
+    constexpr int kLastExportedBound = 34;
+
+    void AppendFormat(std::string& out, const char* format, auto... args) {
+        char line[256];
+        const int length = std::snprintf(line, sizeof(line), format, args...);
+        if (length > 0) {
+            out.append(line, std::min<size_t>(static_cast<size_t>(length), sizeof(line) - 1));
+        }
+    }
+
+    void WriteHistogram(std::string& out, const char* name, const char* help, const LatencyHistogram& histogram) {
+        LatencyHistogram::Snapshot snapshot;
+        histogram.Read(snapshot);
+
+        AppendFormat(out, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+        for (int bit = kFirstExportedBound; bit <= kLastExportedBound; ++bit) {
+            const int64_t bound = int64_t{ 1 } << bit;
+            AppendFormat(out, "%s_bucket{le=\"%.9g\"} %llu\n", name, bound / 1e9,
+                         static_cast<unsigned long long>(snapshot.CountBelow(bound)));
+        }
+        AppendFormat(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, static_cast<unsigned long long>(snapshot.count));
+        AppendFormat(out, "%s_sum %.9g\n", name, snapshot.sum / 1e9);
+        AppendFormat(out, "%s_count %llu\n", name, static_cast<unsigned long long>(snapshot.count));
+    }
+
+    void WriteCounter(std::string& out, const char* name, const char* help, const std::atomic<uint64_t>& counter) {
+        AppendFormat(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name,
+                     static_cast<unsigned long long>(counter.load(std::memory_order_relaxed)));
+    }
+}
+
+size_t LatencyHistogram::BucketIndex(int64_t nanoseconds) {
+    if (nanoseconds < 2 * kSubBuckets) {
+        return static_cast<size_t>(std::max<int64_t>(nanoseconds, 0));
+    }
+    const uint64_t value = static_cast<uint64_t>(nanoseconds);
+    const int shift = static_cast<int>(std::bit_width(value)) - (kSubBucketBits + 1);
+    const size_t index = static_cast<size_t>(shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+    return std::min(index, kBucketCount - 1);
+}
+
+int64_t LatencyHistogram::BucketLowest(size_t index) {
+    if (index < 2 * kSubBuckets) {
+        return static_cast<int64_t>(index);
+    }
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    return static_cast<int64_t>(index % kSubBuckets + kSubBuckets) << shift;
+}
+
+int64_t LatencyHistogram::BucketHighest(size_t index) {
+    if (index < 2 * kSubBuckets) {
+        return static_cast<int64_t>(index);
+    }
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    return (static_cast<int64_t>(index % kSubBuckets + kSubBuckets + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(int64_t nanoseconds) {
+    counts_[BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(std::max<int64_t>(nanoseconds, 0), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Read(Snapshot& snapshot) const {
+    // Buckets and totals are read separately, so a snapshot taken while
+    // another thread records can be off by the samples recorded meanwhile.
+    // The count is summed from the buckets so percentiles stay consistent.
+    snapshot.count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::Snapshot::Percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    const double clamped = std::clamp(p, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return BucketHighest(i);
+        }
+    }
+    return BucketHighest(kBucketCount - 1);
+}
+
+uint64_t LatencyHistogram::Snapshot::CountBelow(int64_t nanoseconds) const {
+    const size_t end = BucketIndex(nanoseconds);
+    uint64_t below = 0;
+    for (size_t i = 0; i < end; ++i) {
+        below += counts[i];
+    }
+    return below;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::Since(const Snapshot& earlier) const {
+    Snapshot difference;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        difference.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+        difference.count += difference.counts[i];
+    }
+    difference.sum = sum - earlier.sum;
+    return difference;
+}
+
+void WritePrometheusText(const Metrics& metrics, std::string& out) {
+    WriteHistogram(out, "pacmen_frame_seconds", "Time between the starts of consecutive rendered frames.",
+                   metrics.frameTime);
+    WriteHistogram(out, "pacmen_update_seconds", "Time to run one fixed simulation step.", metrics.updateTime);
+    WriteHistogram(out, "pacmen_ghost_update_seconds", "Time spent in GhostSystem::Update per step.",
+                   metrics.ghostUpdateTime);
+    WriteCounter(out, "pacmen_frames_total", "Frames rendered.", metrics.frames);
+    WriteCounter(out, "pacmen_dropped_frames_total", "Display refreshes missed by slow frames.", metrics.droppedFrames);
+    WriteCounter(out, "pacmen_ticks_total", "Simulation steps run.", metrics.ticks);
+    WriteCounter(out, "pacmen_pellets_consumed_total", "Pellets eaten by either player.", metrics.pelletsConsumed);
+    WriteCounter(out, "pacmen_captures_total", "Lives lost to ghosts.", metrics.captures);
+    WriteCounter(out, "pacmen_resets_total", "Matches reset.", metrics.resets);
+}
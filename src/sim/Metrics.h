@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Log-linear latency histogram in the style of HdrHistogram: values below
+// 64 ns are counted exactly, above that every power of two is split into
+// 32 buckets, so any recorded value is known to within about 3% up to
+// about a minute (longer values land in the last bucket). Record is a few
+// relaxed atomic increments, so one thread can record while another reads.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kOctaves = 31;
+    static constexpr size_t kBucketCount = static_cast<size_t>(kSubBuckets) * (kOctaves + 1);
+
+    // A copy of the counts at one moment. Subtracting an older snapshot
+    // gives the histogram of what was recorded in between.
+    struct Snapshot {
+        std::array<uint64_t, kBucketCount> counts{};
+        uint64_t count = 0;
+        int64_t sum = 0;
+
+        // p in [0, 100]; the top of the bucket holding that rank, 0 when empty.
+        int64_t Percentile(double p) const;
+        int64_t Max() const { return Percentile(100.0); }
+        // Values strictly below `nanoseconds`; exact when it is a power of two.
+        uint64_t CountBelow(int64_t nanoseconds) const;
+        Snapshot Since(const Snapshot& earlier) const;
+    };
+
+    void Record(int64_t nanoseconds);
+    void Read(Snapshot& snapshot) const;
+    // Running totals, without copying the buckets.
+    uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+    int64_t GetSum() const { return sum_.load(std::memory_order_relaxed); }
+
+    static size_t BucketIndex(int64_t nanoseconds);
+    static int64_t BucketLowest(size_t index);
+    static int64_t BucketHighest(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<int64_t> sum_{ 0 };
+};
+
+// Always-on counters and timings for long runs. The threads doing the work
+// record into it and MetricsExporter reads it from its own thread; every
+// field is atomic, so neither side locks.
+struct Metrics {
+    // Time between the starts of consecutive rendered frames, stalls included.
+    LatencyHistogram frameTime{};
+    // One fixed simulation step (Game::Update / Simulation::Update).
+    LatencyHistogram updateTime{};
+    LatencyHistogram ghostUpdateTime{};
+
+    std::atomic<uint64_t> frames{ 0 };
+    // Display refreshes missed because a frame took longer than one.
+    std::atomic<uint64_t> droppedFrames{ 0 };
+    std::atomic<uint64_t> ticks{ 0 };
+    std::atomic<uint64_t> pelletsConsumed{ 0 };
+    // Lives lost to ghosts.
+    std::atomic<uint64_t> captures{ 0 };
+    // Matches reset, whether started, restarted or abandoned to the menu.
+    std::atomic<uint64_t> resets{ 0 };
+};
+
+// Appends every metric in Prometheus text exposition format (0.0.4).
+// Histograms are exported with power-of-two bucket bounds from 16 us to
+// 17 s, which fall on bucket edges, so the cumulative counts need no
+// interpolation.
+void WritePrometheusText(const Metrics& metrics, std::string& out);
@@ -0,0 +1,273 @@
+#include "sim/MetricsExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr int kPollMilliseconds = 100;
+    constexpr size_t kMaxRequestBytes = 8192;
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#if defined(_WIN32)
+    using NativeSocket = SOCKET;
+    bool IsValid(NativeSocket socket) { return socket != INVALID_SOCKET; }
+    void CloseNative(NativeSocket socket) { closesocket(socket); }
+    void SetReceiveTimeout(NativeSocket socket, int milliseconds) {
+        const DWORD timeout = static_cast<DWORD>(milliseconds);
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    }
+#else
+    using NativeSocket = int;
+    bool IsValid(NativeSocket socket) { return socket >= 0; }
+    void CloseNative(NativeSocket socket) { close(socket); }
+    void SetReceiveTimeout(NativeSocket socket, int milliseconds) {
+        timeval timeout{};
+        timeout.tv_sec = milliseconds / 1000;
+        timeout.tv_usec = (milliseconds % 1000) * 1000;
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+#endif
+
+    bool SendAll(NativeSocket socket, const std::string& data) {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const int chunk = static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 20));
+            const auto written = send(socket, data.data() + sent, chunk, flags);
+            if (written <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    void AppendPercentiles(std::string& line, const char* name, const LatencyHistogram::Snapshot& snapshot) {
+        char text[160];
+        std::snprintf(text, sizeof(text), " %s_ms=p50:%.3f,p99:%.3f,p999:%.3f,max:%.3f,n:%llu", name,
+                      snapshot.Percentile(50.0) / 1e6, snapshot.Percentile(99.0) / 1e6,
+                      snapshot.Percentile(99.9) / 1e6, snapshot.Max() / 1e6,
+                      static_cast<unsigned long long>(snapshot.count));
+        line += text;
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+bool MetricsExporter::Start(const Metrics& metrics, const MetricsExportOptions& options) {
+    Stop();
+    metrics_ = &metrics;
+    options_ = options;
+    stopping_.store(false, std::memory_order_relaxed);
+    startNs_ = NowNs();
+    lastLogNs_ = startNs_;
+    metrics.frameTime.Read(lastFrame_);
+    metrics.updateTime.Read(lastUpdate_);
+    metrics.ghostUpdateTime.Read(lastGhostUpdate_);
+
+    bool serving = true;
+    if (options_.port > 0) {
+        serving = false;
+#if defined(_WIN32)
+        WSADATA data;
+        const bool started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+        const bool started = true;
+#endif
+        const NativeSocket socket = started ? ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP) : NativeSocket(-1);
+        if (started && IsValid(socket)) {
+            const int reuse = 1;
+            setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(options_.port));
+            // Loopback only: the endpoint is for a local scraper, not the network.
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 &&
+                listen(socket, 8) == 0) {
+                listenSocket_ = static_cast<Socket>(socket);
+                serving = true;
+            } else {
+                CloseNative(socket);
+            }
+        }
+#if defined(_WIN32)
+        if (started && !serving) {
+            WSACleanup();
+        }
+#endif
+    }
+
+    if (listenSocket_ != kNoSocket || !options_.logPath.empty()) {
+        thread_ = std::thread([this] { Run(); });
+    }
+    return serving;
+}
+
+void MetricsExporter::Stop() {
+    if (thread_.joinable()) {
+        stopping_.store(true, std::memory_order_relaxed);
+        thread_.join();
+        if (!options_.logPath.empty()) {
+            WriteLogLine(true);
+        }
+    }
+    if (listenSocket_ != kNoSocket) {
+        CloseNative(static_cast<NativeSocket>(listenSocket_));
+        listenSocket_ = kNoSocket;
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+    }
+}
+
+void MetricsExporter::Run() {
+    const int64_t intervalNs = static_cast<int64_t>(options_.logIntervalSeconds * 1e9);
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (listenSocket_ != kNoSocket) {
+            const NativeSocket socket = static_cast<NativeSocket>(listenSocket_);
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(socket, &readable);
+            timeval timeout{};
+            timeout.tv_usec = kPollMilliseconds * 1000;
+            if (select(static_cast<int>(socket) + 1, &readable, nullptr, nullptr, &timeout) > 0) {
+                ServeOne();
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kPollMilliseconds));
+        }
+
+        if (!options_.logPath.empty() && NowNs() - lastLogNs_ >= intervalNs) {
+            WriteLogLine(false);
+        }
+    }
+}
+
+void MetricsExporter::ServeOne() {
+    const NativeSocket client = accept(static_cast<NativeSocket>(listenSocket_), nullptr, nullptr);
+    if (!IsValid(client)) {
+        return;
+    }
+
+    // One request per connection; a client that stalls is dropped after a
+    // second so it cannot hold up the log.
+    SetReceiveTimeout(client, 1000);
+    std::string request;
+    char buffer[1024];
+    while (request.size() < kMaxRequestBytes && request.find("\r\n\r\n") == std::string::npos) {
+        const auto received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    const bool isMetrics = request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET /metrics?", 0) == 0
+        || request.rfind("GET / ", 0) == 0;
+    std::string body;
+    const char* status = "404 Not Found";
+    const char* contentType = "text/plain; charset=utf-8";
+    if (isMetrics) {
+        WritePrometheusText(*metrics_, body);
+        status = "200 OK";
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+    } else {
+        body = "not found; metrics are at /metrics\n";
+    }
+
+    response_.clear();
+    char header[192];
+    std::snprintf(header, sizeof(header),
+                  "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                  status, contentType, body.size());
+    response_ += header;
+    response_ += body;
+    SendAll(client, response_);
+    CloseNative(client);
+}
+
+void MetricsExporter::WriteLogLine(bool final) {
+    const int64_t now = NowNs();
+    LatencyHistogram::Snapshot frame;
+    LatencyHistogram::Snapshot update;
+    LatencyHistogram::Snapshot ghostUpdate;
+    metrics_->frameTime.Read(frame);
+    metrics_->updateTime.Read(update);
+    metrics_->ghostUpdateTime.Read(ghostUpdate);
+
+    char text[320];
+    std::snprintf(text, sizeof(text),
+                  "uptime_s=%.1f interval_s=%.1f%s ticks=%llu frames=%llu dropped_frames=%llu"
+                  " pellets=%llu captures=%llu resets=%llu",
+                  (now - startNs_) / 1e9, (now - lastLogNs_) / 1e9, final ? " final=1" : "",
+                  static_cast<unsigned long long>(metrics_->ticks.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(metrics_->frames.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(metrics_->droppedFrames.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(metrics_->pelletsConsumed.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(metrics_->captures.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(metrics_->resets.load(std::memory_order_relaxed)));
+    std::string line = text;
+    AppendPercentiles(line, "frame", frame.Since(lastFrame_));
+    AppendPercentiles(line, "update", update.Since(lastUpdate_));
+    AppendPercentiles(line, "ghost_update", ghostUpdate.Since(lastGhostUpdate_));
+    line += '\n';
+
+    lastFrame_ = frame;
+    lastUpdate_ = update;
+    lastGhostUpdate_ = ghostUpdate;
+    lastLogNs_ = now;
+
+    RotateLog();
+    if (std::FILE* file = std::fopen(options_.logPath.c_str(), "ab")) {
+        std::fwrite(line.data(), 1, line.size(), file);
+        std::fclose(file);
+    }
+}
+
+void MetricsExporter::RotateLog() {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    const fs::path path(options_.logPath);
+    const uintmax_t size = fs::file_size(path, error);
+    if (error || size < options_.logMaxBytes) {
+        return;
+    }
+
+    auto numbered = [&](int index) { return fs::path(options_.logPath + "." + std::to_string(index)); };
+    if (options_.logFiles <= 0) {
+        fs::remove(path, error);
+        return;
+    }
+    fs::remove(numbered(options_.logFiles), error);
+    for (int index = options_.logFiles - 1; index >= 1; --index) {
+        fs::rename(numbered(index), numbered(index + 1), error);
+    }
+    fs::rename(path, numbered(1), error);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "sim/Metrics.h"
+
+struct MetricsExportOptions {
+    // What pacmen serves on unless told otherwise.
+    static constexpr int kDefaultPort = 9464;
+
+    // Serves GET /metrics on 127.0.0.1:port; 0 turns the endpoint off.
+    int port = 0;
+    // Appends one summary line per interval when not empty. The line holds
+    // p50/p99/p99.9/max of each histogram over that interval alone, so the
+    // file shows trends without a Prometheus server.
+    std::string logPath{};
+    double logIntervalSeconds = 10.0;
+    // Once the log passes logMaxBytes it becomes logPath.1, the previous .1
+    // becomes .2 and so on; logFiles of them are kept besides the live one.
+    uint64_t logMaxBytes = 8ull << 20;
+    int logFiles = 4;
+};
+
+// Publishes a Metrics from a background thread. The thread only reads the
+// metrics, so whatever records into them is never held up by a scrape.
+class MetricsExporter {
+public:
+    MetricsExporter() = default;
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // False if the port could not be bound; the log, if any, still runs.
+    // `metrics` must outlive Stop.
+    bool Start(const Metrics& metrics, const MetricsExportOptions& options);
+    // Writes a last log line for the partial interval and joins the thread.
+    void Stop();
+
+    bool IsServing() const { return listenSocket_ != kNoSocket; }
+
+private:
+    // Wide enough for a Windows SOCKET as well as a POSIX descriptor.
+    using Socket = intptr_t;
+    static constexpr Socket kNoSocket = -1;
+
+    void Run();
+    void ServeOne();
+    void WriteLogLine(bool final);
+    void RotateLog();
+
+    const Metrics* metrics_ = nullptr;
+    MetricsExportOptions options_{};
+    Socket listenSocket_ = kNoSocket;
+    std::thread thread_{};
+    std::atomic<bool> stopping_{ false };
+
+    // Histograms at the previous log line, to report each interval alone.
+    LatencyHistogram::Snapshot lastFrame_{};
+    LatencyHistogram::Snapshot lastUpdate_{};
+    LatencyHistogram::Snapshot lastGhostUpdate_{};
+    int64_t lastLogNs_ = 0;
+    int64_t startNs_ = 0;
+    std::string response_{};
+};
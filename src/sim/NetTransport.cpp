@@ -0,0 +1,185 @@
+#include "sim/NetTransport.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+    using NativeSocket = SOCKET;
+    bool IsValid(NativeSocket socket) { return socket != INVALID_SOCKET; }
+    void CloseNative(NativeSocket socket) { closesocket(socket); }
+    bool SetNonBlocking(NativeSocket socket) {
+        u_long enabled = 1;
+        return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+    }
+#else
+    using NativeSocket = int;
+    bool IsValid(NativeSocket socket) { return socket >= 0; }
+    void CloseNative(NativeSocket socket) { close(socket); }
+    bool SetNonBlocking(NativeSocket socket) {
+        const int flags = fcntl(socket, F_GETFL, 0);
+        return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+#endif
+
+    // Address and port in network byte order; false if `peer` is not
+    // "host:port" or the host does not resolve to an IPv4 address.
+    bool ResolvePeer(const std::string& peer, uint32_t& address, uint16_t& port) {
+        const size_t colon = peer.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == peer.size()) {
+            return false;
+        }
+        const std::string host = peer.substr(0, colon);
+        const int portNumber = std::atoi(peer.c_str() + colon + 1);
+        if (portNumber <= 0 || portNumber > 65535) {
+            return false;
+        }
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+            return false;
+        }
+        address = reinterpret_cast<const sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+        port = htons(static_cast<uint16_t>(portNumber));
+        freeaddrinfo(result);
+        return true;
+    }
+}
+
+UdpTransport::~UdpTransport() {
+    Close();
+}
+
+bool UdpTransport::Open(int localPort, const std::string& peer) {
+    Close();
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        return false;
+    }
+#endif
+    const NativeSocket socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    bool opened = IsValid(socket) && ResolvePeer(peer, peerAddress_, peerPort_) && SetNonBlocking(socket);
+    if (opened) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(localPort));
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        opened = bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    if (!opened) {
+        if (IsValid(socket)) {
+            CloseNative(socket);
+        }
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+    socket_ = static_cast<Socket>(socket);
+    return true;
+}
+
+void UdpTransport::Close() {
+    if (socket_ == kNoSocket) {
+        return;
+    }
+    CloseNative(static_cast<NativeSocket>(socket_));
+    socket_ = kNoSocket;
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void UdpTransport::Send(const uint8_t* data, size_t size) {
+    if (socket_ == kNoSocket) {
+        return;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = peerPort_;
+    address.sin_addr.s_addr = peerAddress_;
+    // A full send buffer is just another lost packet.
+    sendto(static_cast<NativeSocket>(socket_), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+           reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+}
+
+size_t UdpTransport::Receive(uint8_t* buffer, size_t capacity) {
+    if (socket_ == kNoSocket) {
+        return 0;
+    }
+    for (;;) {
+        sockaddr_in from{};
+        socklen_t fromSize = sizeof(from);
+        const auto received = recvfrom(static_cast<NativeSocket>(socket_), reinterpret_cast<char*>(buffer),
+                                       static_cast<int>(capacity), 0, reinterpret_cast<sockaddr*>(&from), &fromSize);
+        if (received <= 0) {
+            // Nothing waiting, or an ICMP error from an earlier send (the
+            // peer is not up yet); either way there is nothing to hand out.
+            return 0;
+        }
+        if (from.sin_addr.s_addr == peerAddress_ && from.sin_port == peerPort_) {
+            return static_cast<size_t>(received);
+        }
+    }
+}
+
+LoopbackNetwork::LoopbackNetwork(const LoopbackConditions& conditions, uint64_t seed)
+    : conditions_(conditions),
+      random_(seed ? seed : 0x9E3779B97F4A7C15ull) {
+    endpoints_[0] = std::make_unique<Endpoint>(*this, 0);
+    endpoints_[1] = std::make_unique<Endpoint>(*this, 1);
+}
+
+void LoopbackNetwork::Send(int from, const uint8_t* data, size_t size) {
+    ++packetsSent_;
+    if (NextUniform() < conditions_.lossRate) {
+        ++packetsLost_;
+        return;
+    }
+    Packet packet;
+    packet.deliverAtMilliseconds = nowMilliseconds_ + conditions_.latencyMilliseconds
+        + conditions_.jitterMilliseconds * NextUniform();
+    packet.bytes.assign(data, data + size);
+    inFlight_[from ^ 1].push_back(std::move(packet));
+}
+
+size_t LoopbackNetwork::Receive(int to, uint8_t* buffer, size_t capacity) {
+    // Earliest arrival first, so jitter reorders packets as a real network would.
+    std::vector<Packet>& queue = inFlight_[to];
+    auto next = std::min_element(queue.begin(), queue.end(), [](const Packet& a, const Packet& b) {
+        return a.deliverAtMilliseconds < b.deliverAtMilliseconds;
+    });
+    if (next == queue.end() || next->deliverAtMilliseconds > nowMilliseconds_) {
+        return 0;
+    }
+    const size_t size = std::min(capacity, next->bytes.size());
+    std::memcpy(buffer, next->bytes.data(), size);
+    queue.erase(next);
+    return size;
+}
+
+double LoopbackNetwork::NextUniform() {
+    // xorshift64*, as the bots use: identical on every platform for a given seed.
+    random_ ^= random_ >> 12;
+    random_ ^= random_ << 25;
+    random_ ^= random_ >> 27;
+    return static_cast<double>((random_ * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
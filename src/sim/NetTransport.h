@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Unreliable, unordered datagrams to and from one peer. Packets may be lost,
+// duplicated or reordered; whoever sits on top has to cope.
+class NetTransport {
+public:
+    virtual ~NetTransport() = default;
+    virtual void Send(const uint8_t* data, size_t size) = 0;
+    // Copies the next waiting packet into `buffer` and returns its size, or
+    // 0 when none is waiting. Never blocks.
+    virtual size_t Receive(uint8_t* buffer, size_t capacity) = 0;
+};
+
+// Non-blocking UDP socket bound to a local port that talks to a single peer.
+// Packets from any other address are dropped.
+class UdpTransport : public NetTransport {
+public:
+    UdpTransport() = default;
+    ~UdpTransport() override;
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // `peer` is "host:port" with an IPv4 address or a resolvable host name.
+    bool Open(int localPort, const std::string& peer);
+    void Close();
+    bool IsOpen() const { return socket_ != kNoSocket; }
+
+    void Send(const uint8_t* data, size_t size) override;
+    size_t Receive(uint8_t* buffer, size_t capacity) override;
+
+private:
+    // Wide enough for a Windows SOCKET as well as a POSIX descriptor.
+    using Socket = intptr_t;
+    static constexpr Socket kNoSocket = -1;
+
+    Socket socket_ = kNoSocket;
+    uint32_t peerAddress_ = 0;
+    uint16_t peerPort_ = 0;
+};
+
+struct LoopbackConditions {
+    // One-way delay of every packet, plus up to `jitterMilliseconds` more
+    // drawn uniformly per packet, so packets can overtake each other.
+    double latencyMilliseconds = 0.0;
+    double jitterMilliseconds = 0.0;
+    // Chance in [0, 1] that a packet is silently dropped.
+    double lossRate = 0.0;
+};
+
+// Two endpoints in one process joined by a simulated network. Time is
+// virtual and only moves with Advance, and delays and losses come from a
+// seeded generator, so a run over the loopback is reproducible.
+class LoopbackNetwork {
+public:
+    LoopbackNetwork(const LoopbackConditions& conditions, uint64_t seed);
+
+    // Endpoint 0 talks to endpoint 1 and the other way round.
+    NetTransport& GetEndpoint(int index) { return *endpoints_[index & 1]; }
+    void Advance(double milliseconds) { nowMilliseconds_ += milliseconds; }
+
+    uint64_t GetPacketsSent() const { return packetsSent_; }
+    uint64_t GetPacketsLost() const { return packetsLost_; }
+
+private:
+    struct Packet {
+        double deliverAtMilliseconds = 0.0;
+        std::vector<uint8_t> bytes{};
+    };
+
+    class Endpoint : public NetTransport {
+    public:
+        Endpoint(LoopbackNetwork& network, int index) : network_(network), index_(index) {}
+        void Send(const uint8_t* data, size_t size) override { network_.Send(index_, data, size); }
+        size_t Receive(uint8_t* buffer, size_t capacity) override {
+            return network_.Receive(index_, buffer, capacity);
+        }
+
+    private:
+        LoopbackNetwork& network_;
+        int index_;
+    };
+
+    void Send(int from, const uint8_t* data, size_t size);
+    size_t Receive(int to, uint8_t* buffer, size_t capacity);
+    double NextUniform();
+
+    LoopbackConditions conditions_{};
+    uint64_t random_ = 0;
+    double nowMilliseconds_ = 0.0;
+    // In flight towards endpoint 0 and 1.
+    std::vector<Packet> inFlight_[2]{};
+    std::unique_ptr<Endpoint> endpoints_[2]{};
+    uint64_t packetsSent_ = 0;
+    uint64_t packetsLost_ = 0;
+};
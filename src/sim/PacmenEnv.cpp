@@ -0,0 +1,52 @@
+#include "sim/PacmenEnv.h"
+
+#include <new>
+
+#include "sim/BatchEnv.h"
+
+struct PacmenEnv {
+    BatchEnv env;
+};
+
+PacmenEnv* pacmen_env_create(const char* map_path, int session_count, int ghost_count, int thread_count) {
+    if (map_path == nullptr || session_count <= 0) {
+        return nullptr;
+    }
+
+    BatchEnv::Config config;
+    config.mapPath = map_path;
+    config.sessionCount = session_count;
+    config.ghostCount = ghost_count;
+    config.threadCount = thread_count;
+
+    PacmenEnv* handle = new (std::nothrow) PacmenEnv{};
+    if (handle != nullptr && !handle->env.Initialize(config)) {
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
+
+void pacmen_env_destroy(PacmenEnv* env) {
+    delete env;
+}
+
+int pacmen_env_session_count(const PacmenEnv* env) {
+    return env->env.GetSessionCount();
+}
+
+PacmenObservationLayout pacmen_env_layout(const PacmenEnv* env) {
+    return env->env.GetLayout();
+}
+
+const uint64_t* pacmen_env_walls(const PacmenEnv* env) {
+    return env->env.GetWalls();
+}
+
+void pacmen_env_reset(PacmenEnv* env, void* observations) {
+    env->env.Reset(observations);
+}
+
+void pacmen_env_step(PacmenEnv* env, const uint8_t* actions, void* observations) {
+    env->env.Step(actions, observations);
+}
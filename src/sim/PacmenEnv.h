@@ -0,0 +1,86 @@
+/* C interface to BatchEnv for training code (ctypes, cffi, other FFIs).
+ * Observations are written into one caller-owned buffer of
+ * session_count * observation_stride bytes; each session's record starts
+ * with PacmenObservationHeader, followed by ghost positions at
+ * ghosts_offset (ghost_capacity pairs of float x, y in pixels) and the live
+ * pellet plane at pellets_offset (words_per_row * height uint64 words, bit
+ * x & 63 of word y * words_per_row + (x >> 6) set where a pellet remains).
+ * The static wall plane, in the same layout, is shared by every session and
+ * read once through pacmen_env_walls. */
+#ifndef PACMEN_ENV_H
+#define PACMEN_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(PACMEN_ENV_SHARED)
+#if defined(PACMEN_ENV_BUILDING)
+#define PACMEN_ENV_API __declspec(dllexport)
+#else
+#define PACMEN_ENV_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__) && defined(PACMEN_ENV_SHARED)
+#define PACMEN_ENV_API __attribute__((visibility("default")))
+#else
+#define PACMEN_ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-player action byte. */
+enum {
+    PACMEN_ACTION_NONE = 0,
+    PACMEN_ACTION_LEFT = 1,
+    PACMEN_ACTION_UP = 2,
+    PACMEN_ACTION_RIGHT = 3,
+    PACMEN_ACTION_DOWN = 4
+};
+
+typedef struct PacmenObservationHeader {
+    int32_t state;              /* GameState: 1 playing, 2 game over, 3 win */
+    int32_t done;               /* 1 when this step ended the match; the session restarts before the next step */
+    int32_t remaining_pellets;
+    int32_t ghost_count;        /* valid entries in the ghost block */
+    float reward;               /* score both players gained this step */
+    float player_x[2];
+    float player_y[2];
+    int32_t score[2];
+    int32_t lives[2];
+    float invulnerable_seconds[2];
+    int32_t reserved;
+} PacmenObservationHeader;
+
+typedef struct PacmenObservationLayout {
+    size_t stride;              /* bytes per session, a multiple of 8 */
+    size_t ghosts_offset;
+    size_t ghost_capacity;
+    size_t pellets_offset;
+    int32_t width;
+    int32_t height;
+    int32_t words_per_row;
+} PacmenObservationLayout;
+
+typedef struct PacmenEnv PacmenEnv;
+
+/* thread_count <= 1 steps every session on the calling thread. Returns NULL
+ * if the map cannot be loaded. */
+PACMEN_ENV_API PacmenEnv* pacmen_env_create(const char* map_path, int session_count, int ghost_count,
+                                            int thread_count);
+PACMEN_ENV_API void pacmen_env_destroy(PacmenEnv* env);
+
+PACMEN_ENV_API int pacmen_env_session_count(const PacmenEnv* env);
+PACMEN_ENV_API PacmenObservationLayout pacmen_env_layout(const PacmenEnv* env);
+PACMEN_ENV_API const uint64_t* pacmen_env_walls(const PacmenEnv* env);
+
+/* Starts a fresh match in every session and writes the first observations. */
+PACMEN_ENV_API void pacmen_env_reset(PacmenEnv* env, void* observations);
+/* actions holds two bytes per session (player 1, player 2), in session order. */
+PACMEN_ENV_API void pacmen_env_step(PacmenEnv* env, const uint8_t* actions, void* observations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#include "sim/Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    constexpr size_t kRingCapacity = size_t{ 1 } << 16;
+
+    struct Event {
+        const char* name;
+        uint64_t startNs;
+        uint64_t endNs;
+    };
+
+    struct ThreadRing {
+        std::vector<Event> events = std::vector<Event>(kRingCapacity);
+        std::atomic<uint64_t> written{ 0 };
+        std::string threadName;
+        uint32_t threadId = 0;
+    };
+
+    // Rings outlive their threads so a trace written after a worker exits
+    // still contains that worker's events.
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadRing>> rings;
+    };
+
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadRing& GetThreadRing() {
+        thread_local ThreadRing* ring = nullptr;
+        if (ring == nullptr) {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.rings.push_back(std::make_unique<ThreadRing>());
+            ring = registry.rings.back().get();
+            ring->threadId = static_cast<uint32_t>(registry.rings.size());
+        }
+        return *ring;
+    }
+
+    const std::chrono::steady_clock::time_point& Epoch() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return epoch;
+    }
+
+    void WriteEscaped(std::FILE* file, const char* text) {
+        for (const char* c = text; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') {
+                std::fputc('\\', file);
+            }
+            std::fputc(*c, file);
+        }
+    }
+}
+
+namespace Profiler {
+    uint64_t NowNanoseconds() {
+        const auto elapsed = std::chrono::steady_clock::now() - Epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    void Record(const char* name, uint64_t startNs, uint64_t endNs) {
+        ThreadRing& ring = GetThreadRing();
+        const uint64_t index = ring.written.load(std::memory_order_relaxed);
+        ring.events[index & (kRingCapacity - 1)] = Event{ name, startNs, endNs };
+        ring.written.store(index + 1, std::memory_order_release);
+    }
+
+    void SetThreadName(const char* name) {
+        if (!kEnabled) {
+            return;
+        }
+
+        ThreadRing& ring = GetThreadRing();
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        ring.threadName = name;
+    }
+
+    bool WriteChromeTrace(const std::string& path) {
+        if (!kEnabled) {
+            return false;
+        }
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+        bool first = true;
+        for (const std::unique_ptr<ThreadRing>& ring : registry.rings) {
+            if (!ring->threadName.empty()) {
+                std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                             first ? "" : ",\n", ring->threadId);
+                WriteEscaped(file, ring->threadName.c_str());
+                std::fputs("\"}}", file);
+                first = false;
+            }
+
+            const uint64_t written = ring->written.load(std::memory_order_acquire);
+            const uint64_t begin = written > kRingCapacity ? written - kRingCapacity : 0;
+            for (uint64_t i = begin; i < written; ++i) {
+                const Event& event = ring->events[i & (kRingCapacity - 1)];
+                std::fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+                WriteEscaped(file, event.name);
+                std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                             ring->threadId, event.startNs / 1000.0, (event.endNs - event.startNs) / 1000.0);
+                first = false;
+            }
+        }
+        std::fputs("\n]}\n", file);
+
+        return std::fclose(file) == 0;
+    }
+}
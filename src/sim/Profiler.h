@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped-zone profiler. Zones record into a fixed-size ring buffer owned by
+// the calling thread, so recording never locks or allocates; the oldest
+// events are overwritten once a ring is full. Configure with
+// -DPACMEN_PROFILE=ON to compile zones in; otherwise PACMEN_PROFILE_ZONE
+// expands to nothing.
+namespace Profiler {
+#if defined(PACMEN_PROFILE)
+    constexpr bool kEnabled = true;
+#else
+    constexpr bool kEnabled = false;
+#endif
+
+    // Nanoseconds since the profiler's epoch (first use in the process).
+    uint64_t NowNanoseconds();
+
+    // Appends one complete event to the calling thread's ring.
+    void Record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    // Names the calling thread in exported traces.
+    void SetThreadName(const char* name);
+
+    // Writes every buffered event as Chrome trace_event JSON (load it in
+    // chrome://tracing or Perfetto). Returns false if nothing could be
+    // written, including when the profiler is compiled out. Threads that are
+    // recording at the same time may have their newest events cut off.
+    bool WriteChromeTrace(const std::string& path);
+
+    // `name` must outlive the trace export; string literals are expected.
+    class ScopedZone {
+    public:
+        explicit ScopedZone(const char* name)
+            : name_(name), startNs_(NowNanoseconds()) {
+        }
+        ~ScopedZone() { Record(name_, startNs_, NowNanoseconds()); }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t startNs_;
+    };
+}
+
+#define PACMEN_PROFILE_CONCAT_INNER(a, b) a##b
+#define PACMEN_PROFILE_CONCAT(a, b) PACMEN_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(PACMEN_PROFILE)
+#define PACMEN_PROFILE_ZONE(name) ::Profiler::ScopedZone PACMEN_PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#else
+#define PACMEN_PROFILE_ZONE(name) ((void)0)
+#endif
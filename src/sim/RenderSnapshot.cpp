@@ -0,0 +1,48 @@
+#include "sim/RenderSnapshot.h"
+
+#include <algorithm>
+
+#include "sim/Profiler.h"
+
+void SnapshotWriter::BeginStep(const Simulation& simulation) {
+    const GhostArray& ghosts = simulation.GetGhosts();
+    previousPlayerA_ = simulation.GetPlayerA().position;
+    previousPlayerB_ = simulation.GetPlayerB().position;
+    respawnsA_ = simulation.GetPlayerA().respawns;
+    respawnsB_ = simulation.GetPlayerB().respawns;
+    resetCount_ = simulation.GetResetCount();
+    previousGhostX_.assign(ghosts.positionX.begin(), ghosts.positionX.end());
+    previousGhostY_.assign(ghosts.positionY.begin(), ghosts.positionY.end());
+}
+
+void SnapshotWriter::Write(const Simulation& simulation, int64_t stepStartNs, int64_t stepNs, RenderSnapshot& out) const {
+    PACMEN_PROFILE_ZONE("SnapshotWriter::Write");
+
+    out.tick = simulation.GetTick();
+    out.stepStartNs = stepStartNs;
+    out.stepNs = stepNs;
+    out.state = simulation.GetState();
+    out.playerA = simulation.GetPlayerA();
+    out.playerB = simulation.GetPlayerB();
+    const bool reset = simulation.GetResetCount() != resetCount_;
+    out.previousPlayerA = reset || out.playerA.respawns != respawnsA_ ? out.playerA.position : previousPlayerA_;
+    out.previousPlayerB = reset || out.playerB.respawns != respawnsB_ ? out.playerB.position : previousPlayerB_;
+
+    const GhostArray& ghosts = simulation.GetGhosts();
+    out.ghostX.assign(ghosts.positionX.begin(), ghosts.positionX.end());
+    out.ghostY.assign(ghosts.positionY.begin(), ghosts.positionY.end());
+    out.ghostRadius.assign(ghosts.radius.begin(), ghosts.radius.end());
+    out.ghostColor.assign(ghosts.color.begin(), ghosts.color.end());
+    // A reset during the step puts every ghost back on a spawn, and may
+    // change how many there are; start them from where they are rather
+    // than sliding them there.
+    const bool sameGhosts = !reset && previousGhostX_.size() == ghosts.Size();
+    out.previousGhostX.assign(sameGhosts ? previousGhostX_.begin() : ghosts.positionX.begin(),
+                              sameGhosts ? previousGhostX_.end() : ghosts.positionX.end());
+    out.previousGhostY.assign(sameGhosts ? previousGhostY_.begin() : ghosts.positionY.begin(),
+                              sameGhosts ? previousGhostY_.end() : ghosts.positionY.end());
+
+    const TileMap& map = simulation.GetMap();
+    map.SyncPelletPlane(out.pellets, out.pelletGeneration, out.pelletsApplied);
+    out.remainingPellets = map.GetRemainingPellets();
+}
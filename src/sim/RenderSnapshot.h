@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities/Ghost.h"
+#include "entities/Player.h"
+#include "sim/Simulation.h"
+
+// Everything the renderer needs from one simulation step, copied out so the
+// renderer never reads live simulation state. Positions are kept for both
+// the start and the end of the step so frames between steps can be
+// interpolated. Walls are not copied; they never change after loading and
+// are read from the map directly.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    // Wall-clock interval the step covers, in InputSampler::Now() time.
+    int64_t stepStartNs = 0;
+    int64_t stepNs = 0;
+
+    GameState state = GameState::Menu;
+    Player playerA{};
+    Player playerB{};
+    Vector2 previousPlayerA{};
+    Vector2 previousPlayerB{};
+
+    std::vector<float> ghostX{};
+    std::vector<float> ghostY{};
+    std::vector<float> previousGhostX{};
+    std::vector<float> previousGhostY{};
+    std::vector<float> ghostRadius{};
+    std::vector<Color> ghostColor{};
+
+    // Pellet plane laid out like TileMap's (see TileMap::GetPelletWords).
+    std::vector<uint64_t> pellets{};
+    int remainingPellets = 0;
+    // How far this copy of the plane has been brought up to date.
+    uint32_t pelletGeneration = 0;
+    size_t pelletsApplied = 0;
+};
+
+// Fills snapshots from a Simulation on the thread that runs it. Call
+// BeginStep before each Update so the next Write knows where everything
+// started from. Whatever was teleported during the step, a caught player
+// or everything on a reset, starts from where it ended up instead.
+class SnapshotWriter {
+public:
+    void BeginStep(const Simulation& simulation);
+    // Snapshot slots are reused, so the pellet plane is only patched with
+    // the pellets eaten since this slot was last written.
+    void Write(const Simulation& simulation, int64_t stepStartNs, int64_t stepNs, RenderSnapshot& out) const;
+
+private:
+    Vector2 previousPlayerA_{};
+    Vector2 previousPlayerB_{};
+    uint32_t respawnsA_ = 0;
+    uint32_t respawnsB_ = 0;
+    uint64_t resetCount_ = 0;
+    std::vector<float> previousGhostX_{};
+    std::vector<float> previousGhostY_{};
+};
@@ -0,0 +1,311 @@
+#include "sim/RollbackSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "sim/InputLog.h"
+#include "sim/Profiler.h"
+
+namespace {
+    constexpr uint32_t kMagic = 0x42524D50; // "PMRB"
+    constexpr uint8_t kVersion = 1;
+    constexpr size_t kHeaderBytes = 14;
+    constexpr size_t kMaxPacketBytes = 512;
+
+    constexpr uint8_t kDirectionMask = 0x0F;
+    constexpr uint8_t kStartPressed = 0x10;
+    constexpr uint8_t kResetPressed = 0x20;
+    constexpr uint8_t kPressMask = kStartPressed | kResetPressed;
+    // Direction (0, 0), nothing pressed.
+    constexpr uint8_t kNoInput = 4;
+
+    int Sign(float value) {
+        return (value > 0.0f) - (value < 0.0f);
+    }
+
+    // Direction codes are (dy + 1) * 3 + (dx + 1), as in recordings. Any
+    // direction is snapped to the nearest compass point so both peers
+    // step with bit-identical floats.
+    uint8_t EncodeInput(Vector2 direction, bool startPressed, bool resetPressed) {
+        uint8_t input = static_cast<uint8_t>((Sign(direction.y) + 1) * 3 + (Sign(direction.x) + 1));
+        if (startPressed) {
+            input |= kStartPressed;
+        }
+        if (resetPressed) {
+            input |= kResetPressed;
+        }
+        return input;
+    }
+
+    Vector2 DecodeDirection(uint8_t input) {
+        // Normalised exactly as Input does it.
+        const int code = input & kDirectionMask;
+        Vector2 value{ static_cast<float>(code % 3 - 1), static_cast<float>(code / 3 - 1) };
+        const float length = std::sqrt(value.x * value.x + value.y * value.y);
+        if (length > 0.0f) {
+            value = { value.x / length, value.y / length };
+        }
+        return value;
+    }
+
+    void WriteU32(uint8_t* out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<uint8_t>(value >> (i * 8));
+        }
+    }
+
+    uint32_t ReadU32(const uint8_t* in) {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(in[i]) << (i * 8);
+        }
+        return value;
+    }
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // The packet's 32-bit tick nearest `reference`; sessions run for years
+    // of ticks before the difference matters.
+    uint64_t Widen(uint32_t tick, uint64_t reference) {
+        return reference + static_cast<int32_t>(tick - static_cast<uint32_t>(reference));
+    }
+}
+
+RollbackSession::RollbackSession(Simulation& simulation, NetTransport& transport, int localPlayer,
+                                 float deltaSeconds)
+    : simulation_(simulation),
+      transport_(transport),
+      localPlayer_(localPlayer & 1),
+      deltaSeconds_(deltaSeconds) {
+    localInputs_.fill(kNoInput);
+    remoteInputs_.fill(kNoInput);
+    predicted_.fill(kNoInput);
+    packet_.reserve(kMaxPacketBytes);
+    // Sized up front so no save during play allocates.
+    const size_t ghostCount = static_cast<size_t>(simulation_.GetGhostCount());
+    for (SimulationState& snapshot : snapshots_) {
+        simulation_.SaveState(snapshot);
+        snapshot.ghosts.Reserve(std::max(ghostCount, simulation_.GetGhosts().Size()));
+        snapshot.schedule.flags.reserve(snapshot.ghosts.positionX.capacity());
+    }
+}
+
+void RollbackSession::SetInputDelay(int ticks) {
+    if (currentTick_ == 0) {
+        localCount_ = static_cast<uint64_t>(std::clamp(ticks, 0, kMaxInputDelay));
+    }
+}
+
+void RollbackSession::SetMetrics(Metrics* metrics) {
+    metrics_ = metrics;
+    if (metrics_ != nullptr && scratchMetrics_ == nullptr) {
+        scratchMetrics_ = std::make_unique<Metrics>();
+    }
+    simulation_.SetMetrics(metrics_ != nullptr ? scratchMetrics_.get() : nullptr);
+}
+
+void RollbackSession::Poll() {
+    PACMEN_PROFILE_ZONE("RollbackSession::Poll");
+    uint8_t buffer[kMaxPacketBytes];
+    uint64_t firstWrong = UINT64_MAX;
+    while (const size_t size = transport_.Receive(buffer, sizeof(buffer))) {
+        firstWrong = std::min(firstWrong, ReadPacket(buffer, size));
+    }
+
+    if (firstWrong < currentTick_) {
+        PACMEN_PROFILE_ZONE("RollbackSession::Rollback");
+        ++stats_.rollbacks;
+        const uint64_t presentTick = currentTick_;
+        LoadSnapshot(firstWrong);
+        currentTick_ = firstWrong;
+        // The snapshot before firstWrong is still good; the later ones are
+        // retaken as the corrected ticks are stepped again.
+        Step(false);
+        while (currentTick_ < presentTick) {
+            Step(true);
+        }
+        stats_.resimulatedTicks += presentTick - firstWrong;
+    }
+    RecordConfirmed();
+}
+
+bool RollbackSession::Advance(const InputFrame& local) {
+    const Vector2 direction = localPlayer_ == 0 ? local.player1Direction : local.player2Direction;
+    const uint8_t input = EncodeInput(direction, local.startPressed, local.resetPressed) | pendingPresses_;
+    if (!CanAdvance()) {
+        ++stats_.stalls;
+        pendingPresses_ = input & kPressMask;
+        // The peer may be waiting on a packet of ours that was lost.
+        SendInputs();
+        return false;
+    }
+
+    pendingPresses_ = 0;
+    localInputs_[localCount_ % kInputRing] = input;
+    ++localCount_;
+    SendInputs();
+    Step(true);
+    ++stats_.ticks;
+    RecordConfirmed();
+    return true;
+}
+
+void RollbackSession::RewindToConfirmed() {
+    const uint64_t confirmed = GetConfirmedTick();
+    if (confirmed < currentTick_) {
+        LoadSnapshot(confirmed);
+        currentTick_ = confirmed;
+    }
+}
+
+bool RollbackSession::CanAdvance() const {
+    // The second limit only bites when the peer has heard nothing from us
+    // for a long time; it keeps unacknowledged inputs inside one packet.
+    return currentTick_ < remoteCount_ + kMaxRollback && localCount_ - remoteAcked_ < kInputRing - 1;
+}
+
+uint8_t RollbackSession::RemoteInputAt(uint64_t tick) const {
+    if (tick < remoteCount_) {
+        return remoteInputs_[tick % kInputRing];
+    }
+    // Held directions tend to stay held; presses are one-off.
+    const uint8_t last = remoteCount_ > 0 ? remoteInputs_[(remoteCount_ - 1) % kInputRing] : kNoInput;
+    return last & kDirectionMask;
+}
+
+InputFrame RollbackSession::CombinedFrame(uint64_t tick, uint8_t remote) const {
+    const uint8_t local = localInputs_[tick % kInputRing];
+    const uint8_t player1 = localPlayer_ == 0 ? local : remote;
+    const uint8_t player2 = localPlayer_ == 0 ? remote : local;
+    InputFrame frame{};
+    frame.player1Direction = DecodeDirection(player1);
+    frame.player2Direction = DecodeDirection(player2);
+    frame.startPressed = ((player1 | player2) & kStartPressed) != 0;
+    frame.resetPressed = ((player1 | player2) & kResetPressed) != 0;
+    return frame;
+}
+
+void RollbackSession::Step(bool saveSnapshot) {
+    if (saveSnapshot) {
+        SaveSnapshot(currentTick_);
+    }
+    const uint8_t remote = RemoteInputAt(currentTick_);
+    if (currentTick_ >= remoteCount_) {
+        predicted_[currentTick_ % kInputRing] = remote;
+    }
+    if (metrics_ == nullptr) {
+        simulation_.Update(CombinedFrame(currentTick_, remote), deltaSeconds_);
+    } else {
+        // A re-simulated tick overwrites what its mispredicted step added.
+        const Metrics& scratch = *scratchMetrics_;
+        const uint64_t pellets = scratch.pelletsConsumed.load(std::memory_order_relaxed);
+        const uint64_t captures = scratch.captures.load(std::memory_order_relaxed);
+        const uint64_t resets = scratch.resets.load(std::memory_order_relaxed);
+        const uint64_t ghostUpdates = scratch.ghostUpdateTime.GetCount();
+        const int64_t ghostUpdateNs = scratch.ghostUpdateTime.GetSum();
+        simulation_.Update(CombinedFrame(currentTick_, remote), deltaSeconds_);
+        TickMetrics& tick = tickMetrics_[currentTick_ % kInputRing];
+        tick.pellets = scratch.pelletsConsumed.load(std::memory_order_relaxed) - pellets;
+        tick.captures = scratch.captures.load(std::memory_order_relaxed) - captures;
+        tick.resets = scratch.resets.load(std::memory_order_relaxed) - resets;
+        tick.ghostUpdated = scratch.ghostUpdateTime.GetCount() != ghostUpdates;
+        tick.ghostUpdateNs = scratch.ghostUpdateTime.GetSum() - ghostUpdateNs;
+    }
+    ++currentTick_;
+}
+
+void RollbackSession::SaveSnapshot(uint64_t tick) {
+    const int64_t start = NowNs();
+    simulation_.SaveState(snapshots_[tick % kSnapshotRing]);
+    const int64_t elapsed = NowNs() - start;
+    ++stats_.saves;
+    stats_.saveNsTotal += elapsed;
+    stats_.saveNsMax = std::max(stats_.saveNsMax, elapsed);
+}
+
+void RollbackSession::LoadSnapshot(uint64_t tick) {
+    const int64_t start = NowNs();
+    simulation_.LoadState(snapshots_[tick % kSnapshotRing]);
+    const int64_t elapsed = NowNs() - start;
+    ++stats_.loads;
+    stats_.loadNsTotal += elapsed;
+    stats_.loadNsMax = std::max(stats_.loadNsMax, elapsed);
+}
+
+// Layout, little-endian: magic u32, version u8, input count u8, how many of
+// the receiver's inputs we hold (the ack) u32, tick of the first input u32,
+// then one byte per input.
+void RollbackSession::SendInputs() {
+    const uint64_t first = remoteAcked_;
+    const size_t count = static_cast<size_t>(localCount_ - first);
+    packet_.resize(kHeaderBytes + count);
+    WriteU32(packet_.data(), kMagic);
+    packet_[4] = kVersion;
+    packet_[5] = static_cast<uint8_t>(count);
+    WriteU32(packet_.data() + 6, static_cast<uint32_t>(remoteCount_));
+    WriteU32(packet_.data() + 10, static_cast<uint32_t>(first));
+    for (size_t i = 0; i < count; ++i) {
+        packet_[kHeaderBytes + i] = localInputs_[(first + i) % kInputRing];
+    }
+    transport_.Send(packet_.data(), packet_.size());
+    ++stats_.packetsSent;
+}
+
+uint64_t RollbackSession::ReadPacket(const uint8_t* data, size_t size) {
+    uint64_t firstWrong = UINT64_MAX;
+    if (size < kHeaderBytes || ReadU32(data) != kMagic || data[4] != kVersion || size != kHeaderBytes + data[5]) {
+        return firstWrong;
+    }
+    ++stats_.packetsReceived;
+
+    const uint64_t acked = Widen(ReadU32(data + 6), remoteAcked_);
+    if (acked > remoteAcked_ && acked <= localCount_) {
+        remoteAcked_ = acked;
+    }
+
+    const uint64_t first = Widen(ReadU32(data + 10), remoteCount_);
+    const size_t count = data[5];
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t tick = first + i;
+        if (tick < remoteCount_) {
+            continue;
+        }
+        // Inputs arrive in order within a packet and packets start at our
+        // ack, so a gap means a stale or foreign packet. Inputs too far
+        // ahead would overwrite ones not yet recorded.
+        if (tick > remoteCount_ || tick >= recordedTick_ + kInputRing) {
+            break;
+        }
+        const uint8_t input = data[kHeaderBytes + i];
+        remoteInputs_[tick % kInputRing] = input;
+        if (tick < currentTick_ && input != predicted_[tick % kInputRing]) {
+            firstWrong = std::min(firstWrong, tick);
+        }
+        ++remoteCount_;
+    }
+    return firstWrong;
+}
+
+void RollbackSession::RecordConfirmed() {
+    const uint64_t confirmed = GetConfirmedTick();
+    for (; recordedTick_ < confirmed; ++recordedTick_) {
+        if (recorder_ != nullptr) {
+            recorder_->Record(CombinedFrame(recordedTick_, remoteInputs_[recordedTick_ % kInputRing]), deltaSeconds_);
+        }
+        if (metrics_ != nullptr) {
+            const TickMetrics& tick = tickMetrics_[recordedTick_ % kInputRing];
+            metrics_->ticks.fetch_add(1, std::memory_order_relaxed);
+            metrics_->pelletsConsumed.fetch_add(tick.pellets, std::memory_order_relaxed);
+            metrics_->captures.fetch_add(tick.captures, std::memory_order_relaxed);
+            metrics_->resets.fetch_add(tick.resets, std::memory_order_relaxed);
+            if (tick.ghostUpdated) {
+                metrics_->ghostUpdateTime.Record(tick.ghostUpdateNs);
+            }
+        }
+    }
+}
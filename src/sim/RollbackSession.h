@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sim/InputSource.h"
+#include "sim/Metrics.h"
+#include "sim/NetTransport.h"
+#include "sim/Simulation.h"
+
+class InputRecorder;
+
+struct RollbackStats {
+    // Ticks advanced, not counting re-simulation.
+    uint64_t ticks = 0;
+    uint64_t rollbacks = 0;
+    uint64_t resimulatedTicks = 0;
+    // Advance calls turned down for being too far ahead of the peer.
+    uint64_t stalls = 0;
+    uint64_t packetsSent = 0;
+    uint64_t packetsReceived = 0;
+    uint64_t saves = 0;
+    int64_t saveNsTotal = 0;
+    int64_t saveNsMax = 0;
+    uint64_t loads = 0;
+    int64_t loadNsTotal = 0;
+    int64_t loadNsMax = 0;
+};
+
+// Online co-op for two peers that each run the whole simulation. Every tick
+// steps at once with the local input and a prediction of the remote one
+// (whatever the peer last held). When the real remote input arrives and
+// differs, the session restores the snapshot taken before that tick and
+// re-simulates up to the present, at most kMaxRollback ticks.
+//
+// Inputs are one byte per player per tick: a compass direction and the
+// start and reset presses. Every packet carries all local inputs the peer
+// has not acknowledged yet, so a lost packet is covered by the next one.
+class RollbackSession {
+public:
+    static constexpr int kMaxRollback = 8;
+    static constexpr int kMaxInputDelay = 8;
+
+    // Both peers must start from the same Simulation state, with the same
+    // settings and step size. localPlayer 0 steers player 1, 1 player 2.
+    RollbackSession(Simulation& simulation, NetTransport& transport, int localPlayer, float deltaSeconds);
+
+    // Holds local input back this many ticks before it applies, trading
+    // input lag for fewer rollbacks. Only before the first Advance.
+    void SetInputDelay(int ticks);
+    // Receives every tick once both peers' inputs for it are known, so the
+    // recording replays the session on a single machine.
+    void SetRecorder(InputRecorder* recorder) { recorder_ = recorder; }
+    // Counts each tick into `metrics` once it is confirmed, with what the
+    // confirmed timeline did: predicted ticks, and re-simulating them on a
+    // rollback, count nothing. Replaces any metrics set on the Simulation.
+    // Only before the first Advance.
+    void SetMetrics(Metrics* metrics);
+
+    // Takes in waiting packets and rolls back if a prediction was wrong.
+    void Poll();
+    // Steps one tick with the local player's direction and presses (the
+    // other player's direction in `local` is ignored). Returns false without
+    // stepping when already kMaxRollback ticks ahead of the peer's input;
+    // presses made then are carried into the next tick that runs.
+    bool Advance(const InputFrame& local);
+    // Sends every input the peer has not acknowledged. Advance does this on
+    // its own; call it to keep resending while no longer advancing.
+    void SendInputs();
+    // Restores the state after the last tick both inputs are known for,
+    // undoing the predicted ones. Ends the session: call it once, on exit.
+    void RewindToConfirmed();
+
+    uint64_t GetTick() const { return currentTick_; }
+    // Ticks before this one were stepped with both real inputs.
+    uint64_t GetConfirmedTick() const { return remoteCount_ < currentTick_ ? remoteCount_ : currentTick_; }
+    const RollbackStats& GetStats() const { return stats_; }
+
+private:
+    static constexpr int kInputRing = 64;
+    static constexpr int kSnapshotRing = kMaxRollback + 2;
+
+    bool CanAdvance() const;
+    // The peer's input for `tick`, or the prediction while it is unknown.
+    uint8_t RemoteInputAt(uint64_t tick) const;
+    InputFrame CombinedFrame(uint64_t tick, uint8_t remote) const;
+    void Step(bool saveSnapshot);
+    void SaveSnapshot(uint64_t tick);
+    void LoadSnapshot(uint64_t tick);
+    // Returns the first tick whose prediction turned out wrong, or
+    // UINT64_MAX if none did.
+    uint64_t ReadPacket(const uint8_t* data, size_t size);
+    void RecordConfirmed();
+
+    // What one step added to scratchMetrics_.
+    struct TickMetrics {
+        uint64_t pellets = 0;
+        uint64_t captures = 0;
+        uint64_t resets = 0;
+        int64_t ghostUpdateNs = 0;
+        bool ghostUpdated = false;
+    };
+    Simulation& simulation_;
+    NetTransport& transport_;
+    const int localPlayer_;
+    const float deltaSeconds_;
+    InputRecorder* recorder_ = nullptr;
+    Metrics* metrics_ = nullptr;
+    // Attached to the simulation in place of metrics_, so every step can be
+    // measured and only the confirmed ones passed on.
+    std::unique_ptr<Metrics> scratchMetrics_{};
+
+    // Indexed by tick % kInputRing. predicted_ holds what each tick not yet
+    // confirmed was last stepped with.
+    std::array<uint8_t, kInputRing> localInputs_{};
+    std::array<uint8_t, kInputRing> remoteInputs_{};
+    std::array<uint8_t, kInputRing> predicted_{};
+    std::array<TickMetrics, kInputRing> tickMetrics_{};
+    // State before tick t in slot t % kSnapshotRing; allocated once and
+    // refilled in place.
+    std::array<SimulationState, kSnapshotRing> snapshots_{};
+
+    uint64_t currentTick_ = 0;
+    // Local inputs exist for ticks [0, localCount_), the peer's for
+    // [0, remoteCount_). The peer has acknowledged [0, remoteAcked_).
+    uint64_t localCount_ = 0;
+    uint64_t remoteCount_ = 0;
+    uint64_t remoteAcked_ = 0;
+    uint64_t recordedTick_ = 0;
+    uint8_t pendingPresses_ = 0;
+    std::vector<uint8_t> packet_{};
+    RollbackStats stats_{};
+};
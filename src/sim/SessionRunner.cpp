@@ -0,0 +1,97 @@
+#include "sim/SessionRunner.h"
+
+#include <algorithm>
+
+#include "sim/Profiler.h"
+
+bool KeepMatchRunning(const Simulation& simulation, InputFrame& frame) {
+    const GameState state = simulation.GetState();
+    if (state == GameState::Menu) {
+        frame.startPressed = true;
+    } else if (state == GameState::GameOver || state == GameState::Win) {
+        frame.resetPressed = true;
+        return true;
+    }
+    return false;
+}
+
+bool SessionRunner::Initialize(const SessionConfig& config, int sessionCount) {
+    sessions_.clear();
+    sessions_.reserve(std::max(0, sessionCount));
+    deltaSeconds_ = config.deltaSeconds;
+
+    for (int i = 0; i < sessionCount; ++i) {
+        auto session = std::make_unique<Session>(config.seed + static_cast<uint64_t>(i));
+        session->simulation.SetGhostCount(config.ghostCount);
+        if (!session->simulation.LoadMap(config.mapPath)) {
+            sessions_.clear();
+            return false;
+        }
+        sessions_.push_back(std::move(session));
+    }
+    return true;
+}
+
+void SessionRunner::Run(ThreadPool& pool, uint64_t ticks, uint64_t ticksPerTask) {
+    ticksPerTask = std::max<uint64_t>(1, ticksPerTask);
+
+    // A session's slices must run in order, so each task runs one slice and
+    // then queues the next one itself.
+    struct Chain {
+        static void Step(ThreadPool& pool, Session& session, uint64_t remaining, uint64_t slice, float deltaSeconds) {
+            const uint64_t now = std::min(remaining, slice);
+            Advance(session, now, deltaSeconds);
+            if (remaining > now) {
+                pool.Submit([&pool, &session, remaining, now, slice, deltaSeconds] {
+                    Step(pool, session, remaining - now, slice, deltaSeconds);
+                });
+            }
+        }
+    };
+
+    for (const std::unique_ptr<Session>& session : sessions_) {
+        Session& target = *session;
+        const float deltaSeconds = deltaSeconds_;
+        pool.Submit([&pool, &target, ticks, ticksPerTask, deltaSeconds] {
+            Chain::Step(pool, target, ticks, ticksPerTask, deltaSeconds);
+        });
+    }
+    pool.Wait();
+}
+
+void SessionRunner::Advance(Session& session, uint64_t ticks, float deltaSeconds) {
+    PACMEN_PROFILE_ZONE("SessionRunner::Advance");
+
+    for (uint64_t i = 0; i < ticks; ++i) {
+        InputFrame frame = session.bots.Poll();
+        if (KeepMatchRunning(session.simulation, frame)) {
+            ++session.matches;
+        }
+        session.simulation.Update(frame, deltaSeconds);
+    }
+    session.ticks += ticks;
+}
+
+uint64_t SessionRunner::GetTotalTicks() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<Session>& session : sessions_) {
+        total += session->ticks;
+    }
+    return total;
+}
+
+uint64_t SessionRunner::GetTotalMatches() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<Session>& session : sessions_) {
+        total += session->matches;
+    }
+    return total;
+}
+
+uint64_t SessionRunner::ComputeCombinedHash() const {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const std::unique_ptr<Session>& session : sessions_) {
+        hash = (hash ^ session->simulation.ComputeStateHash()) * 0x100000001B3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sim/BotInputSource.h"
+#include "sim/Simulation.h"
+#include "sim/ThreadPool.h"
+
+// Soak-test control: starts a match from the menu and resets a finished one,
+// so bots keep playing indefinitely. Returns true when a match just ended.
+bool KeepMatchRunning(const Simulation& simulation, InputFrame& frame);
+
+struct SessionConfig {
+    std::string mapPath = "builtin:level1";
+    int ghostCount = 6;
+    float deltaSeconds = 1.0f / 60.0f;
+    // Session i plays with bots seeded from seed + i.
+    uint64_t seed = 1;
+};
+
+// Owns many independent bot-driven matches and advances them in parallel on
+// a ThreadPool. Each session has its own Simulation and bots and nothing is
+// shared between them, so a session's result does not depend on the thread
+// count or on scheduling.
+class SessionRunner {
+public:
+    bool Initialize(const SessionConfig& config, int sessionCount);
+
+    // Advances every session by `ticks`, handing each session to the pool in
+    // slices of `ticksPerTask` so idle workers can steal the remaining slices.
+    void Run(ThreadPool& pool, uint64_t ticks, uint64_t ticksPerTask = 256);
+
+    int GetSessionCount() const { return static_cast<int>(sessions_.size()); }
+    uint64_t GetTotalTicks() const;
+    uint64_t GetTotalMatches() const;
+    // Combines every session's state hash in session order.
+    uint64_t ComputeCombinedHash() const;
+
+private:
+    struct Session {
+        explicit Session(uint64_t seed) : bots(seed) {}
+
+        Simulation simulation{};
+        BotInputSource bots;
+        uint64_t ticks = 0;
+        uint64_t matches = 0;
+    };
+
+    static void Advance(Session& session, uint64_t ticks, float deltaSeconds);
+
+    std::vector<std::unique_ptr<Session>> sessions_{};
+    float deltaSeconds_ = 1.0f / 60.0f;
+};
@@ -0,0 +1,321 @@
+#include "sim/Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "sim/Metrics.h"
+#include "sim/Profiler.h"
+#include "systems/SweptMove.h"
+
+Simulation::Simulation(int tilePixelSize)
+    : tilePixelSize_(tilePixelSize) {
+}
+
+bool Simulation::LoadMap(const std::string& path) {
+    if (!map_.LoadFromFile(path)) {
+        return false;
+    }
+
+    mapPixelWidth_ = map_.GetWidth() * tilePixelSize_;
+    mapPixelHeight_ = map_.GetHeight() * tilePixelSize_;
+
+    playerA_.radius = tilePixelSize_ * 0.35f;
+    playerA_.speed = tilePixelSize_ * 6.0f;
+    playerA_.color = YELLOW;
+
+    playerB_.radius = tilePixelSize_ * 0.35f;
+    playerB_.speed = tilePixelSize_ * 6.0f;
+    playerB_.color = GREEN;
+
+    ResetToMenu();
+    return true;
+}
+
+void Simulation::Update(const InputFrame& input, float deltaSeconds) {
+    PACMEN_PROFILE_ZONE("Simulation::Update");
+    ++tick_;
+    if (metrics_ != nullptr) {
+        metrics_->ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (input.resetPressed) {
+        ResetToMenu();
+        return;
+    }
+
+    if (state_ == GameState::Menu) {
+        if (input.startPressed) {
+            StartMatch();
+        }
+        return;
+    }
+
+    if (state_ == GameState::GameOver || state_ == GameState::Win) {
+        return;
+    }
+
+    playerA_.invulnerableSeconds = std::max(0.0f, playerA_.invulnerableSeconds - deltaSeconds);
+    playerB_.invulnerableSeconds = std::max(0.0f, playerB_.invulnerableSeconds - deltaSeconds);
+
+    const int pelletsBefore = map_.GetRemainingPellets();
+    TryMovePlayer(playerA_, input.player1Direction, deltaSeconds);
+    TryMovePlayer(playerB_, input.player2Direction, deltaSeconds);
+
+    HandlePelletPickup(playerA_);
+    HandlePelletPickup(playerB_);
+
+    if (metrics_ != nullptr) {
+        metrics_->pelletsConsumed.fetch_add(static_cast<uint64_t>(pelletsBefore - map_.GetRemainingPellets()),
+                                            std::memory_order_relaxed);
+    }
+    if (map_.GetRemainingPellets() == 0) {
+        state_ = GameState::Win;
+        return;
+    }
+
+    if (metrics_ == nullptr) {
+        ghostSystem_.Update(ghosts_, map_, playerA_, playerB_, deltaSeconds, tilePixelSize_);
+    } else {
+        const int livesBefore = playerA_.lives + playerB_.lives;
+        const auto start = std::chrono::steady_clock::now();
+        ghostSystem_.Update(ghosts_, map_, playerA_, playerB_, deltaSeconds, tilePixelSize_);
+        metrics_->ghostUpdateTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        metrics_->captures.fetch_add(static_cast<uint64_t>(livesBefore - playerA_.lives - playerB_.lives),
+                                     std::memory_order_relaxed);
+    }
+
+    if (playerA_.lives <= 0 && playerB_.lives <= 0) {
+        state_ = GameState::GameOver;
+    }
+}
+
+void Simulation::TryMovePlayer(Player& player, Vector2 direction, float deltaSeconds) {
+    PACMEN_PROFILE_ZONE("Simulation::TryMovePlayer");
+    if (direction.x == 0.0f && direction.y == 0.0f) {
+        return;
+    }
+
+    player.heading = direction;
+    const Vector2 delta = {
+        direction.x * player.speed * deltaSeconds,
+        direction.y * player.speed * deltaSeconds
+    };
+
+    WallGrid walls;
+    walls.words = map_.GetWallWords();
+    walls.wordsPerRow = map_.GetWordsPerRow();
+    walls.tilesWide = map_.GetWidth();
+    walls.tilesHigh = map_.GetHeight();
+    walls.tileSize = static_cast<float>(tilePixelSize_);
+    player.position = SweepCircle(walls, player.position, delta, player.radius, &sweptTiles_);
+
+    // A long step can pass over pellets before it ends; the tile it ends on
+    // is left to HandlePelletPickup as usual.
+    for (size_t i = 0; i + 1 < sweptTiles_.size(); ++i) {
+        const int width = map_.GetWidth();
+        if (map_.ConsumePelletAt(static_cast<int>(sweptTiles_[i] % width), static_cast<int>(sweptTiles_[i] / width))) {
+            player.score += 10;
+        }
+    }
+
+    player.position.x = std::clamp(player.position.x, player.radius, mapPixelWidth_ - player.radius);
+    player.position.y = std::clamp(player.position.y, player.radius, mapPixelHeight_ - player.radius);
+}
+
+Vector2 Simulation::TileToWorldCenter(Vector2 tile) const {
+    return {
+        (tile.x + 0.5f) * tilePixelSize_,
+        (tile.y + 0.5f) * tilePixelSize_
+    };
+}
+
+void Simulation::InitializeGhosts() {
+    ghosts_.Clear();
+    ghosts_.Reserve(ghostCount_);
+    ghostSystem_.ResetSchedule(static_cast<size_t>(ghostCount_));
+
+    const std::vector<Vector2>& mapSpawns = map_.GetGhostSpawns();
+    spawnTiles_.assign(mapSpawns.begin(),
+                       mapSpawns.begin() + std::min(mapSpawns.size(), static_cast<size_t>(ghostCount_)));
+
+    if (static_cast<int>(spawnTiles_.size()) < ghostCount_) {
+        const int needed = ghostCount_ - static_cast<int>(spawnTiles_.size());
+        FindFallbackGhostSpawns(needed, spawnTiles_, fallbackSpawns_);
+        spawnTiles_.insert(spawnTiles_.end(), fallbackSpawns_.begin(), fallbackSpawns_.end());
+    }
+
+    if (spawnTiles_.empty()) {
+        return;
+    }
+
+    const GhostRole mixedRoles[4] = { GhostRole::Chase, GhostRole::Ambush, GhostRole::Scatter, GhostRole::Patrol };
+
+    const Color ghostColors[6] = {
+        Color{ 230, 70, 60, 255 },
+        Color{ 255, 140, 0, 255 },
+        Color{ 255, 105, 180, 255 },
+        Color{ 80, 160, 255, 255 },
+        Color{ 170, 90, 255, 255 },
+        Color{ 60, 220, 120, 255 }
+    };
+
+    // With more ghosts than open tiles, later ghosts share spawn tiles.
+    for (int i = 0; i < ghostCount_; ++i) {
+        Ghost ghost{};
+        ghost.radius = tilePixelSize_ * 0.33f;
+        ghost.speed = playerA_.speed * 0.25f;
+        ghost.color = ghostColors[i % 6];
+        ghost.position = TileToWorldCenter(spawnTiles_[i % spawnTiles_.size()]);
+        ghost.currentDirection = { 0.0f, 0.0f };
+        if (ghostTargeting_ == GhostTargeting::Mixed) {
+            ghost.role = mixedRoles[i % 4];
+            ghost.waypoint = static_cast<uint8_t>((i / 4) % 4);
+        }
+        ghosts_.Add(ghost);
+    }
+}
+
+void Simulation::FindFallbackGhostSpawns(int needed, const std::vector<Vector2>& usedTiles,
+                                         std::vector<Vector2>& out) {
+    spawnPlacer_.Place(map_, map_.GetWidth() / 2, map_.GetHeight() / 2, needed, usedTiles, spawnRules_, out);
+}
+
+void Simulation::ResetSession() {
+    ++resetCount_;
+    if (metrics_ != nullptr) {
+        metrics_->resets.fetch_add(1, std::memory_order_relaxed);
+    }
+    map_.ResetTiles();
+
+    if (map_.HasPlayerSpawnA()) {
+        playerA_.position = TileToWorldCenter(map_.GetPlayerSpawnA());
+    } else {
+        playerA_.position = { tilePixelSize_ * 1.5f, tilePixelSize_ * 1.5f };
+    }
+    playerA_.spawnPosition = playerA_.position;
+    playerA_.lives = 3;
+    playerA_.score = 0;
+    playerA_.invulnerableSeconds = 0.0f;
+    playerA_.heading = { 0.0f, 0.0f };
+
+    if (map_.HasPlayerSpawnB()) {
+        playerB_.position = TileToWorldCenter(map_.GetPlayerSpawnB());
+    } else {
+        playerB_.position = { mapPixelWidth_ - tilePixelSize_ * 1.5f, mapPixelHeight_ - tilePixelSize_ * 1.5f };
+    }
+    playerB_.spawnPosition = playerB_.position;
+    playerB_.lives = 3;
+    playerB_.score = 0;
+    playerB_.invulnerableSeconds = 0.0f;
+    playerB_.heading = { 0.0f, 0.0f };
+
+    InitializeGhosts();
+}
+
+void Simulation::StartMatch() {
+    ResetSession();
+    state_ = GameState::Playing;
+}
+
+void Simulation::ResetToMenu() {
+    ResetSession();
+    state_ = GameState::Menu;
+}
+
+void Simulation::HandlePelletPickup(Player& player) {
+    PACMEN_PROFILE_ZONE("Simulation::HandlePelletPickup");
+    const int tileX = static_cast<int>(player.position.x / tilePixelSize_);
+    const int tileY = static_cast<int>(player.position.y / tilePixelSize_);
+    if (map_.ConsumePelletAt(tileX, tileY)) {
+        player.score += 10;
+    }
+}
+
+void Simulation::SaveState(SimulationState& out) const {
+    PACMEN_PROFILE_ZONE("Simulation::SaveState");
+    out.playerA = playerA_;
+    out.playerB = playerB_;
+    out.ghosts.positionX.assign(ghosts_.positionX.begin(), ghosts_.positionX.end());
+    out.ghosts.positionY.assign(ghosts_.positionY.begin(), ghosts_.positionY.end());
+    out.ghosts.directionX.assign(ghosts_.directionX.begin(), ghosts_.directionX.end());
+    out.ghosts.directionY.assign(ghosts_.directionY.begin(), ghosts_.directionY.end());
+    out.ghosts.speed.assign(ghosts_.speed.begin(), ghosts_.speed.end());
+    out.ghosts.radius.assign(ghosts_.radius.begin(), ghosts_.radius.end());
+    out.ghosts.color.assign(ghosts_.color.begin(), ghosts_.color.end());
+    out.ghosts.role.assign(ghosts_.role.begin(), ghosts_.role.end());
+    out.ghosts.waypoint.assign(ghosts_.waypoint.begin(), ghosts_.waypoint.end());
+    ghostSystem_.SaveSchedule(out.schedule);
+    out.state = state_;
+    out.tick = tick_;
+
+    map_.SyncPelletPlane(out.pellets, out.pelletGeneration, out.pelletsApplied);
+    out.remainingPellets = map_.GetRemainingPellets();
+}
+
+void Simulation::LoadState(const SimulationState& in) {
+    PACMEN_PROFILE_ZONE("Simulation::LoadState");
+    playerA_ = in.playerA;
+    playerB_ = in.playerB;
+    ghosts_.positionX.assign(in.ghosts.positionX.begin(), in.ghosts.positionX.end());
+    ghosts_.positionY.assign(in.ghosts.positionY.begin(), in.ghosts.positionY.end());
+    ghosts_.directionX.assign(in.ghosts.directionX.begin(), in.ghosts.directionX.end());
+    ghosts_.directionY.assign(in.ghosts.directionY.begin(), in.ghosts.directionY.end());
+    ghosts_.speed.assign(in.ghosts.speed.begin(), in.ghosts.speed.end());
+    ghosts_.radius.assign(in.ghosts.radius.begin(), in.ghosts.radius.end());
+    ghosts_.color.assign(in.ghosts.color.begin(), in.ghosts.color.end());
+    ghosts_.role.assign(in.ghosts.role.begin(), in.ghosts.role.end());
+    ghosts_.waypoint.assign(in.ghosts.waypoint.begin(), in.ghosts.waypoint.end());
+    ghostSystem_.LoadSchedule(in.schedule);
+    state_ = in.state;
+    tick_ = in.tick;
+    map_.RestorePellets(in.pellets, in.remainingPellets, in.pelletGeneration, in.pelletsApplied);
+}
+
+uint64_t Simulation::ComputeStateHash() const {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 0x100000001B3ull;
+        }
+    };
+    auto mixFloat = [&mix](float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        mix(bits);
+    };
+    // heading follows from the recorded inputs, so it is left out and older
+    // recordings still verify.
+    auto mixPlayer = [&](const Player& player) {
+        mixFloat(player.position.x);
+        mixFloat(player.position.y);
+        mixFloat(player.invulnerableSeconds);
+        mix(static_cast<uint64_t>(player.lives));
+        mix(static_cast<uint64_t>(player.score));
+    };
+
+    mix(tick_);
+    mix(static_cast<uint64_t>(state_));
+    mixPlayer(playerA_);
+    mixPlayer(playerB_);
+
+    for (size_t i = 0; i < ghosts_.Size(); ++i) {
+        mixFloat(ghosts_.positionX[i]);
+        mixFloat(ghosts_.positionY[i]);
+        mixFloat(ghosts_.directionX[i]);
+        mixFloat(ghosts_.directionY[i]);
+        // Only patrols ever move their waypoint on.
+        if (ghosts_.role[i] == GhostRole::Patrol) {
+            mix(ghosts_.waypoint[i]);
+        }
+    }
+
+    const size_t pelletWords = static_cast<size_t>(map_.GetWordsPerRow()) * map_.GetHeight();
+    const uint64_t* pellets = map_.GetPelletWords();
+    for (size_t i = 0; i < pelletWords; ++i) {
+        mix(pellets[i]);
+    }
+
+    return hash;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "entities/Ghost.h"
+#include "entities/Player.h"
+#include "game/TileMap.h"
+#include "sim/InputSource.h"
+#include "systems/GhostSystem.h"
+#include "systems/SpawnPlacer.h"
+
+struct Metrics;
+
+enum class GameState {
+    Menu,
+    Playing,
+    GameOver,
+    Win
+};
+
+// Everything Simulation::Update reads or changes between ticks, for
+// rollback. Saving into a state that already holds one of the same match
+// reuses its buffers, and its pellet plane is brought up to date from the
+// map's consumed-pellet log rather than copied whole.
+struct SimulationState {
+    Player playerA{};
+    Player playerB{};
+    GhostArray ghosts{};
+    GhostScheduler::State schedule{};
+    GameState state = GameState::Menu;
+    uint64_t tick = 0;
+
+    std::vector<uint64_t> pellets{};
+    int remainingPellets = 0;
+    uint32_t pelletGeneration = 0;
+    size_t pelletsApplied = 0;
+};
+
+// Owns one match worth of game state and advances it in fixed steps.
+// Nothing in here touches the window, the clock or the keyboard, so it can
+// run headless on machines without a display.
+class Simulation {
+public:
+    explicit Simulation(int tilePixelSize = 24);
+
+    bool LoadMap(const std::string& path);
+    void Update(const InputFrame& input, float deltaSeconds);
+    void ResetSession();
+    void ResetToMenu();
+    // Resets and skips the menu, as pressing start would.
+    void StartMatch();
+
+    const TileMap& GetMap() const { return map_; }
+    const Player& GetPlayerA() const { return playerA_; }
+    const Player& GetPlayerB() const { return playerB_; }
+    const GhostArray& GetGhosts() const { return ghosts_; }
+    GameState GetState() const { return state_; }
+    uint64_t GetTick() const { return tick_; }
+    // Bumped by every reset, which puts players and ghosts back on their
+    // spawns at once.
+    uint64_t GetResetCount() const { return resetCount_; }
+
+    // Copies the match out and back in. Settings (ghost count, kernel,
+    // schedule rules, targeting) and the loaded map are not part of it.
+    void SaveState(SimulationState& out) const;
+    void LoadState(const SimulationState& in);
+
+    // FNV-1a over the raw bits of everything Update can change. Two runs
+    // that agree on this hash played out identically.
+    uint64_t ComputeStateHash() const;
+
+    // Ghosts spawned per match; takes effect at the next reset. Stress runs
+    // use thousands, far more than the map has spawn tiles.
+    void SetGhostCount(int count) { ghostCount_ = count > 0 ? count : 0; }
+    int GetGhostCount() const { return ghostCount_; }
+    // Constraints for ghosts the map has no G spawn for; they are placed
+    // outward from the map centre. Takes effect at the next reset.
+    void SetGhostSpawnRules(const SpawnPlacementRules& rules) { spawnRules_ = rules; }
+    const SpawnPlacementRules& GetGhostSpawnRules() const { return spawnRules_; }
+    // Changes how ghosts move, so recordings store it. Takes effect at the next reset.
+    void SetGhostTargeting(GhostTargeting targeting) { ghostTargeting_ = targeting; }
+    GhostTargeting GetGhostTargeting() const { return ghostTargeting_; }
+    void SetGhostKernel(GhostKernel kernel) { ghostSystem_.SetKernel(kernel); }
+    GhostKernel GetGhostKernel() const { return ghostSystem_.GetKernel(); }
+    void SetCaptureCheck(CaptureCheck check) { ghostSystem_.SetCaptureCheck(check); }
+    CaptureCheck GetCaptureCheck() const { return ghostSystem_.GetCaptureCheck(); }
+    void SetGhostSchedule(GhostSchedule schedule) { ghostSystem_.SetSchedule(schedule); }
+    GhostSchedule GetGhostSchedule() const { return ghostSystem_.GetSchedule(); }
+    void SetGhostScheduleRules(const GhostScheduleRules& rules) { ghostSystem_.SetScheduleRules(rules); }
+    const GhostScheduleRules& GetGhostScheduleRules() const { return ghostSystem_.GetScheduleRules(); }
+    const GhostScheduleStats& GetGhostScheduleStats() const { return ghostSystem_.GetScheduleStats(); }
+    const HierarchicalPathfinder::Stats& GetPathfinderStats() const { return ghostSystem_.GetPathfinderStats(); }
+
+    // Counts ticks, pellets, captures and resets into `metrics` and times
+    // the ghost update; nullptr (the default) records nothing.
+    void SetMetrics(Metrics* metrics) { metrics_ = metrics; }
+
+    int GetTilePixelSize() const { return tilePixelSize_; }
+    int GetMapPixelWidth() const { return mapPixelWidth_; }
+    int GetMapPixelHeight() const { return mapPixelHeight_; }
+
+private:
+    // pacmen_bench times the private per-tick helpers directly.
+    friend class SimulationBenchAccess;
+
+    void TryMovePlayer(Player& player, Vector2 direction, float deltaSeconds);
+    Vector2 TileToWorldCenter(Vector2 tile) const;
+    void InitializeGhosts();
+    void FindFallbackGhostSpawns(int needed, const std::vector<Vector2>& usedTiles, std::vector<Vector2>& out);
+    void HandlePelletPickup(Player& player);
+
+    TileMap map_;
+
+    const int tilePixelSize_;
+
+    Player playerA_{};
+    Player playerB_{};
+    GhostArray ghosts_{};
+    GhostSystem ghostSystem_{};
+    SpawnPlacer spawnPlacer_{};
+    SpawnPlacementRules spawnRules_{};
+    // Tiles the last player sweep passed through; reused to avoid allocating.
+    std::vector<uint32_t> sweptTiles_{};
+    // Spawn tiles of the last match start and the placer's share of them;
+    // reused so restarting a match does not allocate.
+    std::vector<Vector2> spawnTiles_{};
+    std::vector<Vector2> fallbackSpawns_{};
+
+    int ghostCount_ = 6;
+    GhostTargeting ghostTargeting_ = GhostTargeting::ChaseOnly;
+    int mapPixelWidth_ = 0;
+    int mapPixelHeight_ = 0;
+    GameState state_ = GameState::Menu;
+    uint64_t tick_ = 0;
+    uint64_t resetCount_ = 0;
+    Metrics* metrics_ = nullptr;
+};
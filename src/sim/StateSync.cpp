@@ -0,0 +1,639 @@
+#include "sim/StateSync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "sim/Profiler.h"
+
+namespace {
+    constexpr uint32_t kFrameMagic = 0x53534D50; // "PMSS"
+    constexpr uint32_t kAckMagic = 0x41534D50;   // "PMSA"
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kFragmentMagic = 0x46534D50; // "PMSF"
+    constexpr size_t kAckBytes = 8;
+    // The largest UDP payload over IPv4. A frame that does not fit, such as
+    // a keyframe of thousands of ghosts or a big map's pellet plane, goes
+    // out as several fragments.
+    constexpr size_t kMaxDatagramBytes = 65507;
+    constexpr size_t kFragmentHeaderBytes = 12;
+    constexpr size_t kFragmentPayloadBytes = kMaxDatagramBytes - kFragmentHeaderBytes;
+
+    // Positions and radii travel as whole eighths of a pixel.
+    constexpr float kPositionScale = 8.0f;
+
+    enum PelletMode : uint32_t {
+        kPelletsUnchanged = 0,
+        // Tiles eaten since the baseline, in the order they were eaten.
+        kPelletsEaten = 1,
+        // The whole plane; keyframes and resets.
+        kPelletsPlane = 2
+    };
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int32_t Quantise(float value) {
+        return static_cast<int32_t>(std::lround(value * kPositionScale));
+    }
+
+    uint32_t ColorBits(Color color) {
+        return static_cast<uint32_t>(color.r) | static_cast<uint32_t>(color.g) << 8
+            | static_cast<uint32_t>(color.b) << 16 | static_cast<uint32_t>(color.a) << 24;
+    }
+
+    Color BitsColor(uint32_t bits) {
+        return Color{ static_cast<unsigned char>(bits), static_cast<unsigned char>(bits >> 8),
+                      static_cast<unsigned char>(bits >> 16), static_cast<unsigned char>(bits >> 24) };
+    }
+
+    size_t FragmentCount(size_t frameBytes) {
+        return std::max<size_t>(1, (frameBytes + kFragmentPayloadBytes - 1) / kFragmentPayloadBytes);
+    }
+
+    // Datagram layout, in host byte order like the acks: magic u32, frame sequence u32,
+    // fragment index u16, fragment count u16, then that slice of the frame.
+    // The datagrams are laid end to end in `out`, each kMaxDatagramBytes
+    // apart but the last.
+    void SplitFrame(uint32_t sequence, const std::vector<uint8_t>& frame, std::vector<uint8_t>& out) {
+        const size_t count = FragmentCount(frame.size());
+        out.resize(frame.size() + count * kFragmentHeaderBytes);
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t* datagram = out.data() + i * kMaxDatagramBytes;
+            const size_t offset = i * kFragmentPayloadBytes;
+            const size_t size = std::min(kFragmentPayloadBytes, frame.size() - offset);
+            const uint16_t index = static_cast<uint16_t>(i);
+            const uint16_t total = static_cast<uint16_t>(count);
+            std::memcpy(datagram, &kFragmentMagic, sizeof(kFragmentMagic));
+            std::memcpy(datagram + 4, &sequence, sizeof(sequence));
+            std::memcpy(datagram + 8, &index, sizeof(index));
+            std::memcpy(datagram + 10, &total, sizeof(total));
+            std::memcpy(datagram + kFragmentHeaderBytes, frame.data() + offset, size);
+        }
+    }
+
+    // Bits needed to tell `count` values apart.
+    int BitsFor(uint64_t count) {
+        int bits = 1;
+        while (bits < 32 && (uint64_t{ 1 } << bits) < count) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // Least significant bit first, so a reader can pull fields out with
+    // shifts and masks alone.
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : out_(out) { out_.clear(); }
+
+        // count <= 32.
+        void Write(uint32_t value, int count) {
+            pending_ |= (static_cast<uint64_t>(value) & ((uint64_t{ 1 } << count) - 1)) << pendingBits_;
+            pendingBits_ += count;
+            while (pendingBits_ >= 8) {
+                out_.push_back(static_cast<uint8_t>(pending_));
+                pending_ >>= 8;
+                pendingBits_ -= 8;
+            }
+        }
+
+        // Small values are the common case: two bits pick a width of 4, 8,
+        // 16 or 32 bits.
+        void WriteUnsigned(uint32_t value) {
+            if (value < (1u << 4)) {
+                Write(0, 2);
+                Write(value, 4);
+            } else if (value < (1u << 8)) {
+                Write(1, 2);
+                Write(value, 8);
+            } else if (value < (1u << 16)) {
+                Write(2, 2);
+                Write(value, 16);
+            } else {
+                Write(3, 2);
+                Write(value, 32);
+            }
+        }
+
+        void WriteSigned(int32_t value) {
+            // Zigzag, so small negative deltas stay small.
+            const uint32_t bits = static_cast<uint32_t>(value);
+            WriteUnsigned((bits << 1) ^ static_cast<uint32_t>(value >> 31));
+        }
+
+        // A changed bit, then the delta when it is not zero.
+        void WriteDelta(int32_t value, int32_t base) {
+            const int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(value) - static_cast<uint32_t>(base));
+            Write(delta != 0 ? 1 : 0, 1);
+            if (delta != 0) {
+                WriteSigned(delta);
+            }
+        }
+
+        void Finish() {
+            if (pendingBits_ > 0) {
+                out_.push_back(static_cast<uint8_t>(pending_));
+            }
+            pending_ = 0;
+            pendingBits_ = 0;
+        }
+
+    private:
+        std::vector<uint8_t>& out_;
+        uint64_t pending_ = 0;
+        int pendingBits_ = 0;
+    };
+
+    // Reads past the end latch `ok` to false and return zeros.
+    class BitReader {
+    public:
+        BitReader(const uint8_t* data, size_t size) : data_(data), bitCount_(size * 8) {}
+
+        uint32_t Read(int count) {
+            if (position_ + static_cast<size_t>(count) > bitCount_) {
+                ok = false;
+                position_ = bitCount_;
+                return 0;
+            }
+            uint64_t value = 0;
+            int got = 0;
+            while (got < count) {
+                const size_t byte = position_ >> 3;
+                const int shift = static_cast<int>(position_ & 7);
+                const int take = std::min(8 - shift, count - got);
+                value |= static_cast<uint64_t>((data_[byte] >> shift) & ((1u << take) - 1)) << got;
+                got += take;
+                position_ += static_cast<size_t>(take);
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        uint32_t ReadUnsigned() {
+            static constexpr int kWidths[4] = { 4, 8, 16, 32 };
+            return Read(kWidths[Read(2)]);
+        }
+
+        int32_t ReadSigned() {
+            const uint32_t bits = ReadUnsigned();
+            return static_cast<int32_t>((bits >> 1) ^ (0u - (bits & 1)));
+        }
+
+        int32_t ReadDelta(int32_t base) {
+            if (Read(1) == 0) {
+                return base;
+            }
+            return static_cast<int32_t>(static_cast<uint32_t>(base) + static_cast<uint32_t>(ReadSigned()));
+        }
+
+        bool ok = true;
+
+    private:
+        const uint8_t* data_;
+        size_t bitCount_;
+        size_t position_ = 0;
+    };
+}
+
+int SyncServer::AddClient(NetTransport& transport) {
+    clients_.push_back(Client{ &transport, 0 });
+    return static_cast<int>(clients_.size()) - 1;
+}
+
+void SyncServer::Poll() {
+    uint8_t buffer[kAckBytes];
+    for (Client& client : clients_) {
+        while (const size_t size = client.transport->Receive(buffer, sizeof(buffer))) {
+            uint32_t magic;
+            uint32_t sequence;
+            std::memcpy(&magic, buffer, sizeof(magic));
+            std::memcpy(&sequence, buffer + 4, sizeof(sequence));
+            if (size == kAckBytes && magic == kAckMagic && sequence <= sequence_ && sequence > client.acked) {
+                client.acked = sequence;
+            }
+        }
+    }
+}
+
+void SyncServer::Broadcast(const Simulation& simulation) {
+    PACMEN_PROFILE_ZONE("SyncServer::Broadcast");
+    ++stats_.broadcasts;
+    int64_t start = NowNs();
+    ++sequence_;
+    SyncFrame& frame = history_[sequence_ % kHistory];
+    Capture(simulation, frame);
+    int64_t now = NowNs();
+    stats_.captureNs += now - start;
+
+    // Spectators are grouped by the frame they acknowledged; each group's
+    // delta is encoded once and the same bytes go to all of them.
+    encodedBaselines_.clear();
+    int64_t encodeNs = 0;
+    start = now;
+    for (Client& client : clients_) {
+        const uint32_t age = sequence_ - client.acked;
+        const bool hasBaseline = client.acked != 0 && age < kHistory
+            && history_[client.acked % kHistory].sequence == client.acked;
+        const uint32_t baseline = hasBaseline ? client.acked : 0;
+
+        size_t group = 0;
+        while (group < encodedBaselines_.size() && encodedBaselines_[group] != baseline) {
+            ++group;
+        }
+        if (group == encodedBaselines_.size()) {
+            const int64_t encodeStart = NowNs();
+            encodedBaselines_.push_back(baseline);
+            if (encoded_.size() < encodedBaselines_.size()) {
+                encoded_.emplace_back();
+            }
+            Encode(simulation, frame, hasBaseline ? &history_[baseline % kHistory] : nullptr, frameBytes_);
+            SplitFrame(frame.sequence, frameBytes_, encoded_[group]);
+            ++stats_.encodes;
+            stats_.keyframes += hasBaseline ? 0 : 1;
+            encodeNs += NowNs() - encodeStart;
+        }
+
+        const std::vector<uint8_t>& bytes = encoded_[group];
+        for (size_t offset = 0; offset < bytes.size(); offset += kMaxDatagramBytes) {
+            client.transport->Send(bytes.data() + offset, std::min(kMaxDatagramBytes, bytes.size() - offset));
+            ++stats_.packetsSent;
+        }
+        ++stats_.framesSent;
+        stats_.bytesSent += bytes.size();
+    }
+    now = NowNs();
+    stats_.encodeNs += encodeNs;
+    stats_.sendNs += now - start - encodeNs;
+}
+
+void SyncServer::Capture(const Simulation& simulation, SyncFrame& frame) {
+    const Player* players[2] = { &simulation.GetPlayerA(), &simulation.GetPlayerB() };
+    const GhostArray& ghosts = simulation.GetGhosts();
+    const TileMap& map = simulation.GetMap();
+
+    frame.sequence = sequence_;
+    frame.tick = static_cast<uint32_t>(simulation.GetTick());
+    frame.state = simulation.GetState();
+    for (int i = 0; i < 2; ++i) {
+        frame.playerX[i] = Quantise(players[i]->position.x);
+        frame.playerY[i] = Quantise(players[i]->position.y);
+        frame.playerScore[i] = players[i]->score;
+        frame.playerLives[i] = players[i]->lives;
+    }
+    const size_t ghostCount = ghosts.Size();
+    frame.ghostX.resize(ghostCount);
+    frame.ghostY.resize(ghostCount);
+    for (size_t i = 0; i < ghostCount; ++i) {
+        frame.ghostX[i] = Quantise(ghosts.positionX[i]);
+        frame.ghostY[i] = Quantise(ghosts.positionY[i]);
+    }
+    frame.remainingPellets = map.GetRemainingPellets();
+    frame.pelletGeneration = map.GetPelletGeneration();
+    frame.pelletsApplied = map.GetConsumedPellets().size();
+
+    // Colours and radii only change when ghosts respawn; compare rather
+    // than resend them every frame. Players come first.
+    bool rosterChanged = rosterColors_.size() != ghostCount + 2;
+    if (!rosterChanged) {
+        for (int i = 0; i < 2 && !rosterChanged; ++i) {
+            rosterChanged = ColorBits(rosterColors_[i]) != ColorBits(players[i]->color)
+                || rosterRadii_[i] != players[i]->radius;
+        }
+        rosterChanged = rosterChanged
+            || std::memcmp(rosterColors_.data() + 2, ghosts.color.data(), ghostCount * sizeof(Color)) != 0
+            || std::memcmp(rosterRadii_.data() + 2, ghosts.radius.data(), ghostCount * sizeof(float)) != 0;
+    }
+    if (rosterChanged) {
+        rosterColors_.assign({ players[0]->color, players[1]->color });
+        rosterColors_.insert(rosterColors_.end(), ghosts.color.begin(), ghosts.color.end());
+        rosterRadii_.assign({ players[0]->radius, players[1]->radius });
+        rosterRadii_.insert(rosterRadii_.end(), ghosts.radius.begin(), ghosts.radius.end());
+        ++rosterRevision_;
+    }
+    frame.rosterRevision = rosterRevision_;
+}
+
+// Layout, as a bit stream: magic 32, version 8, sequence 32, tick 32,
+// keyframe 1 [baseline sequence 32], state 2, roster 1 [roster], each
+// player's x, y, score and lives as deltas, each ghost's moved bit and x/y
+// deltas, remaining pellets as a delta, then the pellet mode 2 and its
+// payload. Keyframes are deltas against all zeros.
+void SyncServer::Encode(const Simulation& simulation, const SyncFrame& frame, const SyncFrame* baseline,
+                        std::vector<uint8_t>& out) const {
+    static const SyncFrame kZero{};
+    const SyncFrame& base = baseline != nullptr ? *baseline : kZero;
+    BitWriter writer(out);
+    writer.Write(kFrameMagic, 32);
+    writer.Write(kVersion, 8);
+    writer.Write(frame.sequence, 32);
+    writer.Write(frame.tick, 32);
+    writer.Write(baseline == nullptr ? 1 : 0, 1);
+    if (baseline != nullptr) {
+        writer.Write(baseline->sequence, 32);
+    }
+    writer.Write(static_cast<uint32_t>(frame.state), 2);
+
+    const bool sendRoster = baseline == nullptr || baseline->rosterRevision != frame.rosterRevision;
+    writer.Write(sendRoster ? 1 : 0, 1);
+    if (sendRoster) {
+        writer.Write(frame.rosterRevision, 32);
+        writer.Write(static_cast<uint32_t>(frame.ghostX.size()), 32);
+        for (size_t i = 0; i < rosterColors_.size(); ++i) {
+            writer.Write(ColorBits(rosterColors_[i]), 32);
+            writer.Write(static_cast<uint32_t>(Quantise(rosterRadii_[i])), 16);
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        writer.WriteDelta(frame.playerX[i], base.playerX[i]);
+        writer.WriteDelta(frame.playerY[i], base.playerY[i]);
+        writer.WriteDelta(frame.playerScore[i], base.playerScore[i]);
+        writer.WriteDelta(frame.playerLives[i], base.playerLives[i]);
+    }
+
+    // A respawn changes the count and bumps the roster; the new ghosts are
+    // then sent against zeros like a keyframe's.
+    const bool sameGhosts = base.ghostX.size() == frame.ghostX.size();
+    for (size_t i = 0; i < frame.ghostX.size(); ++i) {
+        const int32_t baseX = sameGhosts ? base.ghostX[i] : 0;
+        const int32_t baseY = sameGhosts ? base.ghostY[i] : 0;
+        const bool moved = frame.ghostX[i] != baseX || frame.ghostY[i] != baseY;
+        writer.Write(moved ? 1 : 0, 1);
+        if (moved) {
+            writer.WriteSigned(frame.ghostX[i] - baseX);
+            writer.WriteSigned(frame.ghostY[i] - baseY);
+        }
+    }
+    writer.WriteDelta(frame.remainingPellets, base.remainingPellets);
+
+    // The consumed log only grows within a generation, so the baseline's
+    // position in it marks exactly the pellets eaten since.
+    const TileMap& map = simulation.GetMap();
+    const std::vector<uint32_t>& eaten = map.GetConsumedPellets();
+    if (baseline != nullptr && baseline->pelletGeneration == frame.pelletGeneration
+        && baseline->pelletsApplied <= frame.pelletsApplied) {
+        const size_t count = frame.pelletsApplied - baseline->pelletsApplied;
+        writer.Write(count == 0 ? kPelletsUnchanged : kPelletsEaten, 2);
+        if (count > 0) {
+            const int indexBits = BitsFor(static_cast<uint64_t>(map.GetWidth()) * map.GetHeight());
+            writer.WriteUnsigned(static_cast<uint32_t>(count));
+            for (size_t i = baseline->pelletsApplied; i < frame.pelletsApplied; ++i) {
+                writer.Write(eaten[i], indexBits);
+            }
+        }
+    } else {
+        writer.Write(kPelletsPlane, 2);
+        writer.Write(static_cast<uint32_t>(map.GetWidth()), 16);
+        writer.Write(static_cast<uint32_t>(map.GetHeight()), 16);
+        const size_t wordCount = static_cast<size_t>(map.GetWordsPerRow()) * map.GetHeight();
+        const uint64_t* words = map.GetPelletWords();
+        for (size_t i = 0; i < wordCount; ++i) {
+            writer.Write(static_cast<uint32_t>(words[i]), 32);
+            writer.Write(static_cast<uint32_t>(words[i] >> 32), 32);
+        }
+    }
+    writer.Finish();
+}
+
+bool SyncClient::Poll() {
+    buffer_.resize(kMaxDatagramBytes);
+    bool advanced = false;
+    while (const size_t size = transport_.Receive(buffer_.data(), buffer_.size())) {
+        stats_.bytesReceived += size;
+        const uint8_t* frame = nullptr;
+        size_t frameSize = 0;
+        if (!Reassemble(buffer_.data(), size, frame, frameSize)) {
+            continue;
+        }
+        if (Decode(frame, frameSize)) {
+            ++stats_.framesDecoded;
+            advanced = true;
+        } else {
+            ++stats_.framesDropped;
+        }
+    }
+    if (advanced) {
+        SendAck();
+    }
+    return advanced;
+}
+
+bool SyncClient::Reassemble(const uint8_t* data, size_t size, const uint8_t*& frame, size_t& frameSize) {
+    if (size < kFragmentHeaderBytes) {
+        return false;
+    }
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t index;
+    uint16_t count;
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&sequence, data + 4, sizeof(sequence));
+    std::memcpy(&index, data + 8, sizeof(index));
+    std::memcpy(&count, data + 10, sizeof(count));
+    const uint8_t* payload = data + kFragmentHeaderBytes;
+    const size_t payloadSize = size - kFragmentHeaderBytes;
+    // Every fragment but the last is full.
+    if (magic != kFragmentMagic || count == 0 || index >= count
+        || (index + 1 < count && payloadSize != kFragmentPayloadBytes) || sequence <= view_.sequence) {
+        return false;
+    }
+    if (count == 1) {
+        frame = payload;
+        frameSize = payloadSize;
+        return true;
+    }
+
+    // One frame is put together at a time. Fragments of an older one are
+    // dropped; a newer one takes over, abandoning whatever was missing.
+    if (sequence != assemblySequence_ || count != fragmentsSeen_.size()) {
+        if (sequence < assemblySequence_) {
+            return false;
+        }
+        if (fragmentsMissing_ > 0) {
+            ++stats_.framesDropped;
+        }
+        assemblySequence_ = sequence;
+        fragmentsSeen_.assign(count, 0);
+        fragmentsMissing_ = count;
+        assembly_.resize(static_cast<size_t>(count) * kFragmentPayloadBytes);
+        assemblySize_ = 0;
+    }
+    if (fragmentsSeen_[index] != 0) {
+        return false;
+    }
+    fragmentsSeen_[index] = 1;
+    --fragmentsMissing_;
+    std::memcpy(assembly_.data() + static_cast<size_t>(index) * kFragmentPayloadBytes, payload, payloadSize);
+    if (index + 1 == count) {
+        assemblySize_ = static_cast<size_t>(index) * kFragmentPayloadBytes + payloadSize;
+    }
+    if (fragmentsMissing_ > 0) {
+        return false;
+    }
+    frame = assembly_.data();
+    frameSize = assemblySize_;
+    return true;
+}
+
+void SyncClient::SendAck() {
+    uint8_t packet[kAckBytes];
+    std::memcpy(packet, &kAckMagic, sizeof(kAckMagic));
+    std::memcpy(packet + 4, &view_.sequence, sizeof(view_.sequence));
+    transport_.Send(packet, sizeof(packet));
+}
+
+bool SyncClient::Decode(const uint8_t* data, size_t size) {
+    PACMEN_PROFILE_ZONE("SyncClient::Decode");
+    BitReader reader(data, size);
+    if (reader.Read(32) != kFrameMagic || reader.Read(8) != kVersion) {
+        return false;
+    }
+    const uint32_t sequence = reader.Read(32);
+    const uint32_t tick = reader.Read(32);
+    const bool keyframe = reader.Read(1) != 0;
+    const uint32_t baselineSequence = keyframe ? 0 : reader.Read(32);
+    // Frames that arrive late are of no use once a newer one is shown.
+    if (!reader.ok || sequence <= view_.sequence) {
+        return false;
+    }
+
+    static const SyncFrame kZero{};
+    const SyncFrame* baseline = &kZero;
+    if (!keyframe) {
+        const SyncFrame& candidate = history_[baselineSequence % SyncServer::kHistory];
+        if (candidate.sequence != baselineSequence || sequence - baselineSequence >= SyncServer::kHistory) {
+            return false;
+        }
+        baseline = &candidate;
+    }
+
+    // Everything is read into scratch first so a truncated packet cannot
+    // leave the view half updated.
+    SyncFrame& frame = scratch_;
+    frame.sequence = sequence;
+    frame.tick = tick;
+    frame.state = static_cast<GameState>(reader.Read(2));
+
+    const bool hasRoster = reader.Read(1) != 0;
+    size_t ghostCount = baseline->ghostX.size();
+    if (hasRoster) {
+        frame.rosterRevision = reader.Read(32);
+        ghostCount = reader.Read(32);
+        if (!reader.ok || ghostCount > size * 8) {
+            return false;
+        }
+        rosterColors_.resize(ghostCount + 2);
+        rosterRadii_.resize(ghostCount + 2);
+        for (size_t i = 0; i < ghostCount + 2; ++i) {
+            rosterColors_[i] = BitsColor(reader.Read(32));
+            rosterRadii_[i] = static_cast<float>(reader.Read(16)) / kPositionScale;
+        }
+    } else {
+        if (baseline->rosterRevision != rosterRevision_) {
+            return false;
+        }
+        frame.rosterRevision = baseline->rosterRevision;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        frame.playerX[i] = reader.ReadDelta(baseline->playerX[i]);
+        frame.playerY[i] = reader.ReadDelta(baseline->playerY[i]);
+        frame.playerScore[i] = reader.ReadDelta(baseline->playerScore[i]);
+        frame.playerLives[i] = reader.ReadDelta(baseline->playerLives[i]);
+    }
+
+    const bool sameGhosts = baseline->ghostX.size() == ghostCount;
+    frame.ghostX.resize(ghostCount);
+    frame.ghostY.resize(ghostCount);
+    for (size_t i = 0; i < ghostCount && reader.ok; ++i) {
+        frame.ghostX[i] = sameGhosts ? baseline->ghostX[i] : 0;
+        frame.ghostY[i] = sameGhosts ? baseline->ghostY[i] : 0;
+        if (reader.Read(1) != 0) {
+            frame.ghostX[i] += reader.ReadSigned();
+            frame.ghostY[i] += reader.ReadSigned();
+        }
+    }
+    frame.remainingPellets = reader.ReadDelta(baseline->remainingPellets);
+
+    const uint32_t pelletMode = reader.Read(2);
+    int mapWidth = view_.mapWidth;
+    int mapHeight = view_.mapHeight;
+    eaten_.clear();
+    if (pelletMode == kPelletsEaten) {
+        if (mapWidth == 0) {
+            return false;
+        }
+        const int indexBits = BitsFor(static_cast<uint64_t>(mapWidth) * mapHeight);
+        const uint32_t count = reader.ReadUnsigned();
+        if (!reader.ok || count > size * 8) {
+            return false;
+        }
+        eaten_.resize(count);
+        for (uint32_t& index : eaten_) {
+            index = reader.Read(indexBits);
+        }
+    } else if (pelletMode == kPelletsPlane) {
+        mapWidth = static_cast<int>(reader.Read(16));
+        mapHeight = static_cast<int>(reader.Read(16));
+        const size_t wordCount = static_cast<size_t>((mapWidth + 63) / 64) * mapHeight;
+        if (!reader.ok || wordCount * 64 > size * 8) {
+            return false;
+        }
+        plane_.resize(wordCount);
+        for (uint64_t& word : plane_) {
+            word = reader.Read(32);
+            word |= static_cast<uint64_t>(reader.Read(32)) << 32;
+        }
+    }
+    if (!reader.ok) {
+        return false;
+    }
+
+    // Commit. Applying the pellets eaten since the baseline to a newer
+    // plane is harmless: clearing a bit twice changes nothing.
+    if (hasRoster) {
+        view_.playerColor = { rosterColors_[0], rosterColors_[1] };
+        view_.playerRadius = { rosterRadii_[0], rosterRadii_[1] };
+        view_.ghostColor.assign(rosterColors_.begin() + 2, rosterColors_.end());
+        view_.ghostRadius.assign(rosterRadii_.begin() + 2, rosterRadii_.end());
+        rosterRevision_ = frame.rosterRevision;
+    }
+    if (pelletMode == kPelletsPlane) {
+        view_.mapWidth = mapWidth;
+        view_.mapHeight = mapHeight;
+        view_.wordsPerRow = (mapWidth + 63) / 64;
+        view_.pellets.swap(plane_);
+    } else if (pelletMode == kPelletsEaten) {
+        const uint32_t width = static_cast<uint32_t>(view_.mapWidth);
+        const size_t wordsPerRow = static_cast<size_t>(view_.wordsPerRow);
+        for (const uint32_t index : eaten_) {
+            const size_t word = (index / width) * wordsPerRow + ((index % width) >> 6);
+            if (word < view_.pellets.size()) {
+                view_.pellets[word] &= ~(uint64_t{ 1 } << ((index % width) & 63));
+            }
+        }
+    }
+
+    view_.sequence = frame.sequence;
+    view_.tick = frame.tick;
+    view_.state = frame.state;
+    for (int i = 0; i < 2; ++i) {
+        view_.playerPosition[i] = Vector2{ frame.playerX[i] / kPositionScale, frame.playerY[i] / kPositionScale };
+        view_.playerScore[i] = frame.playerScore[i];
+        view_.playerLives[i] = frame.playerLives[i];
+    }
+    view_.ghostX.resize(ghostCount);
+    view_.ghostY.resize(ghostCount);
+    for (size_t i = 0; i < ghostCount; ++i) {
+        view_.ghostX[i] = frame.ghostX[i] / kPositionScale;
+        view_.ghostY[i] = frame.ghostY[i] / kPositionScale;
+    }
+    view_.remainingPellets = frame.remainingPellets;
+
+    // Keep the frame as a baseline for later deltas.
+    std::swap(history_[sequence % SyncServer::kHistory], scratch_);
+    return true;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+#include "sim/NetTransport.h"
+#include "sim/Simulation.h"
+
+// What a spectator sees of a match: positions to 1/8 pixel, scores, lives
+// and the pellet plane (laid out as in TileMap::GetPelletWords). Walls are
+// not sent; a spectator loads the same map.
+struct SyncView {
+    uint32_t sequence = 0;
+    uint32_t tick = 0;
+    GameState state = GameState::Menu;
+
+    std::array<Vector2, 2> playerPosition{};
+    std::array<int, 2> playerScore{};
+    std::array<int, 2> playerLives{};
+    std::array<Color, 2> playerColor{};
+    std::array<float, 2> playerRadius{};
+
+    std::vector<float> ghostX{};
+    std::vector<float> ghostY{};
+    std::vector<Color> ghostColor{};
+    std::vector<float> ghostRadius{};
+
+    int mapWidth = 0;
+    int mapHeight = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> pellets{};
+    int remainingPellets = 0;
+};
+
+// One broadcast, quantised. Servers and spectators keep a ring of these to
+// encode and decode deltas against.
+struct SyncFrame {
+    uint32_t sequence = 0;
+    uint32_t tick = 0;
+    GameState state = GameState::Menu;
+    std::array<int32_t, 2> playerX{};
+    std::array<int32_t, 2> playerY{};
+    std::array<int32_t, 2> playerScore{};
+    std::array<int32_t, 2> playerLives{};
+    std::vector<int32_t> ghostX{};
+    std::vector<int32_t> ghostY{};
+    // Bumped whenever colours, radii or the ghost count change.
+    uint32_t rosterRevision = 0;
+    int32_t remainingPellets = 0;
+    // Server side only: where the map's consumed-pellet log stood.
+    uint32_t pelletGeneration = 0;
+    size_t pelletsApplied = 0;
+};
+
+struct SyncServerStats {
+    uint64_t broadcasts = 0;
+    // Distinct encodings made; each one goes to every spectator that
+    // acknowledged the same frame.
+    uint64_t encodes = 0;
+    uint64_t keyframes = 0;
+    // One frame per spectator per broadcast, in one datagram or several.
+    uint64_t framesSent = 0;
+    uint64_t packetsSent = 0;
+    uint64_t bytesSent = 0;
+    int64_t captureNs = 0;
+    int64_t encodeNs = 0;
+    int64_t sendNs = 0;
+};
+
+struct SyncClientStats {
+    uint64_t framesDecoded = 0;
+    // Frames that arrived after a newer one, whose baseline had already
+    // left the ring, or that lost a fragment.
+    uint64_t framesDropped = 0;
+    uint64_t bytesReceived = 0;
+};
+
+// Broadcasts a running Simulation to spectators. Each frame is a delta
+// against the last frame the spectator acknowledged: only positions that
+// moved, scores and lives that changed, and the pellets eaten since (taken
+// from the map's consumed-pellet log). Spectators that acknowledged the
+// same frame get the same bytes, so the cost grows with the number of
+// distinct baselines, not viewers. Anyone too far behind gets a keyframe.
+// Frames too big for one datagram are split into numbered fragments, and
+// a frame missing any of them is dropped like a lost one.
+class SyncServer {
+public:
+    static constexpr int kHistory = 32;
+
+    // Returns the client's index. `transport` must outlive the server.
+    int AddClient(NetTransport& transport);
+
+    // Reads acknowledgements; call at least once per broadcast.
+    void Poll();
+    // Captures the simulation as the next frame and sends it to everyone.
+    void Broadcast(const Simulation& simulation);
+
+    uint32_t GetSequence() const { return sequence_; }
+    const SyncServerStats& GetStats() const { return stats_; }
+
+private:
+    struct Client {
+        NetTransport* transport = nullptr;
+        // Latest frame the client has decoded; 0 is none.
+        uint32_t acked = 0;
+    };
+
+    void Capture(const Simulation& simulation, SyncFrame& frame);
+    void Encode(const Simulation& simulation, const SyncFrame& frame, const SyncFrame* baseline,
+                std::vector<uint8_t>& out) const;
+
+    std::vector<Client> clients_{};
+    std::array<SyncFrame, kHistory> history_{};
+    uint32_t sequence_ = 0;
+
+    // The roster as last captured, to notice when it changes.
+    std::vector<Color> rosterColors_{};
+    std::vector<float> rosterRadii_{};
+    uint32_t rosterRevision_ = 0;
+
+    // One encoding per distinct baseline this broadcast, already split
+    // into datagrams, reused across broadcasts to avoid allocating.
+    std::vector<uint32_t> encodedBaselines_{};
+    std::vector<std::vector<uint8_t>> encoded_{};
+    std::vector<uint8_t> frameBytes_{};
+    SyncServerStats stats_{};
+};
+
+// A spectator: decodes frames from a SyncServer into a SyncView and
+// acknowledges each one so the next delta can build on it.
+class SyncClient {
+public:
+    explicit SyncClient(NetTransport& transport) : transport_(transport) {}
+
+    // Takes in waiting frames; true if the view moved on.
+    bool Poll();
+
+    const SyncView& GetView() const { return view_; }
+    bool HasView() const { return view_.sequence != 0; }
+    const SyncClientStats& GetStats() const { return stats_; }
+
+private:
+    // Points `frame` at a whole frame once the datagram completes one.
+    bool Reassemble(const uint8_t* data, size_t size, const uint8_t*& frame, size_t& frameSize);
+    bool Decode(const uint8_t* data, size_t size);
+    void SendAck();
+
+    NetTransport& transport_;
+    std::array<SyncFrame, SyncServer::kHistory> history_{};
+    SyncView view_{};
+    uint32_t rosterRevision_ = 0;
+
+    // Decoding scratch, kept to avoid allocating per frame.
+    std::vector<uint8_t> buffer_{};
+    // The frame being put together from fragments.
+    std::vector<uint8_t> assembly_{};
+    std::vector<uint8_t> fragmentsSeen_{};
+    uint32_t assemblySequence_ = 0;
+    size_t fragmentsMissing_ = 0;
+    size_t assemblySize_ = 0;
+    SyncFrame scratch_{};
+    std::vector<Color> rosterColors_{};
+    std::vector<float> rosterRadii_{};
+    std::vector<uint32_t> eaten_{};
+    std::vector<uint64_t> plane_{};
+    SyncClientStats stats_{};
+};
@@ -0,0 +1,112 @@
+#include "sim/ThreadPool.h"
+
+#include <algorithm>
+
+#include "sim/Profiler.h"
+
+namespace {
+    // Which pool and deque the current thread works for, if any.
+    thread_local const ThreadPool* t_pool = nullptr;
+    thread_local size_t t_workerIndex = 0;
+}
+
+ThreadPool::ThreadPool(int threadCount) {
+    const size_t count = static_cast<size_t>(std::max(1, threadCount));
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+
+    threads_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        threads_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Follow-up work submitted by a task stays on that worker's own deque.
+    const size_t target = t_pool == this
+        ? t_workerIndex
+        : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    Worker& worker = *workers_[target];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    idle_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+bool ThreadPool::TryTake(size_t self, std::function<void()>& task) {
+    {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim = *workers_[(self + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t self) {
+    Profiler::SetThreadName("pool worker");
+    t_pool = this;
+    t_workerIndex = self;
+
+    std::function<void()> task;
+    for (;;) {
+        if (TryTake(self, task)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                idle_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (stopping_) {
+            return;
+        }
+    }
+}
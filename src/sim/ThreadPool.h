@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. Tasks submitted
+// from outside are dealt round-robin across the deques; tasks submitted by a
+// running task go to its own worker's deque. A worker takes its own newest
+// task first, and when its deque is empty it steals the oldest task from
+// another worker, so uneven tasks still keep every core busy.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task);
+    // Blocks until every submitted task has finished.
+    void Wait();
+
+    int GetThreadCount() const { return static_cast<int>(threads_.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool TryTake(size_t self, std::function<void()>& task);
+    void WorkerLoop(size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    // Tasks sitting in some deque, and tasks submitted but not yet finished.
+    std::atomic<int64_t> queued_{ 0 };
+    std::atomic<int64_t> pending_{ 0 };
+    std::atomic<uint32_t> nextWorker_{ 0 };
+    bool stopping_ = false;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the newest value from one writer thread to one
+// reader thread. There are three slots: the writer fills one, the reader
+// holds one, and the third is the newest published value. Publishing and
+// acquiring each swap a slot with that middle one in a single atomic
+// exchange, so neither side ever waits for the other, and the reader always
+// gets the newest value while skipping any it was too slow to see.
+//
+// Slots are reused, not cleared: a slot handed back to the writer still
+// holds whatever was published in it two rounds ago, which lets writers
+// update large members incrementally.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer only.
+    T& GetWriteSlot() { return slots_[writeIndex_]; }
+    void Publish() {
+        writeIndex_ = middle_.exchange(static_cast<uint8_t>(writeIndex_ | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader only. Swaps in the newest published value, if there is one
+    // the reader has not seen, and returns the reader's slot. The reference
+    // stays valid until the next call.
+    const T& AcquireLatest() {
+        if (middle_.load(std::memory_order_relaxed) & kFresh) {
+            readIndex_ = middle_.exchange(readIndex_, std::memory_order_acq_rel) & kIndexMask;
+        }
+        return slots_[readIndex_];
+    }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    T slots_[3]{};
+    alignas(64) std::atomic<uint8_t> middle_{ 1 };
+    alignas(64) uint8_t writeIndex_ = 0;
+    alignas(64) uint8_t readIndex_ = 2;
+};
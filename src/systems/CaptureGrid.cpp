@@ -0,0 +1,71 @@
+#include "systems/CaptureGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CaptureGrid::Build(const GhostArray& ghosts, float cellSize) {
+    const size_t count = ghosts.Size();
+    cellSize_ = cellSize;
+
+    size_t bucketCount = 1;
+    while (bucketCount < count) {
+        bucketCount <<= 1;
+    }
+    bucketMask_ = static_cast<uint32_t>(bucketCount - 1);
+
+    bucketStart_.assign(bucketCount + 1, 0);
+    ghostBucket_.resize(count);
+    entries_.resize(count);
+
+    maxGhostRadius_ = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t bucket = BucketOf(CellOf(ghosts.positionX[i]), CellOf(ghosts.positionY[i]));
+        ghostBucket_[i] = bucket;
+        ++bucketStart_[bucket];
+        maxGhostRadius_ = std::max(maxGhostRadius_, ghosts.radius[i]);
+    }
+
+    // Running sums turn each count into the end of its bucket; filling back
+    // to front then walks every end down to its bucket's start.
+    for (size_t bucket = 1; bucket <= bucketCount; ++bucket) {
+        bucketStart_[bucket] += bucketStart_[bucket - 1];
+    }
+    for (size_t i = count; i-- > 0;) {
+        entries_[--bucketStart_[ghostBucket_[i]]] = static_cast<uint32_t>(i);
+    }
+}
+
+bool CaptureGrid::AnyOverlap(const GhostArray& ghosts, Vector2 point, float radius) const {
+    if (entries_.empty()) {
+        return false;
+    }
+
+    // Pad the reach slightly so float rounding at a cell edge can never hide
+    // a ghost that the exact test below would accept.
+    const float reach = (radius + maxGhostRadius_) * 1.001f + 0.001f;
+    const int32_t minX = CellOf(point.x - reach);
+    const int32_t maxX = CellOf(point.x + reach);
+    const int32_t minY = CellOf(point.y - reach);
+    const int32_t maxY = CellOf(point.y + reach);
+
+    for (int32_t cellY = minY; cellY <= maxY; ++cellY) {
+        for (int32_t cellX = minX; cellX <= maxX; ++cellX) {
+            const uint32_t bucket = BucketOf(cellX, cellY);
+            for (uint32_t e = bucketStart_[bucket]; e < bucketStart_[bucket + 1]; ++e) {
+                const uint32_t i = entries_[e];
+                const float radiusSum = ghosts.radius[i] + radius;
+                const float dx = ghosts.positionX[i] - point.x;
+                const float dy = ghosts.positionY[i] - point.y;
+                if (dx * dx + dy * dy <= radiusSum * radiusSum) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+int32_t CaptureGrid::CellOf(float coordinate) const {
+    return static_cast<int32_t>(std::floor(coordinate / cellSize_));
+}
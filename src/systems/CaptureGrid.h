@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "entities/Ghost.h"
+
+// Spatial hash of ghost positions keyed on map cells, rebuilt each tick with
+// a counting sort. Memory scales with the ghost count, not the map area, so
+// it stays small on huge maps. Lookups visit only the cells a query circle
+// can touch and run the exact capture test on what they find.
+class CaptureGrid {
+public:
+    void Build(const GhostArray& ghosts, float cellSize);
+
+    // True if any ghost's circle overlaps the circle at `point`, using the
+    // same arithmetic as the brute-force check in the ghost kernels.
+    bool AnyOverlap(const GhostArray& ghosts, Vector2 point, float radius) const;
+
+private:
+    int32_t CellOf(float coordinate) const;
+    uint32_t BucketOf(int32_t cellX, int32_t cellY) const {
+        return ((static_cast<uint32_t>(cellX) * 73856093u) ^ (static_cast<uint32_t>(cellY) * 19349663u)) & bucketMask_;
+    }
+
+    float cellSize_ = 1.0f;
+    float maxGhostRadius_ = 0.0f;
+    uint32_t bucketMask_ = 0;
+    std::vector<uint32_t> bucketStart_{};
+    std::vector<uint32_t> entries_{};
+    std::vector<uint32_t> ghostBucket_{};
+};
@@ -0,0 +1,54 @@
+#include "systems/FlowField.h"
+
+void FlowField::Build(const TileMap& map, int targetX, int targetY) {
+    width_ = map.GetWidth();
+    height_ = map.GetHeight();
+    layoutRevision_ = map.GetLayoutRevision();
+    targetX_ = targetX;
+    targetY_ = targetY;
+    stride_ = width_ + 2;
+
+    const size_t cellCount = static_cast<size_t>(stride_) * (height_ + 2);
+    cells_.assign(cellCount, kUnreachable);
+    queue_.resize(cellCount);
+
+    if (targetX < 0 || targetY < 0 || targetX >= width_ || targetY >= height_) {
+        return;
+    }
+
+    size_t head = 0;
+    size_t tail = 0;
+    const int32_t start = (targetY + 1) * stride_ + (targetX + 1);
+    cells_[start] = 0;
+    queue_[tail++] = start;
+
+    const int32_t offsets[4] = { -1, -stride_, 1, stride_ };
+
+    while (head < tail) {
+        const int32_t cell = queue_[head++];
+        const int32_t nextDistance = cells_[cell] + 1;
+
+        for (int32_t offset : offsets) {
+            const int32_t neighbour = cell + offset;
+            if (cells_[neighbour] != kUnreachable) {
+                continue;
+            }
+
+            const int x = neighbour % stride_ - 1;
+            const int y = neighbour / stride_ - 1;
+            // Border cells report as walls, so the search never leaves the padded grid.
+            if (map.IsWall(x, y)) {
+                continue;
+            }
+
+            cells_[neighbour] = nextDistance;
+            queue_[tail++] = neighbour;
+        }
+    }
+}
+
+bool FlowField::IsBuiltFor(const TileMap& map, int targetX, int targetY) const {
+    return targetX == targetX_ && targetY == targetY_
+        && map.GetWidth() == width_ && map.GetHeight() == height_
+        && map.GetLayoutRevision() == layoutRevision_;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game/TileMap.h"
+
+// Breadth-first distance (in tiles) from every open tile to one target tile.
+// The grid carries a one-tile border of unreachable cells so callers can read
+// the neighbours of any in-map tile without bounds checks.
+class FlowField {
+public:
+    static constexpr int32_t kUnreachable = INT32_MAX;
+
+    void Build(const TileMap& map, int targetX, int targetY);
+    bool IsBuiltFor(const TileMap& map, int targetX, int targetY) const;
+
+    // Valid for -1 <= x <= width and -1 <= y <= height.
+    int32_t GetDistance(int x, int y) const { return cells_[(y + 1) * stride_ + (x + 1)]; }
+
+    int GetTargetX() const { return targetX_; }
+    int GetTargetY() const { return targetY_; }
+
+private:
+    std::vector<int32_t> cells_{};
+    std::vector<int32_t> queue_{};
+    int stride_ = 0;
+    int width_ = -1;
+    int height_ = -1;
+    uint32_t layoutRevision_ = 0;
+    int targetX_ = -1;
+    int targetY_ = -1;
+};
@@ -0,0 +1,207 @@
+#include "systems/GhostKernel.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "systems/SweptMove.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+    bool Overlaps(float x, float y, Vector2 target, float radiusSum) {
+        const float dx = x - target.x;
+        const float dy = y - target.y;
+        return dx * dx + dy * dy <= radiusSum * radiusSum;
+    }
+
+    uint8_t CaptureHits(float x, float y, float radius, const GhostStepParams& params) {
+        uint8_t hits = 0;
+        if (Overlaps(x, y, params.targetA, radius + params.radiusA)) {
+            hits |= kGhostHitsPlayerA;
+        }
+        if (Overlaps(x, y, params.targetB, radius + params.radiusB)) {
+            hits |= kGhostHitsPlayerB;
+        }
+        return hits;
+    }
+
+    WallGrid MakeWallGrid(const GhostStepParams& params) {
+        WallGrid walls;
+        walls.words = params.wallWords;
+        walls.wordsPerRow = params.wordsPerRow;
+        walls.tilesWide = params.mapTilesWide;
+        walls.tilesHigh = params.mapTilesHigh;
+        walls.tileSize = params.tileSize;
+        return walls;
+    }
+}
+
+void StepGhostsScalar(GhostArray& ghosts, const float* goalX, const float* goalY,
+                      uint8_t* captureHits, size_t begin, size_t end,
+                      const GhostStepParams& params) {
+    const float directions[4][2] = {
+        { -1.0f, 0.0f },
+        { 0.0f, -1.0f },
+        { 1.0f, 0.0f },
+        { 0.0f, 1.0f }
+    };
+
+    const WallGrid walls = MakeWallGrid(params);
+
+    for (size_t i = begin; i < end; ++i) {
+        const float x = ghosts.positionX[i];
+        const float y = ghosts.positionY[i];
+        const float speed = ghosts.speed[i];
+        const float radius = ghosts.radius[i];
+
+        float bestDistance = FLT_MAX;
+        bool foundDirection = false;
+        float bestDirX = 0.0f;
+        float bestDirY = 0.0f;
+        float bestX = x;
+        float bestY = y;
+
+        for (const auto& dir : directions) {
+            const Vector2 move{ dir[0] * speed * params.deltaSeconds, dir[1] * speed * params.deltaSeconds };
+            const Vector2 next = SweepCircle(walls, Vector2{ x, y }, move, radius);
+            if (next.x == x && next.y == y) {
+                continue;
+            }
+            const float nextX = next.x;
+            const float nextY = next.y;
+
+            const float dx = nextX - goalX[i];
+            const float dy = nextY - goalY[i];
+            const float distance = dx * dx + dy * dy;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestDirX = dir[0];
+                bestDirY = dir[1];
+                bestX = nextX;
+                bestY = nextY;
+                foundDirection = true;
+            }
+        }
+
+        if (foundDirection) {
+            ghosts.directionX[i] = bestDirX;
+            ghosts.directionY[i] = bestDirY;
+        }
+
+        bestX = std::clamp(bestX, radius, params.mapWidth - radius);
+        bestY = std::clamp(bestY, radius, params.mapHeight - radius);
+        ghosts.positionX[i] = bestX;
+        ghosts.positionY[i] = bestY;
+
+        if (captureHits != nullptr) {
+            captureHits[i] = CaptureHits(bestX, bestY, radius, params);
+        }
+    }
+}
+
+void CoastGhostsScalar(GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                       uint8_t* captureHits, size_t begin, size_t end,
+                       const GhostStepParams& params) {
+    const WallGrid walls = MakeWallGrid(params);
+
+    for (size_t i = begin; i < end; ++i) {
+        if (skip[i] != 0) {
+            continue;
+        }
+
+        const float x = ghosts.positionX[i];
+        const float y = ghosts.positionY[i];
+        const float dirX = ghosts.directionX[i];
+        const float dirY = ghosts.directionY[i];
+        const float radius = ghosts.radius[i];
+
+        blocked[i] = 0;
+        if (dirX != 0.0f || dirY != 0.0f) {
+            const float speed = ghosts.speed[i];
+            const Vector2 move{ dirX * speed * params.deltaSeconds, dirY * speed * params.deltaSeconds };
+            const Vector2 next = SweepCircle(walls, Vector2{ x, y }, move, radius);
+            blocked[i] = next.x == x && next.y == y ? 1 : 0;
+            ghosts.positionX[i] = std::clamp(next.x, radius, params.mapWidth - radius);
+            ghosts.positionY[i] = std::clamp(next.y, radius, params.mapHeight - radius);
+        }
+
+        if (captureHits != nullptr) {
+            captureHits[i] = CaptureHits(ghosts.positionX[i], ghosts.positionY[i], radius, params);
+        }
+    }
+}
+
+bool CpuHasAvx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX2 also needs the OS to save YMM state across context switches.
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+GhostKernel ResolveGhostKernel(GhostKernel requested) {
+#if defined(PACMEN_HAVE_AVX2_KERNEL)
+    static const bool hasAvx2 = CpuHasAvx2();
+    if (requested != GhostKernel::Scalar && hasAvx2) {
+        return GhostKernel::Avx2;
+    }
+#else
+    (void)requested;
+#endif
+    return GhostKernel::Scalar;
+}
+
+const char* GhostKernelName(GhostKernel kernel) {
+    switch (kernel) {
+        case GhostKernel::Auto: return "auto";
+        case GhostKernel::Scalar: return "scalar";
+        case GhostKernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void StepGhosts(GhostKernel kernel, GhostArray& ghosts, const float* goalX, const float* goalY,
+                uint8_t* captureHits, const GhostStepParams& params) {
+#if defined(PACMEN_HAVE_AVX2_KERNEL)
+    if (kernel == GhostKernel::Avx2) {
+        StepGhostsAvx2(ghosts, goalX, goalY, captureHits, 0, ghosts.Size(), params);
+        return;
+    }
+#else
+    (void)kernel;
+#endif
+    StepGhostsScalar(ghosts, goalX, goalY, captureHits, 0, ghosts.Size(), params);
+}
+
+void CoastGhosts(GhostKernel kernel, GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                 uint8_t* captureHits, const GhostStepParams& params) {
+#if defined(PACMEN_HAVE_AVX2_KERNEL)
+    if (kernel == GhostKernel::Avx2) {
+        CoastGhostsAvx2(ghosts, skip, blocked, captureHits, 0, ghosts.Size(), params);
+        return;
+    }
+#else
+    (void)kernel;
+#endif
+    CoastGhostsScalar(ghosts, skip, blocked, captureHits, 0, ghosts.Size(), params);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "entities/Ghost.h"
+
+enum class GhostKernel {
+    Auto,
+    Scalar,
+    Avx2
+};
+
+// Everything the movement kernel reads besides the ghosts themselves.
+struct GhostStepParams {
+    const uint64_t* wallWords = nullptr;
+    int wordsPerRow = 0;
+    int mapTilesWide = 0;
+    int mapTilesHigh = 0;
+    float tileSize = 1.0f;
+    float deltaSeconds = 0.0f;
+    float mapWidth = 0.0f;
+    float mapHeight = 0.0f;
+    Vector2 targetA{ 0.0f, 0.0f };
+    Vector2 targetB{ 0.0f, 0.0f };
+    float radiusA = 0.0f;
+    float radiusB = 0.0f;
+};
+
+// Bits written to captureHits[i] when ghost i ends its step touching a player.
+constexpr uint8_t kGhostHitsPlayerA = 1;
+constexpr uint8_t kGhostHitsPlayerB = 2;
+
+// Moves ghosts [begin, end) one step towards goalX/goalY: sweeps the four
+// cardinal moves through the walls (see SweepCircle), drops those that are
+// blocked outright, keeps the one ending closest to the goal, clamps to the
+// map and records which tick-start player positions the ghost now overlaps
+// (skipped when captureHits is null). Every kernel produces bit-identical
+// results.
+void StepGhostsScalar(GhostArray& ghosts, const float* goalX, const float* goalY,
+                      uint8_t* captureHits, size_t begin, size_t end,
+                      const GhostStepParams& params);
+
+#if defined(PACMEN_HAVE_AVX2_KERNEL)
+// Same contract as StepGhostsScalar; handles eight ghosts per iteration and
+// finishes any remainder with the scalar kernel. Only call when CpuHasAvx2().
+void StepGhostsAvx2(GhostArray& ghosts, const float* goalX, const float* goalY,
+                    uint8_t* captureHits, size_t begin, size_t end,
+                    const GhostStepParams& params);
+#endif
+
+// Moves ghosts [begin, end) whose skip[i] is zero one step along their
+// current direction, without choosing a new one: a single SweepCircle, then
+// the same clamp and capture check as StepGhostsScalar. blocked[i] is set
+// to 1 for a ghost that has a direction but could not move along it and to
+// 0 otherwise. Ghosts with skip[i] set are left untouched, blocked and
+// captureHits included. Every kernel produces bit-identical results.
+void CoastGhostsScalar(GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                       uint8_t* captureHits, size_t begin, size_t end,
+                       const GhostStepParams& params);
+
+#if defined(PACMEN_HAVE_AVX2_KERNEL)
+// Same contract as CoastGhostsScalar, eight ghosts per iteration.
+void CoastGhostsAvx2(GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                     uint8_t* captureHits, size_t begin, size_t end,
+                     const GhostStepParams& params);
+#endif
+
+bool CpuHasAvx2();
+
+// Resolves Auto to the fastest kernel this CPU runs, and any kernel this
+// build or CPU cannot run to Scalar.
+GhostKernel ResolveGhostKernel(GhostKernel requested);
+const char* GhostKernelName(GhostKernel kernel);
+
+void StepGhosts(GhostKernel kernel, GhostArray& ghosts, const float* goalX, const float* goalY,
+                uint8_t* captureHits, const GhostStepParams& params);
+void CoastGhosts(GhostKernel kernel, GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                 uint8_t* captureHits, const GhostStepParams& params);
@@ -0,0 +1,240 @@
+#include "systems/GhostKernel.h"
+
+#include <cfloat>
+#include <cstring>
+#include <immintrin.h>
+
+// Built with AVX2 code generation enabled for this file only; nothing here may
+// run unless CpuHasAvx2() said so. Each step mirrors StepGhostsScalar
+// operation for operation (no fused multiply-adds, same comparison order) so
+// both kernels round identically.
+//
+// Only moves that cannot touch a wall are vectorised: for those SweepCircle
+// returns exactly start + move, and the lane-wise IsSweepClear test below
+// decides which they are. A ghost with any candidate move that might touch
+// a wall is handed to the scalar kernel whole.
+
+namespace {
+    // All-ones in lanes whose tile is a wall or off the map.
+    __m256i WallMask(const GhostStepParams& params, __m256i tileX, __m256i tileY) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i inX = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, tileX),
+                                                _mm256_cmpgt_epi32(_mm256_set1_epi32(params.mapTilesWide), tileX));
+        const __m256i inY = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, tileY),
+                                                _mm256_cmpgt_epi32(_mm256_set1_epi32(params.mapTilesHigh), tileY));
+        const __m256i inside = _mm256_and_si256(inX, inY);
+
+        // Read the 64-bit wall words as pairs of little-endian 32-bit words,
+        // so tile x lives in bit (x & 31) of 32-bit word (x >> 5).
+        const __m256i index = _mm256_add_epi32(
+            _mm256_mullo_epi32(tileY, _mm256_set1_epi32(params.wordsPerRow * 2)),
+            _mm256_srli_epi32(tileX, 5));
+        const __m256i words = _mm256_mask_i32gather_epi32(
+            zero, reinterpret_cast<const int*>(params.wallWords), index, inside, 4);
+        const __m256i bits = _mm256_and_si256(
+            _mm256_srlv_epi32(words, _mm256_and_si256(tileX, _mm256_set1_epi32(31))),
+            _mm256_set1_epi32(1));
+        const __m256i wall = _mm256_cmpeq_epi32(bits, _mm256_set1_epi32(1));
+        return _mm256_or_si256(wall, _mm256_xor_si256(inside, _mm256_set1_epi32(-1)));
+    }
+
+    // IsSweepClear lane by lane, as all-ones lanes.
+    __m256 SweepClearMask(const GhostStepParams& params, __m256 minX, __m256 minY, __m256 maxX, __m256 maxY) {
+        const __m256 tileSize = _mm256_set1_ps(params.tileSize);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 negative = _mm256_or_ps(_mm256_cmp_ps(minX, zero, _CMP_LT_OQ), _mm256_cmp_ps(minY, zero, _CMP_LT_OQ));
+
+        const __m256i tileX0 = _mm256_cvttps_epi32(_mm256_div_ps(minX, tileSize));
+        const __m256i tileY0 = _mm256_cvttps_epi32(_mm256_div_ps(minY, tileSize));
+        const __m256i tileX1 = _mm256_cvttps_epi32(_mm256_div_ps(maxX, tileSize));
+        const __m256i tileY1 = _mm256_cvttps_epi32(_mm256_div_ps(maxY, tileSize));
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i tooWide = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_sub_epi32(tileX1, tileX0), one),
+                                                _mm256_cmpgt_epi32(_mm256_sub_epi32(tileY1, tileY0), one));
+
+        __m256i blocked = _mm256_or_si256(_mm256_castps_si256(negative), tooWide);
+        blocked = _mm256_or_si256(blocked, WallMask(params, tileX0, tileY0));
+        blocked = _mm256_or_si256(blocked, WallMask(params, tileX1, tileY0));
+        blocked = _mm256_or_si256(blocked, WallMask(params, tileX0, tileY1));
+        blocked = _mm256_or_si256(blocked, WallMask(params, tileX1, tileY1));
+        return _mm256_castsi256_ps(_mm256_xor_si256(blocked, _mm256_set1_epi32(-1)));
+    }
+
+    // std::clamp(value, low, high) lane by lane.
+    __m256 Clamp(__m256 value, __m256 low, __m256 high) {
+        __m256 result = _mm256_blendv_ps(value, high, _mm256_cmp_ps(high, value, _CMP_LT_OQ));
+        return _mm256_blendv_ps(result, low, _mm256_cmp_ps(value, low, _CMP_LT_OQ));
+    }
+
+    __m256 Overlaps(__m256 x, __m256 y, Vector2 target, __m256 radiusSum) {
+        const __m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(target.x));
+        const __m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(target.y));
+        const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        return _mm256_cmp_ps(distance, _mm256_mul_ps(radiusSum, radiusSum), _CMP_LE_OQ);
+    }
+}
+
+void StepGhostsAvx2(GhostArray& ghosts, const float* goalX, const float* goalY,
+                    uint8_t* captureHits, size_t begin, size_t end,
+                    const GhostStepParams& params) {
+    const float directions[4][2] = {
+        { -1.0f, 0.0f },
+        { 0.0f, -1.0f },
+        { 1.0f, 0.0f },
+        { 0.0f, 1.0f }
+    };
+
+    const __m256 deltaSeconds = _mm256_set1_ps(params.deltaSeconds);
+    const __m256 mapWidth = _mm256_set1_ps(params.mapWidth);
+    const __m256 mapHeight = _mm256_set1_ps(params.mapHeight);
+    const __m256 radiusA = _mm256_set1_ps(params.radiusA);
+    const __m256 radiusB = _mm256_set1_ps(params.radiusB);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 x = _mm256_loadu_ps(&ghosts.positionX[i]);
+        const __m256 y = _mm256_loadu_ps(&ghosts.positionY[i]);
+        const __m256 speed = _mm256_loadu_ps(&ghosts.speed[i]);
+        const __m256 radius = _mm256_loadu_ps(&ghosts.radius[i]);
+        const __m256 targetX = _mm256_loadu_ps(&goalX[i]);
+        const __m256 targetY = _mm256_loadu_ps(&goalY[i]);
+
+        __m256 bestDistance = _mm256_set1_ps(FLT_MAX);
+        __m256 found = _mm256_setzero_ps();
+        __m256 bestDirX = _mm256_setzero_ps();
+        __m256 bestDirY = _mm256_setzero_ps();
+        __m256 bestX = x;
+        __m256 bestY = y;
+        __m256 clear = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const auto& dir : directions) {
+            const __m256 dirX = _mm256_set1_ps(dir[0]);
+            const __m256 dirY = _mm256_set1_ps(dir[1]);
+            const __m256 nextX = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(dirX, speed), deltaSeconds));
+            const __m256 nextY = _mm256_add_ps(y, _mm256_mul_ps(_mm256_mul_ps(dirY, speed), deltaSeconds));
+
+            clear = _mm256_and_ps(clear, SweepClearMask(params,
+                _mm256_sub_ps(_mm256_min_ps(x, nextX), radius), _mm256_sub_ps(_mm256_min_ps(y, nextY), radius),
+                _mm256_add_ps(_mm256_max_ps(x, nextX), radius), _mm256_add_ps(_mm256_max_ps(y, nextY), radius)));
+            const __m256 stayed = _mm256_and_ps(_mm256_cmp_ps(nextX, x, _CMP_EQ_OQ), _mm256_cmp_ps(nextY, y, _CMP_EQ_OQ));
+
+            const __m256 dx = _mm256_sub_ps(nextX, targetX);
+            const __m256 dy = _mm256_sub_ps(nextY, targetY);
+            const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            const __m256 better = _mm256_andnot_ps(stayed, _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ));
+
+            bestDistance = _mm256_blendv_ps(bestDistance, distance, better);
+            bestDirX = _mm256_blendv_ps(bestDirX, dirX, better);
+            bestDirY = _mm256_blendv_ps(bestDirY, dirY, better);
+            bestX = _mm256_blendv_ps(bestX, nextX, better);
+            bestY = _mm256_blendv_ps(bestY, nextY, better);
+            found = _mm256_or_ps(found, better);
+        }
+
+        // Lanes with a move that might touch a wall are left untouched here
+        // and redone by the scalar kernel below.
+        const int clearLanes = _mm256_movemask_ps(clear);
+        const __m256i store = _mm256_castps_si256(clear);
+        const __m256i storeFound = _mm256_castps_si256(_mm256_and_ps(clear, found));
+
+        _mm256_maskstore_ps(&ghosts.directionX[i], storeFound, bestDirX);
+        _mm256_maskstore_ps(&ghosts.directionY[i], storeFound, bestDirY);
+
+        bestX = Clamp(bestX, radius, _mm256_sub_ps(mapWidth, radius));
+        bestY = Clamp(bestY, radius, _mm256_sub_ps(mapHeight, radius));
+        _mm256_maskstore_ps(&ghosts.positionX[i], store, bestX);
+        _mm256_maskstore_ps(&ghosts.positionY[i], store, bestY);
+
+        if (captureHits != nullptr) {
+            const int hitsA = _mm256_movemask_ps(Overlaps(bestX, bestY, params.targetA, _mm256_add_ps(radius, radiusA)));
+            const int hitsB = _mm256_movemask_ps(Overlaps(bestX, bestY, params.targetB, _mm256_add_ps(radius, radiusB)));
+            for (int lane = 0; lane < 8; ++lane) {
+                if ((clearLanes >> lane) & 1) {
+                    captureHits[i + lane] = static_cast<uint8_t>(
+                        (((hitsA >> lane) & 1) ? kGhostHitsPlayerA : 0) |
+                        (((hitsB >> lane) & 1) ? kGhostHitsPlayerB : 0));
+                }
+            }
+        }
+
+        for (int lane = 0; lane < 8; ++lane) {
+            if (((clearLanes >> lane) & 1) == 0) {
+                StepGhostsScalar(ghosts, goalX, goalY, captureHits, i + lane, i + lane + 1, params);
+            }
+        }
+    }
+
+    StepGhostsScalar(ghosts, goalX, goalY, captureHits, i, end, params);
+}
+
+void CoastGhostsAvx2(GhostArray& ghosts, const uint8_t* skip, uint8_t* blocked,
+                     uint8_t* captureHits, size_t begin, size_t end,
+                     const GhostStepParams& params) {
+    const __m256 deltaSeconds = _mm256_set1_ps(params.deltaSeconds);
+    const __m256 mapWidth = _mm256_set1_ps(params.mapWidth);
+    const __m256 mapHeight = _mm256_set1_ps(params.mapHeight);
+    const __m256 radiusA = _mm256_set1_ps(params.radiusA);
+    const __m256 radiusB = _mm256_set1_ps(params.radiusB);
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        uint64_t skipBytes;
+        std::memcpy(&skipBytes, skip + i, sizeof(skipBytes));
+        if (skipBytes == ~0ull) {
+            continue;
+        }
+        const __m256i skipLanes = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(skipBytes)));
+        const __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(skipLanes, _mm256_setzero_si256()));
+
+        const __m256 x = _mm256_loadu_ps(&ghosts.positionX[i]);
+        const __m256 y = _mm256_loadu_ps(&ghosts.positionY[i]);
+        const __m256 dirX = _mm256_loadu_ps(&ghosts.directionX[i]);
+        const __m256 dirY = _mm256_loadu_ps(&ghosts.directionY[i]);
+        const __m256 speed = _mm256_loadu_ps(&ghosts.speed[i]);
+        const __m256 radius = _mm256_loadu_ps(&ghosts.radius[i]);
+
+        const __m256 nextX = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(dirX, speed), deltaSeconds));
+        const __m256 nextY = _mm256_add_ps(y, _mm256_mul_ps(_mm256_mul_ps(dirY, speed), deltaSeconds));
+        const __m256 clear = SweepClearMask(params,
+            _mm256_sub_ps(_mm256_min_ps(x, nextX), radius), _mm256_sub_ps(_mm256_min_ps(y, nextY), radius),
+            _mm256_add_ps(_mm256_max_ps(x, nextX), radius), _mm256_add_ps(_mm256_max_ps(y, nextY), radius));
+
+        // Ghosts without a direction stay put; those with one move here only
+        // when the move is clear, and are swept by the scalar kernel otherwise.
+        const __m256 still = _mm256_and_ps(_mm256_cmp_ps(dirX, zero, _CMP_EQ_OQ), _mm256_cmp_ps(dirY, zero, _CMP_EQ_OQ));
+        const __m256 moving = _mm256_and_ps(active, _mm256_andnot_ps(still, clear));
+        const __m256 handled = _mm256_and_ps(active, _mm256_or_ps(still, clear));
+        const __m256 stayed = _mm256_and_ps(_mm256_cmp_ps(nextX, x, _CMP_EQ_OQ), _mm256_cmp_ps(nextY, y, _CMP_EQ_OQ));
+
+        const __m256 endX = _mm256_blendv_ps(x, Clamp(nextX, radius, _mm256_sub_ps(mapWidth, radius)), moving);
+        const __m256 endY = _mm256_blendv_ps(y, Clamp(nextY, radius, _mm256_sub_ps(mapHeight, radius)), moving);
+        _mm256_maskstore_ps(&ghosts.positionX[i], _mm256_castps_si256(moving), endX);
+        _mm256_maskstore_ps(&ghosts.positionY[i], _mm256_castps_si256(moving), endY);
+
+        const int handledLanes = _mm256_movemask_ps(handled);
+        const int blockedLanes = _mm256_movemask_ps(_mm256_and_ps(moving, stayed));
+        const int hitsA = _mm256_movemask_ps(Overlaps(endX, endY, params.targetA, _mm256_add_ps(radius, radiusA)));
+        const int hitsB = _mm256_movemask_ps(Overlaps(endX, endY, params.targetB, _mm256_add_ps(radius, radiusB)));
+        for (int lane = 0; lane < 8; ++lane) {
+            if (((handledLanes >> lane) & 1) == 0) {
+                continue;
+            }
+            blocked[i + lane] = static_cast<uint8_t>((blockedLanes >> lane) & 1);
+            if (captureHits != nullptr) {
+                captureHits[i + lane] = static_cast<uint8_t>(
+                    (((hitsA >> lane) & 1) ? kGhostHitsPlayerA : 0) |
+                    (((hitsB >> lane) & 1) ? kGhostHitsPlayerB : 0));
+            }
+        }
+
+        const int sweepLanes = _mm256_movemask_ps(active) & ~handledLanes;
+        for (int lane = 0; lane < 8; ++lane) {
+            if ((sweepLanes >> lane) & 1) {
+                CoastGhostsScalar(ghosts, skip, blocked, captureHits, i + lane, i + lane + 1, params);
+            }
+        }
+    }
+
+    CoastGhostsScalar(ghosts, skip, blocked, captureHits, i, end, params);
+}
@@ -0,0 +1,137 @@
+#include "systems/GhostScheduler.h"
+
+#include <algorithm>
+
+namespace {
+    // The budget's share kept for ghosts deferred on earlier ticks.
+    constexpr size_t kReservedShare = 4;
+
+    float DistanceSquared(float x, float y, Vector2 target) {
+        const float dx = x - target.x;
+        const float dy = y - target.y;
+        return dx * dx + dy * dy;
+    }
+}
+
+void GhostScheduler::Reset(size_t ghostCount) {
+    flags_.assign(ghostCount, 0);
+    cursor_ = 0;
+    sweep_ = 0;
+    tick_ = 0;
+}
+
+void GhostScheduler::SaveState(State& state) const {
+    state.flags.assign(flags_.begin(), flags_.end());
+    state.cursor = cursor_;
+    state.sweep = sweep_;
+    state.tick = tick_;
+}
+
+void GhostScheduler::LoadState(const State& state) {
+    flags_.assign(state.flags.begin(), state.flags.end());
+    cursor_ = state.cursor;
+    sweep_ = state.sweep;
+    tick_ = state.tick;
+}
+
+void GhostScheduler::Plan(const GhostArray& ghosts, Vector2 targetA, Vector2 targetB, float tileSize,
+                          std::vector<uint32_t>& decisions) {
+    const size_t count = ghosts.Size();
+    flags_.resize(count, 0);
+    decisions.clear();
+    urgent_.clear();
+    due_.clear();
+    if (cursor_ >= count) {
+        cursor_ = 0;
+    }
+    if (sweep_ >= count) {
+        sweep_ = 0;
+    }
+
+    // The reserved share goes first, to deferred ghosts in turn from where
+    // the sweep stopped last tick. Urgent ghosts deferred again and again
+    // cannot push a ghost further down the sweep: it only moves forward.
+    size_t budget = static_cast<size_t>(std::max(rules_.decisionBudget, 0));
+    const size_t reserved = budget > 0 ? std::max<size_t>(budget / kReservedShare, 1) : 0;
+    for (size_t step = 0; step < count && decisions.size() < reserved; ++step) {
+        size_t i = sweep_ + step;
+        if (i >= count) {
+            i -= count;
+        }
+        if (flags_[i] & kPending) {
+            flags_[i] |= kReserved;
+            decisions.push_back(static_cast<uint32_t>(i));
+            if (decisions.size() == reserved) {
+                sweep_ = i + 1 < count ? i + 1 : 0;
+            }
+        }
+    }
+    budget -= decisions.size();
+
+    const float nearDistance = rules_.nearTiles * tileSize;
+    const float midDistance = rules_.midTiles * tileSize;
+    const float nearSquared = nearDistance * nearDistance;
+    const float midSquared = midDistance * midDistance;
+    const uint64_t midInterval = static_cast<uint64_t>(std::max(rules_.midInterval, 1));
+    const uint64_t farInterval = static_cast<uint64_t>(std::max(rules_.farInterval, 1));
+
+    for (size_t step = 0; step < count; ++step) {
+        size_t i = cursor_ + step;
+        if (i >= count) {
+            i -= count;
+        }
+
+        if (flags_[i] & kReserved) {
+            continue;
+        }
+        const float x = ghosts.positionX[i];
+        const float y = ghosts.positionY[i];
+        const float distance = std::min(DistanceSquared(x, y, targetA), DistanceSquared(x, y, targetB));
+        if (distance <= nearSquared || (flags_[i] & kBlocked)) {
+            urgent_.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+
+        const uint64_t interval = distance <= midSquared ? midInterval : farInterval;
+        if ((flags_[i] & kPending) || (tick_ + i) % interval == 0) {
+            due_.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    const size_t urgentTaken = std::min(urgent_.size(), budget);
+    budget -= urgentTaken;
+    const size_t dueTaken = std::min(due_.size(), budget);
+
+    decisions.insert(decisions.end(), urgent_.begin(), urgent_.begin() + urgentTaken);
+    decisions.insert(decisions.end(), due_.begin(), due_.begin() + dueTaken);
+    for (uint32_t index : decisions) {
+        flags_[index] = 0;
+    }
+
+    // Whatever did not fit stays due, and next tick's scan starts at the
+    // first ghost left over.
+    for (size_t i = urgentTaken; i < urgent_.size(); ++i) {
+        flags_[urgent_[i]] |= kPending;
+    }
+    for (size_t i = dueTaken; i < due_.size(); ++i) {
+        flags_[due_[i]] |= kPending;
+    }
+    if (urgentTaken < urgent_.size()) {
+        cursor_ = urgent_[urgentTaken];
+    } else if (dueTaken < due_.size()) {
+        cursor_ = due_[dueTaken];
+    }
+
+    // Ascending order keeps the gather into the kernel's batch sequential.
+    std::sort(decisions.begin(), decisions.end());
+
+    const size_t deferred = (urgent_.size() - urgentTaken) + (due_.size() - dueTaken);
+    stats_.decisions = static_cast<uint32_t>(decisions.size());
+    stats_.deferred = static_cast<uint32_t>(deferred);
+    ++stats_.ticks;
+    stats_.totalDecisions += decisions.size();
+    if (deferred > 0) {
+        ++stats_.overrunTicks;
+    }
+    ++tick_;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities/Ghost.h"
+
+enum class GhostSchedule {
+    // Every ghost picks a direction every tick.
+    Full,
+    // Ghosts far from both players pick a direction every few ticks and keep
+    // moving in between, and no more than a fixed number decide per tick.
+    Budgeted
+};
+
+struct GhostScheduleRules {
+    // Ghosts within nearTiles of a player decide every tick, those within
+    // midTiles every midInterval ticks, the rest every farInterval ticks.
+    int nearTiles = 16;
+    int midTiles = 48;
+    int midInterval = 4;
+    int farInterval = 16;
+    // Most decisions made in one tick; ghosts due beyond it wait for a later
+    // tick and go first then.
+    int decisionBudget = 4096;
+};
+
+struct GhostScheduleStats {
+    // Last tick.
+    uint32_t decisions = 0;
+    uint32_t deferred = 0;
+    // Since the scheduler was created; resets do not clear these.
+    uint64_t ticks = 0;
+    uint64_t totalDecisions = 0;
+    // Ticks that had more decisions due than the budget allowed.
+    uint64_t overrunTicks = 0;
+};
+
+// Decides which ghosts run their full direction choice this tick. Near
+// ghosts and ghosts that ran into a wall are served first; distant ghosts
+// come due on staggered ticks (ghost i of interval n on ticks where
+// (tick + i) % n == 0) so the work is spread evenly. A quarter of the
+// budget is kept for ghosts deferred on earlier ticks, taken in turn by a
+// sweep round the ghost array, so a deferred ghost waits at most
+// ghostCount / (budget / 4) ticks however many urgent ghosts keep coming.
+// Everything depends only on the tick count and ghost positions, so runs
+// replay identically.
+class GhostScheduler {
+public:
+    // Everything Plan carries from one tick to the next, for rollback.
+    struct State {
+        std::vector<uint8_t> flags{};
+        size_t cursor = 0;
+        size_t sweep = 0;
+        uint64_t tick = 0;
+    };
+
+    void SetRules(const GhostScheduleRules& rules) { rules_ = rules; }
+    const GhostScheduleRules& GetRules() const { return rules_; }
+
+    // Forgets pending and blocked ghosts and restarts the tick count.
+    // The cumulative stats carry on.
+    void Reset(size_t ghostCount);
+
+    // Fills decisions with the indices of the ghosts that decide this tick,
+    // in ascending order, and advances the tick.
+    void Plan(const GhostArray& ghosts, Vector2 targetA, Vector2 targetB, float tileSize,
+              std::vector<uint32_t>& decisions);
+
+    // A coasting ghost that could not move along its direction decides next tick.
+    void MarkBlocked(size_t index) { flags_[index] |= kBlocked; }
+
+    const GhostScheduleStats& GetStats() const { return stats_; }
+
+    // Reuses the vector in `state`, so saving into the same State again
+    // does not allocate. Stats are not part of it.
+    void SaveState(State& state) const;
+    void LoadState(const State& state);
+
+private:
+    static constexpr uint8_t kPending = 1;
+    static constexpr uint8_t kBlocked = 2;
+    // Taken from the reserved share this tick; only set inside Plan.
+    static constexpr uint8_t kReserved = 4;
+
+    GhostScheduleRules rules_{};
+    GhostScheduleStats stats_{};
+    std::vector<uint8_t> flags_{};
+    std::vector<uint32_t> urgent_{};
+    std::vector<uint32_t> due_{};
+    size_t cursor_ = 0;
+    // Where the reserved share's sweep over deferred ghosts goes on from.
+    size_t sweep_ = 0;
+    uint64_t tick_ = 0;
+};
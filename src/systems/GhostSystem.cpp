@@ -1,7 +1,10 @@
 #include "systems/GhostSystem.h"
 
 #include <algorithm>
-#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+
+#include "sim/Profiler.h"
 
 namespace {
     float DistanceSquared(Vector2 a, Vector2 b) {
@@ -10,82 +13,297 @@ namespace {
         return dx * dx + dy * dy;
     }
 
-    Vector2 ChooseTarget(const Player& playerA, const Player& playerB, const Ghost& ghost) {
-        const float distA = DistanceSquared(ghost.position, playerA.position);
-        const float distB = DistanceSquared(ghost.position, playerB.position);
-        return (distA <= distB) ? playerA.position : playerB.position;
+    void RefreshField(FlowField& field, const TileMap& map, const Player& player, int tilePixelSize) {
+        const int tileX = static_cast<int>(player.position.x / tilePixelSize);
+        const int tileY = static_cast<int>(player.position.y / tilePixelSize);
+        if (!field.IsBuiltFor(map, tileX, tileY)) {
+            field.Build(map, tileX, tileY);
+        }
     }
 
-    void TryCapturePlayer(const Ghost& ghost, Player& player) {
-        if (player.invulnerableSeconds > 0.0f) {
-            return;
+    // Picks the point the ghost should steer at this tick: the centre of the
+    // neighbouring tile one step closer to the nearest player along the maze,
+    // or the player itself once they share a tile. Falls back to the nearest
+    // player by straight-line distance when neither is reachable.
+    Vector2 ChooseChaseGoal(const FlowField& fieldA, Vector2 targetA,
+                       const FlowField& fieldB, Vector2 targetB,
+                       Vector2 position, int tilePixelSize) {
+        const int tileX = static_cast<int>(position.x / tilePixelSize);
+        const int tileY = static_cast<int>(position.y / tilePixelSize);
+
+        const int32_t distA = fieldA.GetDistance(tileX, tileY);
+        const int32_t distB = fieldB.GetDistance(tileX, tileY);
+        if (distA == FlowField::kUnreachable && distB == FlowField::kUnreachable) {
+            return DistanceSquared(position, targetA) <= DistanceSquared(position, targetB)
+                ? targetA : targetB;
+        }
+
+        const bool chaseA = distA <= distB;
+        const FlowField& field = chaseA ? fieldA : fieldB;
+        const Vector2 target = chaseA ? targetA : targetB;
+        int32_t bestDistance = chaseA ? distA : distB;
+        if (bestDistance == 0) {
+            return target;
         }
 
-        const float captureDistance = ghost.radius + player.radius;
-        if (DistanceSquared(ghost.position, player.position) <= captureDistance * captureDistance) {
-            player.position = player.spawnPosition;
-            player.invulnerableSeconds = 1.0f;
-            if (player.lives > 0) {
-                --player.lives;
+        const int neighbours[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+        int bestX = tileX;
+        int bestY = tileY;
+        for (const auto& offset : neighbours) {
+            const int32_t distance = field.GetDistance(tileX + offset[0], tileY + offset[1]);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestX = tileX + offset[0];
+                bestY = tileY + offset[1];
             }
         }
+
+        return {
+            (bestX + 0.5f) * tilePixelSize,
+            (bestY + 0.5f) * tilePixelSize
+        };
+    }
+
+    Vector2 TileCentre(int x, int y, int tilePixelSize) {
+        return {
+            (x + 0.5f) * tilePixelSize,
+            (y + 0.5f) * tilePixelSize
+        };
+    }
+
+    // Tiles an ambusher aims ahead of the player it targets.
+    constexpr int kAmbushLead = 4;
+
+    void CapturePlayer(Player& player) {
+        player.position = player.spawnPosition;
+        ++player.respawns;
+        player.invulnerableSeconds = 1.0f;
+        if (player.lives > 0) {
+            --player.lives;
+        }
     }
 }
 
-void GhostSystem::Update(std::vector<Ghost>& ghosts,
+void GhostSystem::Update(GhostArray& ghosts,
                          const TileMap& map,
                          Player& playerA,
                          Player& playerB,
                          float deltaSeconds,
-                         int tilePixelSize) const {
-    const float mapWidth = map.GetWidth() * tilePixelSize;
-    const float mapHeight = map.GetHeight() * tilePixelSize;
-
-    const Vector2 directions[4] = {
-        { -1.0f, 0.0f },
-        { 0.0f, -1.0f },
-        { 1.0f, 0.0f },
-        { 0.0f, 1.0f }
-    };
-
-    for (Ghost& ghost : ghosts) {
-        const Vector2 target = ChooseTarget(playerA, playerB, ghost);
-
-        float bestDistance = FLT_MAX;
-        bool foundDirection = false;
-        Vector2 bestDirection{ 0.0f, 0.0f };
-        Vector2 bestNext = ghost.position;
-
-        for (const Vector2& dir : directions) {
-            Vector2 next = {
-                ghost.position.x + dir.x * ghost.speed * deltaSeconds,
-                ghost.position.y + dir.y * ghost.speed * deltaSeconds
-            };
-
-            const int tileX = static_cast<int>(next.x / tilePixelSize);
-            const int tileY = static_cast<int>(next.y / tilePixelSize);
-            if (map.IsWall(tileX, tileY)) {
-                continue;
-            }
+                         int tilePixelSize) {
+    PACMEN_PROFILE_ZONE("GhostSystem::Update");
 
-            const float distance = DistanceSquared(next, target);
-            if (distance < bestDistance) {
-                bestDistance = distance;
-                bestDirection = dir;
-                bestNext = next;
-                foundDirection = true;
-            }
+    // Ghosts steer at where the players stood when the tick began, so a
+    // capture part-way through the tick does not change other ghosts' paths.
+    RefreshField(fieldA_, map, playerA, tilePixelSize);
+    RefreshField(fieldB_, map, playerB, tilePixelSize);
+    RefreshCorners(map);
+    const Vector2 targetA = playerA.position;
+    const Vector2 targetB = playerB.position;
+
+    const size_t count = ghosts.Size();
+    if (captureCheck_ == CaptureCheck::BruteForce) {
+        captureHits_.resize(count);
+    }
+
+    GhostStepParams params{};
+    params.wallWords = map.GetWallWords();
+    params.wordsPerRow = map.GetWordsPerRow();
+    params.mapTilesWide = map.GetWidth();
+    params.mapTilesHigh = map.GetHeight();
+    params.tileSize = static_cast<float>(tilePixelSize);
+    params.deltaSeconds = deltaSeconds;
+    params.mapWidth = map.GetWidth() * tilePixelSize;
+    params.mapHeight = map.GetHeight() * tilePixelSize;
+    params.targetA = targetA;
+    params.targetB = targetB;
+    params.radiusA = playerA.radius;
+    params.radiusB = playerB.radius;
+
+    if (captureCheck_ == CaptureCheck::Grid) {
+        MoveGhosts(ghosts, map, playerA, playerB, params, tilePixelSize, nullptr);
+
+        captureGrid_.Build(ghosts, params.tileSize);
+        if (playerA.invulnerableSeconds <= 0.0f && captureGrid_.AnyOverlap(ghosts, targetA, playerA.radius)) {
+            CapturePlayer(playerA);
+        }
+        if (playerB.invulnerableSeconds <= 0.0f && captureGrid_.AnyOverlap(ghosts, targetB, playerB.radius)) {
+            CapturePlayer(playerB);
+        }
+        return;
+    }
+
+    MoveGhosts(ghosts, map, playerA, playerB, params, tilePixelSize, captureHits_.data());
+
+    // A player only moves when caught, and is invulnerable afterwards, so
+    // checking every ghost against the tick-start positions and letting the
+    // first hit win matches checking each ghost in turn as it moves.
+    uint8_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hits |= captureHits_[i];
+    }
+    if ((hits & kGhostHitsPlayerA) && playerA.invulnerableSeconds <= 0.0f) {
+        CapturePlayer(playerA);
+    }
+    if ((hits & kGhostHitsPlayerB) && playerB.invulnerableSeconds <= 0.0f) {
+        CapturePlayer(playerB);
+    }
+}
+
+void GhostSystem::MoveGhosts(GhostArray& ghosts, const TileMap& map, const Player& playerA, const Player& playerB,
+                             const GhostStepParams& params, int tilePixelSize, uint8_t* captureHits) {
+    if (schedule_ == GhostSchedule::Budgeted) {
+        MoveScheduledGhosts(ghosts, map, playerA, playerB, params, tilePixelSize, captureHits);
+        return;
+    }
+
+    const size_t count = ghosts.Size();
+    goalX_.resize(count);
+    goalY_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Vector2 goal = ChooseGoal(ghosts, i, map, playerA, playerB, params, tilePixelSize);
+        goalX_[i] = goal.x;
+        goalY_[i] = goal.y;
+    }
+
+    StepGhosts(kernel_, ghosts, goalX_.data(), goalY_.data(), captureHits, params);
+}
+
+void GhostSystem::MoveScheduledGhosts(GhostArray& ghosts, const TileMap& map, const Player& playerA,
+                                      const Player& playerB, const GhostStepParams& params, int tilePixelSize,
+                                      uint8_t* captureHits) {
+    PACMEN_PROFILE_ZONE("GhostSystem::MoveScheduledGhosts");
+    scheduler_.Plan(ghosts, params.targetA, params.targetB, params.tileSize, decisions_);
+
+    // The deciding ghosts are packed into their own array so the kernel,
+    // AVX2 included, runs over them contiguously.
+    const size_t decisionCount = decisions_.size();
+    batch_.Clear();
+    batch_.Reserve(decisionCount);
+    goalX_.resize(decisionCount);
+    goalY_.resize(decisionCount);
+    batchHits_.resize(decisionCount);
+    for (size_t k = 0; k < decisionCount; ++k) {
+        const Vector2 goal = ChooseGoal(ghosts, decisions_[k], map, playerA, playerB, params, tilePixelSize);
+        goalX_[k] = goal.x;
+        goalY_[k] = goal.y;
+        batch_.Add(ghosts.Get(decisions_[k]));
+    }
+
+    StepGhosts(kernel_, batch_, goalX_.data(), goalY_.data(),
+               captureHits != nullptr ? batchHits_.data() : nullptr, params);
+
+    for (size_t k = 0; k < decisionCount; ++k) {
+        const uint32_t i = decisions_[k];
+        ghosts.positionX[i] = batch_.positionX[k];
+        ghosts.positionY[i] = batch_.positionY[k];
+        ghosts.directionX[i] = batch_.directionX[k];
+        ghosts.directionY[i] = batch_.directionY[k];
+        if (captureHits != nullptr) {
+            captureHits[i] = batchHits_[k];
+        }
+    }
+
+    // The rest keep going the way they were heading.
+    skip_.assign(ghosts.Size(), 0);
+    blocked_.resize(ghosts.Size());
+    for (uint32_t i : decisions_) {
+        skip_[i] = 1;
+    }
+    CoastGhosts(kernel_, ghosts, skip_.data(), blocked_.data(), captureHits, params);
+    for (size_t i = 0; i < ghosts.Size(); ++i) {
+        if (skip_[i] == 0 && blocked_[i] != 0) {
+            scheduler_.MarkBlocked(i);
         }
+    }
+}
+
+Vector2 GhostSystem::ChooseGoal(GhostArray& ghosts, size_t i, const TileMap& map, const Player& playerA,
+                                const Player& playerB, const GhostStepParams& params, int tilePixelSize) {
+    const Vector2 position{ ghosts.positionX[i], ghosts.positionY[i] };
+    if (ghosts.role[i] == GhostRole::Chase) {
+        return ChooseChaseGoal(fieldA_, params.targetA, fieldB_, params.targetB, position, tilePixelSize);
+    }
+
+    const TilePoint tile{ static_cast<int>(position.x / tilePixelSize), static_cast<int>(position.y / tilePixelSize) };
+    const TilePoint target = ChooseRoleTarget(ghosts, i, tile, map, playerA, playerB, params, tilePixelSize);
+
+    // Off the route (or already there), steer straight at the target and
+    // let the movement kernel slide along whatever is in the way.
+    int stepX = 0;
+    int stepY = 0;
+    if (!pathfinder_.NextStep(map, tile.x, tile.y, target.x, target.y, stepX, stepY)) {
+        return TileCentre(target.x, target.y, tilePixelSize);
+    }
+    return TileCentre(stepX, stepY, tilePixelSize);
+}
+
+GhostSystem::TilePoint GhostSystem::ChooseRoleTarget(GhostArray& ghosts, size_t i, TilePoint tile, const TileMap& map,
+                                                     const Player& playerA, const Player& playerB,
+                                                     const GhostStepParams& params, int tilePixelSize) {
+    switch (ghosts.role[i]) {
+        case GhostRole::Ambush: {
+            const Vector2 position{ ghosts.positionX[i], ghosts.positionY[i] };
+            const bool targetA = DistanceSquared(position, params.targetA) <= DistanceSquared(position, params.targetB);
+            const Vector2 playerPosition = targetA ? params.targetA : params.targetB;
+            const Vector2 heading = targetA ? playerA.heading : playerB.heading;
+            const TilePoint playerTile{ static_cast<int>(playerPosition.x / tilePixelSize),
+                                        static_cast<int>(playerPosition.y / tilePixelSize) };
 
-        if (foundDirection) {
-            ghost.currentDirection = bestDirection;
-            ghost.position = bestNext;
+            // The furthest open tile ahead, up to the lead; the player's own
+            // tile when everything ahead is wall.
+            for (int lead = kAmbushLead; lead > 0; --lead) {
+                const int x = playerTile.x + static_cast<int>(std::lround(heading.x * lead));
+                const int y = playerTile.y + static_cast<int>(std::lround(heading.y * lead));
+                if (!map.IsWall(x, y)) {
+                    return { x, y };
+                }
+            }
+            return playerTile;
+        }
+        case GhostRole::Patrol: {
+            const TilePoint corner = corners_[ghosts.waypoint[i] % 4];
+            if (std::abs(corner.x - tile.x) + std::abs(corner.y - tile.y) <= 1) {
+                ghosts.waypoint[i] = static_cast<uint8_t>((ghosts.waypoint[i] + 1) % 4);
+            }
+            return corners_[ghosts.waypoint[i] % 4];
         }
+        case GhostRole::Scatter:
+            return corners_[ghosts.waypoint[i] % 4];
+        case GhostRole::Chase:
+            break;
+    }
+    return tile;
+}
 
-        ghost.position.x = std::clamp(ghost.position.x, ghost.radius, mapWidth - ghost.radius);
-        ghost.position.y = std::clamp(ghost.position.y, ghost.radius, mapHeight - ghost.radius);
+void GhostSystem::RefreshCorners(const TileMap& map) {
+    if (map.GetWallWords() == cornersWalls_ && map.GetLayoutRevision() == cornersRevision_) {
+        return;
+    }
+    cornersWalls_ = map.GetWallWords();
+    cornersRevision_ = map.GetLayoutRevision();
 
-        TryCapturePlayer(ghost, playerA);
-        TryCapturePlayer(ghost, playerB);
+    const int width = map.GetWidth();
+    const int height = map.GetHeight();
+    const TilePoint anchors[4] = { { 0, 0 }, { width - 1, 0 }, { width - 1, height - 1 }, { 0, height - 1 } };
+    for (int c = 0; c < 4; ++c) {
+        // Nearest open tile by growing squares around the corner; the corner
+        // itself when the map has none.
+        corners_[c] = anchors[c];
+        bool found = false;
+        for (int radius = 0; radius < std::max(width, height) && !found; ++radius) {
+            for (int dy = -radius; dy <= radius && !found; ++dy) {
+                for (int dx = -radius; dx <= radius && !found; ++dx) {
+                    if (std::max(std::abs(dx), std::abs(dy)) != radius) {
+                        continue;
+                    }
+                    const int x = anchors[c].x + dx;
+                    const int y = anchors[c].y + dy;
+                    if (x >= 0 && y >= 0 && x < width && y < height && !map.IsWall(x, y)) {
+                        corners_[c] = { x, y };
+                        found = true;
+                    }
+                }
+            }
+        }
     }
 }
@@ -1,17 +1,100 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <vector>
 
 #include "entities/Ghost.h"
 #include "entities/Player.h"
 #include "game/TileMap.h"
+#include "systems/CaptureGrid.h"
+#include "systems/FlowField.h"
+#include "systems/GhostKernel.h"
+#include "systems/GhostScheduler.h"
+#include "systems/HierarchicalPathfinder.h"
+
+enum class CaptureCheck {
+    // Every ghost is tested against both players inside the movement kernel.
+    BruteForce,
+    // Ghosts are bucketed into a CaptureGrid and each player only tests the
+    // ghosts in the cells around it.
+    Grid
+};
 
 class GhostSystem {
 public:
-    void Update(std::vector<Ghost>& ghosts,
+    // Not const: keeps one flow field per player and only rebuilds it when
+    // that player has moved onto a different tile.
+    void Update(GhostArray& ghosts,
                 const TileMap& map,
                 Player& playerA,
                 Player& playerB,
                 float deltaSeconds,
-                int tilePixelSize) const;
+                int tilePixelSize);
+
+    // Auto picks AVX2 when the CPU has it. Requests the CPU cannot honour fall back to Scalar.
+    void SetKernel(GhostKernel kernel) { kernel_ = ResolveGhostKernel(kernel); }
+    GhostKernel GetKernel() const { return kernel_; }
+
+    // Both checks catch exactly the same players; they only differ in cost.
+    void SetCaptureCheck(CaptureCheck check) { captureCheck_ = check; }
+    CaptureCheck GetCaptureCheck() const { return captureCheck_; }
+
+    // Budgeted scheduling changes how ghosts move, so recordings store it.
+    void SetSchedule(GhostSchedule schedule) { schedule_ = schedule; }
+    GhostSchedule GetSchedule() const { return schedule_; }
+    void SetScheduleRules(const GhostScheduleRules& rules) { scheduler_.SetRules(rules); }
+    const GhostScheduleRules& GetScheduleRules() const { return scheduler_.GetRules(); }
+    // Only counted under GhostSchedule::Budgeted.
+    const GhostScheduleStats& GetScheduleStats() const { return scheduler_.GetStats(); }
+    // Call whenever the ghosts are respawned.
+    void ResetSchedule(size_t ghostCount) { scheduler_.Reset(ghostCount); }
+    // The schedule is the only state kept between ticks that is not a cache
+    // of the map and player positions, so it is all a rollback has to restore.
+    void SaveSchedule(GhostScheduler::State& state) const { scheduler_.SaveState(state); }
+    void LoadSchedule(const GhostScheduler::State& state) { scheduler_.LoadState(state); }
+
+    // Routes ghosts whose role is not Chase.
+    const HierarchicalPathfinder::Stats& GetPathfinderStats() const { return pathfinder_.GetStats(); }
+
+private:
+    struct TilePoint {
+        int x = 0;
+        int y = 0;
+    };
+
+    void MoveGhosts(GhostArray& ghosts, const TileMap& map, const Player& playerA, const Player& playerB,
+                    const GhostStepParams& params, int tilePixelSize, uint8_t* captureHits);
+    void MoveScheduledGhosts(GhostArray& ghosts, const TileMap& map, const Player& playerA, const Player& playerB,
+                             const GhostStepParams& params, int tilePixelSize, uint8_t* captureHits);
+    // Where ghost i steers this tick; advances a patrolling ghost's waypoint.
+    Vector2 ChooseGoal(GhostArray& ghosts, size_t i, const TileMap& map, const Player& playerA,
+                       const Player& playerB, const GhostStepParams& params, int tilePixelSize);
+    TilePoint ChooseRoleTarget(GhostArray& ghosts, size_t i, TilePoint tile, const TileMap& map,
+                               const Player& playerA, const Player& playerB, const GhostStepParams& params,
+                               int tilePixelSize);
+    void RefreshCorners(const TileMap& map);
+
+    FlowField fieldA_{};
+    FlowField fieldB_{};
+    GhostKernel kernel_ = ResolveGhostKernel(GhostKernel::Auto);
+    CaptureCheck captureCheck_ = CaptureCheck::BruteForce;
+    CaptureGrid captureGrid_{};
+    GhostSchedule schedule_ = GhostSchedule::Full;
+    GhostScheduler scheduler_{};
+    HierarchicalPathfinder pathfinder_{};
+    // Open tiles nearest each map corner, clockwise from the top left.
+    std::array<TilePoint, 4> corners_{};
+    const uint64_t* cornersWalls_ = nullptr;
+    uint32_t cornersRevision_ = 0;
+
+    // Per-tick scratch, kept between ticks to avoid reallocating.
+    std::vector<float> goalX_{};
+    std::vector<float> goalY_{};
+    std::vector<uint8_t> captureHits_{};
+    std::vector<uint32_t> decisions_{};
+    GhostArray batch_{};
+    std::vector<uint8_t> batchHits_{};
+    std::vector<uint8_t> skip_{};
+    std::vector<uint8_t> blocked_{};
 };
@@ -0,0 +1,503 @@
+#include "systems/HierarchicalPathfinder.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr int kTiles = HierarchicalPathfinder::kClusterTiles;
+
+    // Runs of open border up to this long get one entrance in the middle,
+    // longer ones one at each end.
+    constexpr int kShortEntrance = 5;
+
+    // Once every part of the source cluster has an exit, a route search
+    // stops when nothing left in the queue could beat the last of them by
+    // more than this many steps; no walk inside a cluster saves more.
+    constexpr int32_t kDetourSlack = 4 * kTiles;
+
+    struct ClusterRect {
+        int x0;
+        int y0;
+        int width;
+        int height;
+    };
+
+    uint64_t RouteKey(int sourceCluster, uint32_t target) {
+        return (static_cast<uint64_t>(sourceCluster) << 32) | target;
+    }
+
+    bool QueueLater(const auto& a, const auto& b) {
+        if (a.estimate != b.estimate) {
+            return a.estimate > b.estimate;
+        }
+        return a.cost < b.cost;
+    }
+}
+
+void HierarchicalPathfinder::SetCacheCapacity(size_t routes, size_t fields) {
+    routes_.SetCapacity(routes);
+    // A route lookup reads one field per source exit; keep them all.
+    fields_.SetCapacity(std::max<size_t>(fields, 4 * kTiles));
+}
+
+void HierarchicalPathfinder::Sync(const TileMap& map) {
+    Sync(map.GetWallWords(), map.GetWordsPerRow(), map.GetWidth(), map.GetHeight(), map.GetLayoutRevision());
+}
+
+void HierarchicalPathfinder::Sync(const uint64_t* walls, int wordsPerRow, int width, int height,
+                                  uint32_t layoutRevision) {
+    if (width == width_ && height == height_ && walls == walls_ && layoutRevision == layoutRevision_) {
+        return;
+    }
+
+    walls_ = walls;
+    wordsPerRow_ = wordsPerRow;
+    width_ = width;
+    height_ = height;
+    layoutRevision_ = layoutRevision;
+    clustersWide_ = (width_ + kTiles - 1) / kTiles;
+    clustersHigh_ = (height_ + kTiles - 1) / kTiles;
+
+    clusters_.clear();
+    clusters_.resize(static_cast<size_t>(clustersWide_) * clustersHigh_);
+    routes_.Clear();
+    fields_.Clear();
+    searchStamp_ = 0;
+}
+
+void HierarchicalPathfinder::InvalidateRegion(int minX, int minY, int maxX, int maxY) {
+    if (clusters_.empty()) {
+        return;
+    }
+
+    // A tile on a cluster border also shapes the neighbour's entrances.
+    minX = std::clamp(minX - 1, 0, width_ - 1);
+    minY = std::clamp(minY - 1, 0, height_ - 1);
+    maxX = std::clamp(maxX + 1, 0, width_ - 1);
+    maxY = std::clamp(maxY + 1, 0, height_ - 1);
+    const int minClusterX = minX / kTiles;
+    const int minClusterY = minY / kTiles;
+    const int maxClusterX = maxX / kTiles;
+    const int maxClusterY = maxY / kTiles;
+
+    for (int cy = minClusterY; cy <= maxClusterY; ++cy) {
+        for (int cx = minClusterX; cx <= maxClusterX; ++cx) {
+            clusters_[static_cast<size_t>(cy) * clustersWide_ + cx] = Cluster{};
+        }
+    }
+
+    routes_.EraseIf([&](uint64_t, const Route& route) {
+        return route.minClusterX <= maxClusterX && route.maxClusterX >= minClusterX
+            && route.minClusterY <= maxClusterY && route.maxClusterY >= minClusterY;
+    });
+    fields_.EraseIf([&](uint32_t tile, const Field&) {
+        const int cx = static_cast<int>(tile % width_) / kTiles;
+        const int cy = static_cast<int>(tile / width_) / kTiles;
+        return cx >= minClusterX && cx <= maxClusterX && cy >= minClusterY && cy <= maxClusterY;
+    });
+}
+
+bool HierarchicalPathfinder::NextStep(const TileMap& map, int fromX, int fromY, int toX, int toY,
+                                      int& stepX, int& stepY) {
+    Sync(map);
+    return NextStep(fromX, fromY, toX, toY, stepX, stepY);
+}
+
+bool HierarchicalPathfinder::NextStep(int fromX, int fromY, int toX, int toY, int& stepX, int& stepY) {
+    if (static_cast<unsigned>(fromX) >= static_cast<unsigned>(width_) ||
+        static_cast<unsigned>(fromY) >= static_cast<unsigned>(height_) ||
+        static_cast<unsigned>(toX) >= static_cast<unsigned>(width_) ||
+        static_cast<unsigned>(toY) >= static_cast<unsigned>(height_) ||
+        (fromX == toX && fromY == toY)) {
+        return false;
+    }
+
+    const uint32_t from = static_cast<uint32_t>(fromY) * width_ + fromX;
+    const uint32_t to = static_cast<uint32_t>(toY) * width_ + toX;
+    const int sourceCluster = ClusterOf(fromX, fromY);
+    const int targetCluster = ClusterOf(toX, toY);
+    if (sourceCluster == targetCluster && StepAlongField(to, fromX, fromY, stepX, stepY)) {
+        return true;
+    }
+
+    // A target walled in inside its cluster has nowhere to be reached from.
+    EnsureNodes(targetCluster);
+    {
+        const Field& targetField = GetField(to);
+        const std::vector<Node>& entrances = clusters_[targetCluster].nodes;
+        if (std::none_of(entrances.begin(), entrances.end(), [&](const Node& entrance) {
+                return targetField[LocalIndex(entrance.tile)] != kFieldUnreachable;
+            })) {
+            return false;
+        }
+    }
+
+    const uint64_t key = RouteKey(sourceCluster, to);
+    const Route* route = routes_.Find(key);
+    if (route != nullptr) {
+        ++stats_.pathHits;
+    } else {
+        ++stats_.pathMisses;
+        route = &routes_.Insert(key, BuildRoute(sourceCluster, targetCluster, to));
+    }
+
+    // Leave through whichever exit is cheapest counting the walk to it.
+    const std::vector<Node>& exits = clusters_[sourceCluster].nodes;
+    int32_t bestCost = kUnreachable;
+    size_t bestExit = 0;
+    for (size_t e = 0; e < exits.size(); ++e) {
+        if (route->exitCost[e] == kUnreachable) {
+            continue;
+        }
+        const uint16_t walk = FieldDistance(exits[e].tile, from);
+        if (walk != kFieldUnreachable && walk + route->exitCost[e] < bestCost) {
+            bestCost = walk + route->exitCost[e];
+            bestExit = e;
+        }
+    }
+
+    if (bestCost == kUnreachable) {
+        return false;
+    }
+    if (exits[bestExit].tile == from) {
+        const uint32_t across = route->exitTile[bestExit];
+        stepX = static_cast<int>(across % width_);
+        stepY = static_cast<int>(across / width_);
+        return true;
+    }
+    return StepAlongField(exits[bestExit].tile, fromX, fromY, stepX, stepY);
+}
+
+bool HierarchicalPathfinder::IsWall(int x, int y) const {
+    if (static_cast<unsigned>(x) >= static_cast<unsigned>(width_) ||
+        static_cast<unsigned>(y) >= static_cast<unsigned>(height_)) {
+        return true;
+    }
+    return (walls_[static_cast<size_t>(y) * wordsPerRow_ + (static_cast<unsigned>(x) >> 6)] >> (x & 63)) & 1u;
+}
+
+void HierarchicalPathfinder::AddCrossing(Cluster& cluster, uint32_t tile, uint32_t across) {
+    for (Node& node : cluster.nodes) {
+        if (node.tile == tile) {
+            if (node.crossingCount < 2) {
+                node.crossings[node.crossingCount++] = across;
+            }
+            return;
+        }
+    }
+
+    Node node{};
+    node.tile = tile;
+    node.crossings[0] = across;
+    node.crossingCount = 1;
+    cluster.nodes.push_back(node);
+}
+
+void HierarchicalPathfinder::AddBorder(Cluster& cluster, int fromX, int fromY, int stepX, int stepY,
+                                       int acrossX, int acrossY, int length) {
+    // Both clusters on a border walk it from the same end, so they place
+    // matching entrances.
+    auto addAt = [&](int k) {
+        const int x = fromX + k * stepX;
+        const int y = fromY + k * stepY;
+        AddCrossing(cluster,
+                    static_cast<uint32_t>(y) * width_ + x,
+                    static_cast<uint32_t>(y + acrossY) * width_ + (x + acrossX));
+    };
+
+    int runStart = -1;
+    for (int k = 0; k <= length; ++k) {
+        const int x = fromX + k * stepX;
+        const int y = fromY + k * stepY;
+        const bool open = k < length && !IsWall(x, y) && !IsWall(x + acrossX, y + acrossY);
+        if (open && runStart < 0) {
+            runStart = k;
+        } else if (!open && runStart >= 0) {
+            const int runLength = k - runStart;
+            if (runLength <= kShortEntrance) {
+                addAt(runStart + runLength / 2);
+            } else {
+                addAt(runStart);
+                addAt(k - 1);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void HierarchicalPathfinder::EnsureNodes(int clusterIndex) {
+    Cluster& cluster = clusters_[clusterIndex];
+    if (cluster.hasNodes) {
+        return;
+    }
+
+    const int cx = clusterIndex % clustersWide_;
+    const int cy = clusterIndex / clustersWide_;
+    const int x0 = cx * kTiles;
+    const int y0 = cy * kTiles;
+    const int width = std::min(kTiles, width_ - x0);
+    const int height = std::min(kTiles, height_ - y0);
+
+    if (cx > 0) {
+        AddBorder(cluster, x0, y0, 0, 1, -1, 0, height);
+    }
+    if (cy > 0) {
+        AddBorder(cluster, x0, y0, 1, 0, 0, -1, width);
+    }
+    if (cx + 1 < clustersWide_) {
+        AddBorder(cluster, x0 + width - 1, y0, 0, 1, 1, 0, height);
+    }
+    if (cy + 1 < clustersHigh_) {
+        AddBorder(cluster, x0, y0 + height - 1, 1, 0, 0, 1, width);
+    }
+    cluster.hasNodes = true;
+}
+
+void HierarchicalPathfinder::EnsureEdges(int clusterIndex) {
+    EnsureNodes(clusterIndex);
+    Cluster& cluster = clusters_[clusterIndex];
+    if (cluster.hasEdges) {
+        return;
+    }
+
+    const size_t count = cluster.nodes.size();
+    cluster.edges.assign(count * count, kUnreachable);
+    for (size_t i = 0; i < count; ++i) {
+        const Field& field = GetField(cluster.nodes[i].tile);
+        for (size_t j = 0; j < count; ++j) {
+            const uint16_t distance = field[LocalIndex(cluster.nodes[j].tile)];
+            if (distance != kFieldUnreachable) {
+                cluster.edges[i * count + j] = distance;
+            }
+        }
+    }
+    cluster.hasEdges = true;
+    ++stats_.clustersBuilt;
+}
+
+int HierarchicalPathfinder::FindNode(int clusterIndex, uint32_t tile) const {
+    const std::vector<Node>& nodes = clusters_[clusterIndex].nodes;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].tile == tile) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void HierarchicalPathfinder::BuildField(uint32_t tile, Field& field) {
+    const int tileX = static_cast<int>(tile % width_);
+    const int tileY = static_cast<int>(tile / width_);
+    const ClusterRect rect{
+        tileX / kTiles * kTiles,
+        tileY / kTiles * kTiles,
+        std::min(kTiles, width_ - tileX / kTiles * kTiles),
+        std::min(kTiles, height_ - tileY / kTiles * kTiles)
+    };
+
+    field.fill(kFieldUnreachable);
+    bfsQueue_.resize(kTiles * kTiles);
+    size_t head = 0;
+    size_t tail = 0;
+    const uint16_t start = static_cast<uint16_t>((tileY - rect.y0) * kTiles + (tileX - rect.x0));
+    field[start] = 0;
+    bfsQueue_[tail++] = start;
+
+    const int offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+    while (head < tail) {
+        const uint16_t cell = bfsQueue_[head++];
+        const int localX = cell % kTiles;
+        const int localY = cell / kTiles;
+        for (const auto& offset : offsets) {
+            const int x = localX + offset[0];
+            const int y = localY + offset[1];
+            if (x < 0 || y < 0 || x >= rect.width || y >= rect.height) {
+                continue;
+            }
+            const uint16_t neighbour = static_cast<uint16_t>(y * kTiles + x);
+            if (field[neighbour] != kFieldUnreachable || IsWall(rect.x0 + x, rect.y0 + y)) {
+                continue;
+            }
+            field[neighbour] = static_cast<uint16_t>(field[cell] + 1);
+            bfsQueue_[tail++] = neighbour;
+        }
+    }
+}
+
+const HierarchicalPathfinder::Field& HierarchicalPathfinder::GetField(uint32_t tile) {
+    if (const Field* field = fields_.Find(tile)) {
+        ++stats_.fieldHits;
+        return *field;
+    }
+
+    ++stats_.fieldMisses;
+    Field field;
+    BuildField(tile, field);
+    return fields_.Insert(tile, field);
+}
+
+uint16_t HierarchicalPathfinder::FieldDistance(uint32_t from, uint32_t to) {
+    return GetField(from)[LocalIndex(to)];
+}
+
+bool HierarchicalPathfinder::StepAlongField(uint32_t target, int fromX, int fromY, int& stepX, int& stepY) {
+    const Field& field = GetField(target);
+    const int x0 = fromX / kTiles * kTiles;
+    const int y0 = fromY / kTiles * kTiles;
+    const int width = std::min(kTiles, width_ - x0);
+    const int height = std::min(kTiles, height_ - y0);
+    const int localX = fromX - x0;
+    const int localY = fromY - y0;
+
+    const uint16_t distance = field[localY * kTiles + localX];
+    if (distance == kFieldUnreachable || distance == 0) {
+        return false;
+    }
+
+    const int offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+    for (const auto& offset : offsets) {
+        const int x = localX + offset[0];
+        const int y = localY + offset[1];
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            continue;
+        }
+        if (field[y * kTiles + x] == distance - 1) {
+            stepX = x0 + x;
+            stepY = y0 + y;
+            return true;
+        }
+    }
+    return false;
+}
+
+HierarchicalPathfinder::Route HierarchicalPathfinder::BuildRoute(int sourceCluster, int targetCluster,
+                                                                  uint32_t target) {
+    if (++searchStamp_ == 0) {
+        for (Cluster& cluster : clusters_) {
+            cluster.searchStamp = 0;
+        }
+        searchStamp_ = 1;
+    }
+    EnsureEdges(sourceCluster);
+
+    // Each exit is labelled with the first exit it can walk to; the search
+    // must reach every part of a split source cluster before it stops.
+    const Cluster& source = clusters_[sourceCluster];
+    const size_t exitCount = source.nodes.size();
+    exitPart_.resize(exitCount);
+    partFound_.assign(exitCount, 0);
+    size_t partsLeft = 0;
+    for (size_t e = 0; e < exitCount; ++e) {
+        size_t part = 0;
+        while (source.edges[e * exitCount + part] == kUnreachable) {
+            ++part;
+        }
+        exitPart_[e] = static_cast<uint8_t>(part);
+        partsLeft += part == e ? 1 : 0;
+    }
+
+    Route route;
+    route.exitCost.assign(clusters_[sourceCluster].nodes.size(), kUnreachable);
+    route.exitTile.assign(clusters_[sourceCluster].nodes.size(), 0);
+    route.minClusterX = std::min(sourceCluster % clustersWide_, targetCluster % clustersWide_);
+    route.maxClusterX = std::max(sourceCluster % clustersWide_, targetCluster % clustersWide_);
+    route.minClusterY = std::min(sourceCluster / clustersWide_, targetCluster / clustersWide_);
+    route.maxClusterY = std::max(sourceCluster / clustersWide_, targetCluster / clustersWide_);
+
+    // Searched outwards from every entrance the target can walk to, each
+    // starting at the length of that walk, with the distance to the source
+    // cluster's rectangle as the (consistent) heuristic. An exit's cost only counts arrivals across the border, so a
+    // ghost standing on it always has a tile to cross into; the search still
+    // walks through the source cluster, since a split cluster may have to be
+    // left and re-entered.
+    const int sourceX0 = sourceCluster % clustersWide_ * kTiles;
+    const int sourceY0 = sourceCluster / clustersWide_ * kTiles;
+    const int sourceX1 = std::min(sourceX0 + kTiles, width_) - 1;
+    const int sourceY1 = std::min(sourceY0 + kTiles, height_) - 1;
+    auto estimate = [&](uint32_t tile) {
+        const int x = static_cast<int>(tile % width_);
+        const int y = static_cast<int>(tile / width_);
+        const int dx = std::max({ 0, sourceX0 - x, x - sourceX1 });
+        const int dy = std::max({ 0, sourceY0 - y, y - sourceY1 });
+        return static_cast<int32_t>(dx + dy);
+    };
+    auto later = [](const QueueItem& a, const QueueItem& b) { return QueueLater(a, b); };
+    auto push = [&](int clusterIndex, int node, int32_t cost) {
+        Cluster& cluster = clusters_[clusterIndex];
+        if (cluster.searchStamp != searchStamp_) {
+            cluster.cost.assign(cluster.nodes.size(), kUnreachable);
+            cluster.searchStamp = searchStamp_;
+        }
+        if (cost >= cluster.cost[node]) {
+            return;
+        }
+        cluster.cost[node] = cost;
+        queue_.push_back(QueueItem{ cost + estimate(cluster.nodes[node].tile), cost, clusterIndex, node });
+        std::push_heap(queue_.begin(), queue_.end(), later);
+    };
+
+    queue_.clear();
+    {
+        const Field& targetField = GetField(target);
+        const std::vector<Node>& entrances = clusters_[targetCluster].nodes;
+        for (size_t j = 0; j < entrances.size(); ++j) {
+            const uint16_t walk = targetField[LocalIndex(entrances[j].tile)];
+            if (walk != kFieldUnreachable) {
+                push(targetCluster, static_cast<int>(j), walk);
+            }
+        }
+    }
+
+    int32_t lastPartCost = 0;
+    while (!queue_.empty()) {
+        std::pop_heap(queue_.begin(), queue_.end(), later);
+        const QueueItem item = queue_.back();
+        queue_.pop_back();
+
+        if (item.cost > clusters_[item.cluster].cost[item.node]) {
+            continue;
+        }
+        if (partsLeft == 0 && item.estimate > lastPartCost + kDetourSlack) {
+            break;
+        }
+
+        ++stats_.nodesExpanded;
+        const int cx = item.cluster % clustersWide_;
+        const int cy = item.cluster / clustersWide_;
+        route.minClusterX = std::min(route.minClusterX, cx);
+        route.maxClusterX = std::max(route.maxClusterX, cx);
+        route.minClusterY = std::min(route.minClusterY, cy);
+        route.maxClusterY = std::max(route.maxClusterY, cy);
+
+        const Node node = clusters_[item.cluster].nodes[item.node];
+        for (uint8_t k = 0; k < node.crossingCount; ++k) {
+            const uint32_t across = node.crossings[k];
+            const int acrossCluster = ClusterOf(static_cast<int>(across % width_), static_cast<int>(across / width_));
+            EnsureNodes(acrossCluster);
+            const int next = FindNode(acrossCluster, across);
+            if (next < 0) {
+                continue;
+            }
+            if (acrossCluster == sourceCluster && item.cost + 1 < route.exitCost[next]) {
+                route.exitCost[next] = item.cost + 1;
+                route.exitTile[next] = node.tile;
+                if (!partFound_[exitPart_[next]]) {
+                    partFound_[exitPart_[next]] = 1;
+                    --partsLeft;
+                    lastPartCost = item.cost + 1;
+                }
+            }
+            push(acrossCluster, next, item.cost + 1);
+        }
+
+        EnsureEdges(item.cluster);
+        const Cluster& cluster = clusters_[item.cluster];
+        const size_t count = cluster.nodes.size();
+        for (size_t m = 0; m < count; ++m) {
+            const int32_t edge = cluster.edges[static_cast<size_t>(item.node) * count + m];
+            if (static_cast<int>(m) != item.node && edge != kUnreachable) {
+                push(item.cluster, static_cast<int>(m), item.cost + edge);
+            }
+        }
+    }
+    return route;
+}
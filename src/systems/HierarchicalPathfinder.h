@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game/TileMap.h"
+#include "sim/LruCache.h"
+
+// Hierarchical A* (HPA*) over the tile grid. The map is cut into square
+// clusters; every run of open tiles along a shared cluster border becomes
+// one or two entrances, and each cluster links its entrances by their
+// shortest path inside it. Searches run over that small graph instead of
+// over tiles, and a cluster is only abstracted the first time a search
+// reaches it, so a million-tile map pays for the regions ghosts use.
+//
+// Routes are cached per (source cluster, target tile): one search, seeded
+// from the target cluster's entrances at their walk to the target, finds
+// the cost of reaching the target through every exit of the source cluster,
+// which serves every tile of the source cluster. Ghosts then take the exit
+// that is cheapest counting their walk to it. Within a cluster, steps follow
+// a breadth-first distance field of its tiles, also cached. Paths come out
+// within a few percent of the shortest, as usual for HPA*.
+class HierarchicalPathfinder {
+public:
+    static constexpr int kClusterTiles = 16;
+
+    struct Stats {
+        uint64_t pathHits = 0;
+        uint64_t pathMisses = 0;
+        uint64_t fieldHits = 0;
+        uint64_t fieldMisses = 0;
+        uint64_t clustersBuilt = 0;
+        uint64_t nodesExpanded = 0;
+    };
+
+    // Entries kept in the route cache and in the in-cluster field cache.
+    void SetCacheCapacity(size_t routes, size_t fields);
+
+    // Forgets everything when the map's size, wall plane or layout revision
+    // differs from the last call. NextStep calls this itself.
+    void Sync(const TileMap& map);
+    // The same for a wall plane laid out as TileMap::GetWallWords, which
+    // must stay alive and in place until the next Sync.
+    void Sync(const uint64_t* walls, int wordsPerRow, int width, int height, uint32_t layoutRevision);
+
+    // Rebuilds only what tiles [minX, maxX] x [minY, maxY] can affect: the
+    // clusters covering them and their border neighbours, their fields, and
+    // the cached routes whose search passed through any of those clusters.
+    // For callers that change walls in place without a new layout revision.
+    void InvalidateRegion(int minX, int minY, int maxX, int maxY);
+
+    // Sets (stepX, stepY) to the tile one step from (fromX, fromY) towards
+    // (toX, toY). False when the two are the same tile or no route was found.
+    bool NextStep(const TileMap& map, int fromX, int fromY, int toX, int toY, int& stepX, int& stepY);
+    // The same over the wall plane given to the last Sync.
+    bool NextStep(int fromX, int fromY, int toX, int toY, int& stepX, int& stepY);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr int32_t kUnreachable = INT32_MAX;
+    static constexpr uint16_t kFieldUnreachable = UINT16_MAX;
+
+    // Distances from one tile to every tile of its cluster, indexed
+    // localY * kClusterTiles + localX.
+    using Field = std::array<uint16_t, kClusterTiles * kClusterTiles>;
+
+    struct Node {
+        uint32_t tile = 0;
+        // Tiles across the cluster border this entrance leads to; a corner
+        // tile can sit on two borders.
+        uint32_t crossings[2]{};
+        uint8_t crossingCount = 0;
+    };
+
+    struct Cluster {
+        bool hasNodes = false;
+        bool hasEdges = false;
+        std::vector<Node> nodes{};
+        // nodes.size() squared in-cluster path lengths, kUnreachable when none.
+        std::vector<int32_t> edges{};
+        // Search scratch, valid while searchStamp matches the pathfinder's.
+        std::vector<int32_t> cost{};
+        uint32_t searchStamp = 0;
+    };
+
+    struct Route {
+        // Per source cluster node: steps from it to the target when the
+        // first step crosses the border, and the tile that step lands on. A
+        // target in the same cluster is only reached this way when the field
+        // inside the cluster cannot reach it.
+        std::vector<int32_t> exitCost{};
+        std::vector<uint32_t> exitTile{};
+        // Clusters the search expanded, for InvalidateRegion.
+        int minClusterX = 0;
+        int minClusterY = 0;
+        int maxClusterX = 0;
+        int maxClusterY = 0;
+    };
+
+    int ClusterOf(int x, int y) const { return (y / kClusterTiles) * clustersWide_ + x / kClusterTiles; }
+    int LocalIndex(uint32_t tile) const {
+        return static_cast<int>((tile / width_) % kClusterTiles * kClusterTiles + (tile % width_) % kClusterTiles);
+    }
+    bool IsWall(int x, int y) const;
+    void EnsureNodes(int cluster);
+    void EnsureEdges(int cluster);
+    void AddCrossing(Cluster& cluster, uint32_t tile, uint32_t across);
+    void AddBorder(Cluster& cluster, int fromX, int fromY, int stepX, int stepY, int acrossX, int acrossY, int length);
+    int FindNode(int cluster, uint32_t tile) const;
+    void BuildField(uint32_t tile, Field& field);
+    uint16_t FieldDistance(uint32_t from, uint32_t to);
+    const Field& GetField(uint32_t tile);
+    Route BuildRoute(int sourceCluster, int targetCluster, uint32_t target);
+    bool StepAlongField(uint32_t target, int fromX, int fromY, int& stepX, int& stepY);
+
+    const uint64_t* walls_ = nullptr;
+    int wordsPerRow_ = 0;
+    int width_ = -1;
+    int height_ = -1;
+    uint32_t layoutRevision_ = 0;
+    int clustersWide_ = 0;
+    int clustersHigh_ = 0;
+
+    std::vector<Cluster> clusters_{};
+    LruCache<uint64_t, Route> routes_{ 4096 };
+    LruCache<uint32_t, Field> fields_{ 4096 };
+    uint32_t searchStamp_ = 0;
+    Stats stats_{};
+
+    struct QueueItem {
+        int32_t estimate;
+        int32_t cost;
+        int32_t cluster;
+        int32_t node;
+    };
+    std::vector<QueueItem> queue_{};
+    std::vector<uint16_t> bfsQueue_{};
+    std::vector<uint8_t> exitPart_{};
+    std::vector<uint8_t> partFound_{};
+};
@@ -12,41 +12,49 @@ namespace Input {
         return { value.x / length, value.y / length };
     }
 
-    Vector2 GetPlayer1Direction() {
+    Vector2 DirectionFromKeys(bool up, bool down, bool left, bool right) {
         Vector2 dir = { 0.0f, 0.0f };
-        if (IsKeyDown(KEY_W)) {
+        if (up) {
             dir.y -= 1.0f;
         }
-        if (IsKeyDown(KEY_S)) {
+        if (down) {
             dir.y += 1.0f;
         }
-        if (IsKeyDown(KEY_A)) {
+        if (left) {
             dir.x -= 1.0f;
         }
-        if (IsKeyDown(KEY_D)) {
+        if (right) {
             dir.x += 1.0f;
         }
         return Normalize(dir);
     }
 
+    Vector2 GetPlayer1Direction() {
+        return DirectionFromKeys(IsKeyDown(KEY_W), IsKeyDown(KEY_S), IsKeyDown(KEY_A), IsKeyDown(KEY_D));
+    }
+
     Vector2 GetPlayer2Direction() {
-        Vector2 dir = { 0.0f, 0.0f };
-        if (IsKeyDown(KEY_UP)) {
-            dir.y -= 1.0f;
-        }
-        if (IsKeyDown(KEY_DOWN)) {
-            dir.y += 1.0f;
-        }
-        if (IsKeyDown(KEY_LEFT)) {
-            dir.x -= 1.0f;
-        }
-        if (IsKeyDown(KEY_RIGHT)) {
-            dir.x += 1.0f;
-        }
-        return Normalize(dir);
+        return DirectionFromKeys(IsKeyDown(KEY_UP), IsKeyDown(KEY_DOWN), IsKeyDown(KEY_LEFT), IsKeyDown(KEY_RIGHT));
     }
 
     bool IsStartPressed() {
         return IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_SPACE);
     }
+
+    bool IsResetPressed() {
+        return IsKeyPressed(KEY_R);
+    }
+
+    bool IsTraceDumpPressed() {
+        return IsKeyPressed(KEY_F9);
+    }
+}
+
+InputFrame KeyboardInputSource::Poll() {
+    InputFrame frame{};
+    frame.player1Direction = Input::GetPlayer1Direction();
+    frame.player2Direction = Input::GetPlayer2Direction();
+    frame.startPressed = Input::IsStartPressed();
+    frame.resetPressed = Input::IsResetPressed();
+    return frame;
 }
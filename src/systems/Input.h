@@ -1,9 +1,20 @@
 #pragma once
 
 #include "raylib.h"
+#include "sim/InputSource.h"
 
 namespace Input {
+    // Pure math on key states; safe to call from any thread.
+    Vector2 DirectionFromKeys(bool up, bool down, bool left, bool right);
     Vector2 GetPlayer1Direction();
     Vector2 GetPlayer2Direction();
     bool IsStartPressed();
+    bool IsResetPressed();
+    bool IsTraceDumpPressed();
 }
+
+// Feeds the simulation from the shared keyboard (P1 WASD, P2 arrows).
+class KeyboardInputSource : public InputSource {
+public:
+    InputFrame Poll() override;
+};
@@ -0,0 +1,105 @@
+#include "systems/InputSampler.h"
+
+#include <chrono>
+
+#include "sim/Profiler.h"
+#include "systems/Input.h"
+#include "systems/KeyState.h"
+
+namespace {
+    bool SameDirection(Vector2 a, Vector2 b) {
+        return a.x == b.x && a.y == b.y;
+    }
+}
+
+InputSampler::~InputSampler() {
+    Stop();
+}
+
+bool InputSampler::Start(int pollHz) {
+    Stop();
+    if (!KeyState::IsAvailable() || pollHz <= 0) {
+        return false;
+    }
+
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread([this, pollHz] { PollLoop(pollHz); });
+    return true;
+}
+
+void InputSampler::Stop() {
+    if (thread_.joinable()) {
+        stopping_.store(true, std::memory_order_relaxed);
+        thread_.join();
+    }
+}
+
+void InputSampler::Submit(Vector2 player1Direction, Vector2 player2Direction) {
+    PushIfChanged(player1Direction, player2Direction);
+}
+
+void InputSampler::Consume(int64_t untilNs, InputFrame& frame, LatencyStats& latency) {
+    const int64_t now = Now();
+    while (const TimedInput* change = queue_.Peek()) {
+        if (change->timestampNs > untilNs) {
+            break;
+        }
+        held_ = *change;
+        latency.Add(now - change->timestampNs);
+        queue_.Pop();
+    }
+
+    frame.player1Direction = held_.player1Direction;
+    frame.player2Direction = held_.player2Direction;
+}
+
+int64_t InputSampler::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InputSampler::PushIfChanged(Vector2 player1Direction, Vector2 player2Direction) {
+    if (SameDirection(player1Direction, lastPushed_.player1Direction)
+        && SameDirection(player2Direction, lastPushed_.player2Direction)) {
+        return;
+    }
+
+    const TimedInput change{ Now(), player1Direction, player2Direction };
+    if (queue_.Push(change)) {
+        lastPushed_ = change;
+    } else {
+        // Leave lastPushed_ alone so the change is retried on the next poll.
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void InputSampler::PollLoop(int pollHz) {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::nanoseconds(1000000000LL / pollHz);
+
+    Profiler::SetThreadName("input");
+
+    // raylib raises the Windows timer resolution to 1 ms at startup, so these
+    // sleeps wake close to the requested rate.
+    auto next = Clock::now();
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        Vector2 player1Direction{ 0.0f, 0.0f };
+        Vector2 player2Direction{ 0.0f, 0.0f };
+        if (focused_.load(std::memory_order_relaxed)) {
+            using KeyState::Key;
+            player1Direction = Input::DirectionFromKeys(KeyState::IsDown(Key::W), KeyState::IsDown(Key::S),
+                                                        KeyState::IsDown(Key::A), KeyState::IsDown(Key::D));
+            player2Direction = Input::DirectionFromKeys(KeyState::IsDown(Key::Up), KeyState::IsDown(Key::Down),
+                                                        KeyState::IsDown(Key::Left), KeyState::IsDown(Key::Right));
+        }
+        PushIfChanged(player1Direction, player2Direction);
+
+        next += period;
+        const auto now = Clock::now();
+        if (next < now) {
+            // Fell behind (the process was descheduled); do not burst to catch up.
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
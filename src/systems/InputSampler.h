@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "raylib.h"
+#include "sim/InputSource.h"
+#include "sim/LatencyStats.h"
+#include "sim/SpscQueue.h"
+
+// One direction change for both players, stamped when it was sampled.
+struct TimedInput {
+    int64_t timestampNs = 0;
+    Vector2 player1Direction{ 0.0f, 0.0f };
+    Vector2 player2Direction{ 0.0f, 0.0f };
+};
+
+// Samples the movement keys on a dedicated thread at a fixed rate and queues
+// each change with its timestamp, so the game loop can hand every change to
+// the simulation step it happened in instead of the frame it was noticed in.
+// Where the OS offers no thread-safe key state, no thread is started and the
+// game loop feeds one sample per frame through Submit instead.
+class InputSampler {
+public:
+    InputSampler() = default;
+    ~InputSampler();
+
+    InputSampler(const InputSampler&) = delete;
+    InputSampler& operator=(const InputSampler&) = delete;
+
+    // Returns false when it falls back to per-frame Submit calls.
+    bool Start(int pollHz = 1000);
+    void Stop();
+    bool IsThreaded() const { return thread_.joinable(); }
+
+    // Keys are read system-wide, so the thread reports no movement while the
+    // window is in the background.
+    void SetFocused(bool focused) { focused_.store(focused, std::memory_order_relaxed); }
+
+    // Per-frame fallback; only valid when IsThreaded() is false.
+    void Submit(Vector2 player1Direction, Vector2 player2Direction);
+
+    // Applies every change stamped at or before untilNs to the held
+    // directions, writes them into frame and records how long each change
+    // waited between being sampled and being applied.
+    void Consume(int64_t untilNs, InputFrame& frame, LatencyStats& latency);
+
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static int64_t Now();
+
+private:
+    void PushIfChanged(Vector2 player1Direction, Vector2 player2Direction);
+    void PollLoop(int pollHz);
+
+    // Capacity for several seconds of key mashing between two frames.
+    SpscQueue<TimedInput, 1024> queue_{};
+    std::thread thread_{};
+    std::atomic<bool> stopping_{ false };
+    std::atomic<bool> focused_{ true };
+    std::atomic<uint64_t> dropped_{ 0 };
+
+    // Producer side: the last change pushed.
+    TimedInput lastPushed_{};
+    // Consumer side: the directions currently in effect.
+    TimedInput held_{};
+};
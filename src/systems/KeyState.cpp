@@ -0,0 +1,41 @@
+#include "systems/KeyState.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace KeyState {
+#if defined(_WIN32)
+
+    bool IsAvailable() {
+        return true;
+    }
+
+    bool IsDown(Key key) {
+        int code = 0;
+        switch (key) {
+            case Key::W: code = 'W'; break;
+            case Key::A: code = 'A'; break;
+            case Key::S: code = 'S'; break;
+            case Key::D: code = 'D'; break;
+            case Key::Up: code = VK_UP; break;
+            case Key::Down: code = VK_DOWN; break;
+            case Key::Left: code = VK_LEFT; break;
+            case Key::Right: code = VK_RIGHT; break;
+        }
+        return (GetAsyncKeyState(code) & 0x8000) != 0;
+    }
+
+#else
+
+    bool IsAvailable() {
+        return false;
+    }
+
+    bool IsDown(Key) {
+        return false;
+    }
+
+#endif
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Keyboard state read straight from the OS, safe to call from any thread.
+// raylib only refreshes IsKeyDown when the main thread polls events once per
+// frame, so a sampling thread needs its own source. Kept apart from raylib
+// because the platform headers clash with it.
+namespace KeyState {
+    enum class Key {
+        W, A, S, D,
+        Up, Down, Left, Right
+    };
+
+    // False where there is no thread-safe key state (everything but Windows).
+    bool IsAvailable();
+    bool IsDown(Key key);
+}
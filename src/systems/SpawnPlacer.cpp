@@ -0,0 +1,161 @@
+#include "systems/SpawnPlacer.h"
+
+#include <algorithm>
+
+namespace {
+    const int kSteps[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+
+    // Advances a visit stamp, wiping the stamp array only when it wraps.
+    uint32_t NextStamp(uint32_t& stamp, std::vector<uint32_t>& visited) {
+        if (++stamp == 0) {
+            std::fill(visited.begin(), visited.end(), 0u);
+            stamp = 1;
+        }
+        return stamp;
+    }
+}
+
+void SpawnPlacer::Place(const TileMap& map,
+                        int anchorX,
+                        int anchorY,
+                        int count,
+                        const std::vector<Vector2>& taken,
+                        const SpawnPlacementRules& rules,
+                        std::vector<Vector2>& out) {
+    out.clear();
+    if (count <= 0 || map.GetWidth() <= 0 || map.GetHeight() <= 0) {
+        return;
+    }
+
+    width_ = map.GetWidth();
+    blockedStamp_ = NextStamp(placeStamp_, blocked_);
+    const size_t tileCount = static_cast<size_t>(width_) * map.GetHeight();
+    blocked_.resize(tileCount, 0);
+    visited_.resize(tileCount, 0);
+    blockVisited_.resize(tileCount, 0);
+    queue_.resize(tileCount);
+    blockQueue_.resize(tileCount);
+
+    auto tileOf = [this](Vector2 tile) {
+        return static_cast<int32_t>(tile.y) * width_ + static_cast<int32_t>(tile.x);
+    };
+    auto onMap = [&map](Vector2 tile) {
+        return tile.x >= 0.0f && tile.y >= 0.0f && tile.x < map.GetWidth() && tile.y < map.GetHeight();
+    };
+
+    if (map.HasPlayerSpawnA()) {
+        Block(map, tileOf(map.GetPlayerSpawnA()), rules.minDistanceFromPlayers);
+    }
+    if (map.HasPlayerSpawnB()) {
+        Block(map, tileOf(map.GetPlayerSpawnB()), rules.minDistanceFromPlayers);
+    }
+    for (const Vector2& tile : taken) {
+        if (onMap(tile)) {
+            Block(map, tileOf(tile), rules.minSeparation);
+        }
+    }
+
+    if (!FindOpenTileNear(map, anchorX, anchorY)) {
+        return;
+    }
+
+    out.reserve(count);
+    const uint32_t stamp = NextStamp(stamp_, visited_);
+    size_t head = 0;
+    size_t tail = 0;
+    const int32_t start = anchorY * width_ + anchorX;
+    visited_[start] = stamp;
+    queue_[tail++] = start;
+
+    while (head < tail && static_cast<int>(out.size()) < count) {
+        const int32_t tile = queue_[head++];
+        const int x = tile % width_;
+        const int y = tile / width_;
+
+        if (blocked_[tile] != blockedStamp_) {
+            out.push_back(Vector2{ static_cast<float>(x), static_cast<float>(y) });
+            Block(map, tile, rules.minSeparation);
+        }
+
+        for (const auto& step : kSteps) {
+            const int nx = x + step[0];
+            const int ny = y + step[1];
+            if (map.IsWall(nx, ny)) {
+                continue;
+            }
+            const int32_t neighbour = ny * width_ + nx;
+            if (visited_[neighbour] != stamp) {
+                visited_[neighbour] = stamp;
+                queue_[tail++] = neighbour;
+            }
+        }
+    }
+}
+
+// Marks every open tile within `radius - 1` steps of `tile`, so nothing closer
+// than `radius` can be chosen. A radius of 1 or less blocks just the tile.
+void SpawnPlacer::Block(const TileMap& map, int32_t tile, int radius) {
+    blocked_[tile] = blockedStamp_;
+    if (radius <= 1) {
+        return;
+    }
+
+    const uint32_t stamp = NextStamp(blockStamp_, blockVisited_);
+
+    // The queue holds one depth layer after another; `layerEnd` marks where
+    // the current layer stops.
+    size_t head = 0;
+    size_t tail = 0;
+    blockVisited_[tile] = stamp;
+    blockQueue_[tail++] = tile;
+
+    for (int depth = 1; depth < radius && head < tail; ++depth) {
+        const size_t layerEnd = tail;
+        for (; head < layerEnd; ++head) {
+            const int32_t current = blockQueue_[head];
+            const int x = current % width_;
+            const int y = current / width_;
+
+            for (const auto& step : kSteps) {
+                const int nx = x + step[0];
+                const int ny = y + step[1];
+                if (map.IsWall(nx, ny)) {
+                    continue;
+                }
+                const int32_t neighbour = ny * width_ + nx;
+                if (blockVisited_[neighbour] != stamp) {
+                    blockVisited_[neighbour] = stamp;
+                    blocked_[neighbour] = blockedStamp_;
+                    blockQueue_[tail++] = neighbour;
+                }
+            }
+        }
+    }
+}
+
+// Moves (x, y) to the closest open tile by growing square rings, which is
+// only needed when the anchor itself is a wall.
+bool SpawnPlacer::FindOpenTileNear(const TileMap& map, int& x, int& y) const {
+    x = std::clamp(x, 0, map.GetWidth() - 1);
+    y = std::clamp(y, 0, map.GetHeight() - 1);
+    if (!map.IsWall(x, y)) {
+        return true;
+    }
+
+    const int maxRadius = std::max(map.GetWidth(), map.GetHeight());
+    for (int radius = 1; radius <= maxRadius; ++radius) {
+        for (int dy = -radius; dy <= radius; ++dy) {
+            // Only the ring's edge: full rows at the top and bottom, the two
+            // end columns in between.
+            const int step = (dy == -radius || dy == radius) ? 1 : 2 * radius;
+            for (int dx = -radius; dx <= radius; dx += step) {
+                if (!map.IsWall(x + dx, y + dy)) {
+                    x += dx;
+                    y += dy;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
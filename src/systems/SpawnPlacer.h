@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game/TileMap.h"
+
+// Distances are counted in tile steps along open corridors, not straight lines.
+struct SpawnPlacementRules {
+    // Ghosts start at least this far from the P and Q spawns; 1 only keeps
+    // them off the spawn tiles themselves.
+    int minDistanceFromPlayers = 1;
+    // Ghosts start at least this far from each other and from the map's own
+    // ghost spawns; 1 only keeps them on distinct tiles.
+    int minSeparation = 1;
+};
+
+// Picks ghost spawn tiles in order of path distance from an anchor with a
+// single breadth-first pass over the map. Every accepted tile blocks its
+// neighbourhood with a BFS bounded by the separation distance. Because
+// accepted tiles are spread out, each tile is blocked only a bounded number
+// of times, so a placement costs at most time proportional to the map size
+// however many ghosts are placed, and far less when few are needed.
+class SpawnPlacer {
+public:
+    // Fills `out` with up to `count` tiles reachable from the anchor (the
+    // nearest open tile to it when it is a wall) that satisfy `rules` and
+    // avoid `taken`, fewer when the anchor's region runs out of room. `out`
+    // keeps its capacity, so placing again with the same buffer does not
+    // allocate; it must not be `taken`.
+    void Place(const TileMap& map,
+               int anchorX,
+               int anchorY,
+               int count,
+               const std::vector<Vector2>& taken,
+               const SpawnPlacementRules& rules,
+               std::vector<Vector2>& out);
+
+private:
+    void Block(const TileMap& map, int32_t tile, int radius);
+    bool FindOpenTileNear(const TileMap& map, int& x, int& y) const;
+
+    int width_ = 0;
+    // Per-tile stamps, so nothing is cleared between calls: a tile is blocked
+    // when blocked_ holds this placement's stamp, and visited by the main
+    // search or the latest Block call when the matching array holds theirs.
+    std::vector<uint32_t> blocked_{};
+    std::vector<uint32_t> visited_{};
+    std::vector<uint32_t> blockVisited_{};
+    std::vector<int32_t> queue_{};
+    std::vector<int32_t> blockQueue_{};
+    uint32_t placeStamp_ = 0;
+    uint32_t blockedStamp_ = 0;
+    uint32_t stamp_ = 0;
+    uint32_t blockStamp_ = 0;
+};
@@ -0,0 +1,301 @@
+#include "systems/SweptMove.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Far more than any sane step needs; a runaway sweep stops here.
+    constexpr int kMaxSubSteps = 512;
+    // Contact tolerance and stand-off from walls, in tiles.
+    constexpr float kContactTiles = 1e-4f;
+    // Travel per sub-step while rounding a wall corner, in tiles. Each
+    // sub-step slides along the tangent at its start, so shorter steps trace
+    // the corner closer to the true arc whatever the caller's step size.
+    constexpr float kCornerStepTiles = 0.02f;
+
+    struct Contact {
+        Vector2 normal;
+        bool corner;
+    };
+
+    float Dot(Vector2 a, Vector2 b) {
+        return a.x * b.x + a.y * b.y;
+    }
+
+    // Distance along one axis from `position` to the next tile boundary in
+    // the direction of `motion`. A boundary a rounding error away counts as
+    // already crossed, so the sweep cannot stall on it.
+    float DistanceToBoundary(float position, float motion, float tileSize) {
+        const float cell = std::floor(position / tileSize);
+        const float distance = motion > 0.0f ? (cell + 1.0f) * tileSize - position : position - cell * tileSize;
+        return distance > tileSize * kContactTiles ? distance : distance + tileSize;
+    }
+
+    // Gathers the wall tiles the circle touches, with outward normals.
+    int FindContacts(const WallGrid& walls, Vector2 position, float radius, float tolerance, Contact* contacts) {
+        const float tileSize = walls.tileSize;
+        const float reach = radius + tolerance;
+        const int minTileX = static_cast<int>(std::floor((position.x - reach) / tileSize));
+        const int maxTileX = static_cast<int>(std::floor((position.x + reach) / tileSize));
+        const int minTileY = static_cast<int>(std::floor((position.y - reach) / tileSize));
+        const int maxTileY = static_cast<int>(std::floor((position.y + reach) / tileSize));
+
+        int count = 0;
+        for (int ty = minTileY; ty <= maxTileY; ++ty) {
+            for (int tx = minTileX; tx <= maxTileX; ++tx) {
+                if (!walls.IsWall(tx, ty)) {
+                    continue;
+                }
+
+                const float left = tx * tileSize;
+                const float top = ty * tileSize;
+                const float closestX = std::clamp(position.x, left, left + tileSize);
+                const float closestY = std::clamp(position.y, top, top + tileSize);
+                const float dx = position.x - closestX;
+                const float dy = position.y - closestY;
+                const float distanceSquared = dx * dx + dy * dy;
+                if (distanceSquared > reach * reach) {
+                    continue;
+                }
+
+                Contact contact{};
+                if (distanceSquared > 0.0f) {
+                    const float distance = std::sqrt(distanceSquared);
+                    contact.normal = Vector2{ dx / distance, dy / distance };
+                    contact.corner = dx != 0.0f && dy != 0.0f;
+                } else {
+                    // Centre inside the tile, which sweeps never cause; point
+                    // out through the nearest face so the circle is not
+                    // dragged further in.
+                    const float exits[4] = { position.x - left, left + tileSize - position.x,
+                                             position.y - top, top + tileSize - position.y };
+                    const Vector2 normals[4] = { { -1.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, -1.0f }, { 0.0f, 1.0f } };
+                    contact.normal = normals[std::min_element(exits, exits + 4) - exits];
+                    contact.corner = false;
+                }
+                // At most 3x3 tiles can touch a circle narrower than a tile.
+                if (count < 9) {
+                    contacts[count++] = contact;
+                }
+            }
+        }
+        return count;
+    }
+
+    // Earliest fraction of `motion` at which a circle at `position` touches
+    // the tile box, or 2 if it does not within the motion. Boxes the circle
+    // already touches are left to the contact projection.
+    float TimeOfImpact(Vector2 position, Vector2 motion, float radius, float left, float top, float size) {
+        const float right = left + size;
+        const float bottom = top + size;
+
+        // Ray against the box grown by the radius, one slab per axis.
+        float enter = -INFINITY;
+        float exit = INFINITY;
+        const float lows[2] = { left - radius, top - radius };
+        const float highs[2] = { right + radius, bottom + radius };
+        const float origins[2] = { position.x, position.y };
+        const float directions[2] = { motion.x, motion.y };
+        for (int axis = 0; axis < 2; ++axis) {
+            if (directions[axis] == 0.0f) {
+                if (origins[axis] <= lows[axis] || origins[axis] >= highs[axis]) {
+                    return 2.0f;
+                }
+                continue;
+            }
+            float t0 = (lows[axis] - origins[axis]) / directions[axis];
+            float t1 = (highs[axis] - origins[axis]) / directions[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            enter = std::max(enter, t0);
+            exit = std::min(exit, t1);
+        }
+        if (enter > exit || enter > 1.0f || exit <= 0.0f) {
+            return 2.0f;
+        }
+
+        // Entering through a grown corner square (or starting inside one)
+        // only counts if the circle also reaches the rounded corner itself.
+        const float from = std::max(enter, 0.0f);
+        const float hitX = position.x + motion.x * from;
+        const float hitY = position.y + motion.y * from;
+        const bool outsideX = hitX < left || hitX > right;
+        const bool outsideY = hitY < top || hitY > bottom;
+        if (!(outsideX && outsideY)) {
+            return enter >= 0.0f ? enter : 2.0f;
+        }
+
+        const float cornerX = hitX < left ? left : right;
+        const float cornerY = hitY < top ? top : bottom;
+        const float ox = position.x - cornerX;
+        const float oy = position.y - cornerY;
+        const float a = Dot(motion, motion);
+        const float b = 2.0f * (motion.x * ox + motion.y * oy);
+        const float c = ox * ox + oy * oy - radius * radius;
+        const float discriminant = b * b - 4.0f * a * c;
+        if (c <= 0.0f || discriminant < 0.0f) {
+            return 2.0f;
+        }
+        const float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+        return t >= 0.0f && t <= 1.0f ? t : 2.0f;
+    }
+
+    // Appends the tiles a straight centre segment passes through.
+    void AppendSegmentTiles(const WallGrid& walls, Vector2 from, Vector2 to, std::vector<uint32_t>& tiles) {
+        const float tileSize = walls.tileSize;
+        int x = static_cast<int>(std::floor(from.x / tileSize));
+        int y = static_cast<int>(std::floor(from.y / tileSize));
+        const int endX = static_cast<int>(std::floor(to.x / tileSize));
+        const int endY = static_cast<int>(std::floor(to.y / tileSize));
+        const float dx = to.x - from.x;
+        const float dy = to.y - from.y;
+        const int stepX = dx > 0.0f ? 1 : -1;
+        const int stepY = dy > 0.0f ? 1 : -1;
+        float nextX = dx != 0.0f ? ((stepX > 0 ? x + 1 : x) * tileSize - from.x) / dx : INFINITY;
+        float nextY = dy != 0.0f ? ((stepY > 0 ? y + 1 : y) * tileSize - from.y) / dy : INFINITY;
+        const float deltaX = dx != 0.0f ? tileSize / std::fabs(dx) : INFINITY;
+        const float deltaY = dy != 0.0f ? tileSize / std::fabs(dy) : INFINITY;
+
+        auto append = [&](int tx, int ty) {
+            if (static_cast<unsigned>(tx) >= static_cast<unsigned>(walls.tilesWide) ||
+                static_cast<unsigned>(ty) >= static_cast<unsigned>(walls.tilesHigh)) {
+                return;
+            }
+            const uint32_t tile = static_cast<uint32_t>(ty) * static_cast<uint32_t>(walls.tilesWide) + static_cast<uint32_t>(tx);
+            if (tiles.empty() || tiles.back() != tile) {
+                tiles.push_back(tile);
+            }
+        };
+
+        append(x, y);
+        const int crossings = std::abs(endX - x) + std::abs(endY - y);
+        for (int i = 0; i < crossings; ++i) {
+            if (nextX < nextY) {
+                x += stepX;
+                nextX += deltaX;
+            } else {
+                y += stepY;
+                nextY += deltaY;
+            }
+            append(x, y);
+        }
+    }
+}
+
+bool IsSweepClear(const WallGrid& walls, float minX, float minY, float maxX, float maxY) {
+    if (minX < 0.0f || minY < 0.0f) {
+        return false;
+    }
+
+    const int tileX0 = static_cast<int>(minX / walls.tileSize);
+    const int tileY0 = static_cast<int>(minY / walls.tileSize);
+    const int tileX1 = static_cast<int>(maxX / walls.tileSize);
+    const int tileY1 = static_cast<int>(maxY / walls.tileSize);
+    if (tileX1 - tileX0 > 1 || tileY1 - tileY0 > 1) {
+        return false;
+    }
+
+    return !walls.IsWall(tileX0, tileY0) && !walls.IsWall(tileX1, tileY0)
+        && !walls.IsWall(tileX0, tileY1) && !walls.IsWall(tileX1, tileY1);
+}
+
+Vector2 SweepCircle(const WallGrid& walls, Vector2 start, Vector2 delta, float radius,
+                    std::vector<uint32_t>* crossedTiles) {
+    if (crossedTiles != nullptr) {
+        crossedTiles->clear();
+    }
+
+    const float endX = start.x + delta.x;
+    const float endY = start.y + delta.y;
+    if (IsSweepClear(walls, std::min(start.x, endX) - radius, std::min(start.y, endY) - radius,
+                     std::max(start.x, endX) + radius, std::max(start.y, endY) + radius)) {
+        const Vector2 end{ endX, endY };
+        if (crossedTiles != nullptr) {
+            AppendSegmentTiles(walls, start, end, *crossedTiles);
+        }
+        return end;
+    }
+
+    const float tileSize = walls.tileSize;
+    const float tolerance = tileSize * kContactTiles;
+    const float maxStep = std::max(radius, tileSize * 0.05f);
+    Contact contacts[9];
+
+    Vector2 position = start;
+    float remainingTime = 1.0f;
+    for (int step = 0; step < kMaxSubSteps && remainingTime > 0.0f; ++step) {
+        // Velocity for this sub-step: the full motion minus whatever points
+        // into a wall the circle touches. Two passes settle inside corners.
+        const int contactCount = FindContacts(walls, position, radius, tolerance * 2.0f, contacts);
+        Vector2 velocity = delta;
+        bool rounding = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = 0; i < contactCount; ++i) {
+                const float into = Dot(velocity, contacts[i].normal);
+                if (into < 0.0f) {
+                    velocity.x -= contacts[i].normal.x * into;
+                    velocity.y -= contacts[i].normal.y * into;
+                }
+            }
+        }
+        for (int i = 0; i < contactCount; ++i) {
+            if (Dot(velocity, contacts[i].normal) < -1e-6f) {
+                velocity = Vector2{ 0.0f, 0.0f };
+            }
+            rounding = rounding || contacts[i].corner;
+        }
+
+        const float speed = std::sqrt(Dot(velocity, velocity));
+        if (speed * remainingTime <= tolerance) {
+            break;
+        }
+
+        // Advance no further than the next tile boundary the centre crosses
+        // on either axis, one radius, or a short arc step around a corner.
+        const float stepLength = rounding ? tileSize * kCornerStepTiles : maxStep;
+        float time = std::min(remainingTime, stepLength / speed);
+        if (velocity.x != 0.0f) {
+            time = std::min(time, DistanceToBoundary(position.x, velocity.x, tileSize) / std::fabs(velocity.x));
+        }
+        if (velocity.y != 0.0f) {
+            time = std::min(time, DistanceToBoundary(position.y, velocity.y, tileSize) / std::fabs(velocity.y));
+        }
+
+        // First wall tile the circle would touch on the way.
+        const Vector2 motion{ velocity.x * time, velocity.y * time };
+        const float reach = radius + tolerance;
+        const int minTileX = static_cast<int>(std::floor((std::min(position.x, position.x + motion.x) - reach) / tileSize));
+        const int maxTileX = static_cast<int>(std::floor((std::max(position.x, position.x + motion.x) + reach) / tileSize));
+        const int minTileY = static_cast<int>(std::floor((std::min(position.y, position.y + motion.y) - reach) / tileSize));
+        const int maxTileY = static_cast<int>(std::floor((std::max(position.y, position.y + motion.y) + reach) / tileSize));
+        float impact = 1.0f;
+        for (int ty = minTileY; ty <= maxTileY; ++ty) {
+            for (int tx = minTileX; tx <= maxTileX; ++tx) {
+                if (walls.IsWall(tx, ty)) {
+                    impact = std::min(impact, TimeOfImpact(position, motion, radius, tx * tileSize, ty * tileSize, tileSize));
+                }
+            }
+        }
+        if (impact < 1.0f) {
+            // Stop just short so rounding cannot leave the circle overlapping.
+            impact = std::max(0.0f, impact - tolerance / (speed * time));
+        }
+
+        const Vector2 next{ position.x + motion.x * impact, position.y + motion.y * impact };
+        if (crossedTiles != nullptr) {
+            AppendSegmentTiles(walls, position, next, *crossedTiles);
+        }
+        position = next;
+        remainingTime -= time * impact;
+        if (impact < 1.0f && time * impact <= 0.0f && contactCount == 0) {
+            // Touching something the contact search missed; give up rather than spin.
+            break;
+        }
+    }
+
+    if (crossedTiles != nullptr && crossedTiles->empty()) {
+        AppendSegmentTiles(walls, position, position, *crossedTiles);
+    }
+    return position;
+}
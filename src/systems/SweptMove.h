@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+
+// Read-only view of a wall bit plane laid out like TileMap::GetWallWords.
+// Tiles off the map read as walls.
+struct WallGrid {
+    const uint64_t* words = nullptr;
+    int wordsPerRow = 0;
+    int tilesWide = 0;
+    int tilesHigh = 0;
+    float tileSize = 1.0f;
+
+    bool IsWall(int x, int y) const {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(tilesWide) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(tilesHigh)) {
+            return true;
+        }
+        return (words[static_cast<size_t>(y) * wordsPerRow + (static_cast<unsigned>(x) >> 6)] >> (x & 63)) & 1u;
+    }
+};
+
+// True when the box [minX, maxX] x [minY, maxY] lies within a 2x2 block of
+// tiles none of which is a wall. A circle whose swept bounds pass this test
+// moves without touching anything. The vectorised ghost kernel makes the
+// same test lane by lane, so it must stay exactly this.
+bool IsSweepClear(const WallGrid& walls, float minX, float minY, float maxX, float maxY);
+
+// Moves a circle by `delta` as if in continuous motion: it travels until it
+// touches a wall, then keeps only the part of the motion that does not point
+// into any wall it touches, so it slides along faces and rounds corners.
+// The centre's path is walked boundary by boundary through the tile grid (a
+// grid DDA) with an exact time of impact against each nearby wall tile, so a
+// long move ends where a series of short ones would instead of tunnelling.
+//
+// When IsSweepClear holds for the swept bounds the result is exactly
+// start + delta. If crossedTiles is given, it receives every tile the centre
+// passes through, in order, as y * tilesWide + x, ending with the final tile.
+Vector2 SweepCircle(const WallGrid& walls, Vector2 start, Vector2 delta, float radius,
+                    std::vector<uint32_t>* crossedTiles = nullptr);
@@ -0,0 +1,562 @@
+#include "entities/Ghost.h"
+#include "entities/Player.h"
+#include "game/TileMap.h"
+#include "sim/BatchEnv.h"
+#include "sim/MazeGenerator.h"
+#include "sim/Simulation.h"
+#include "sim/ThreadPool.h"
+#include "systems/CaptureGrid.h"
+#include "systems/GhostSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for the simulation hot paths. Every case runs repeatedly
+// until it has used a minimum amount of wall time, several times over, and
+// reports the fastest repetition as JSON so two builds can be diffed.
+
+class SimulationBenchAccess {
+public:
+    static void TryMovePlayer(Simulation& simulation, Vector2 direction, float deltaSeconds) {
+        simulation.TryMovePlayer(simulation.playerA_, direction, deltaSeconds);
+    }
+    static void HandlePelletPickup(Simulation& simulation, Vector2 position) {
+        simulation.playerA_.position = position;
+        simulation.HandlePelletPickup(simulation.playerA_);
+    }
+    static void FindFallbackGhostSpawns(Simulation& simulation, int needed, std::vector<Vector2>& out) {
+        simulation.FindFallbackGhostSpawns(needed, {}, out);
+    }
+    static TileMap& GetMap(Simulation& simulation) { return simulation.map_; }
+};
+
+namespace {
+    constexpr int kTilePixelSize = 24;
+
+    struct Options {
+        std::string filter;
+        std::string outputPath;
+        double minSecondsPerRepetition = 0.05;
+        int repetitions = 5;
+    };
+
+    struct Result {
+        std::string name;
+        long long iterations = 0;
+        double nsPerOp = 0.0;
+        double itemsPerOp = 0.0;
+    };
+
+    struct Rng {
+        uint64_t state;
+        uint32_t Next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+        }
+        float NextFloat() {
+            return static_cast<float>(Next() >> 8) / 16777216.0f;
+        }
+    };
+
+    // Keeps the optimiser from discarding work whose result is otherwise unused.
+    volatile uint64_t g_sink = 0;
+
+    void Consume(uint64_t value) {
+        g_sink = g_sink + value;
+    }
+
+    class Bench {
+    public:
+        explicit Bench(const Options& options) : options_(options) {}
+
+        // Whether --filter lets `name` run; checked before building whatever a
+        // case needs.
+        bool Wants(const std::string& name) const {
+            return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+        }
+
+        // `fn` performs one operation; `items` is how many units of work one
+        // operation covers (ghosts, players, tiles) for throughput figures.
+        template <typename Fn>
+        void Run(const std::string& name, double items, Fn&& fn) {
+            if (!Wants(name)) {
+                return;
+            }
+
+            // Grow the batch until one batch takes long enough to time reliably.
+            long long batch = 1;
+            double batchSeconds = TimeBatch(batch, fn);
+            while (batchSeconds < options_.minSecondsPerRepetition && batch < (1ll << 40)) {
+                const double scale = batchSeconds > 0.0 ? options_.minSecondsPerRepetition / batchSeconds : 100.0;
+                batch = std::max(batch + 1, static_cast<long long>(batch * std::min(scale * 1.2, 100.0)));
+                batchSeconds = TimeBatch(batch, fn);
+            }
+
+            double best = batchSeconds;
+            for (int repetition = 1; repetition < options_.repetitions; ++repetition) {
+                best = std::min(best, TimeBatch(batch, fn));
+            }
+
+            Result result;
+            result.name = name;
+            result.iterations = batch;
+            result.nsPerOp = best * 1e9 / batch;
+            result.itemsPerOp = items;
+            results_.push_back(result);
+            std::fprintf(stderr, "%-48s %14.1f ns/op\n", name.c_str(), result.nsPerOp);
+        }
+
+        bool WriteJson() const {
+            std::FILE* file = options_.outputPath.empty() ? stdout : std::fopen(options_.outputPath.c_str(), "w");
+            if (file == nullptr) {
+                return false;
+            }
+
+            std::fprintf(file, "{\n  \"context\": {\"ghost_kernel\": \"%s\", \"repetitions\": %d},\n",
+                         GhostKernelName(ResolveGhostKernel(GhostKernel::Auto)), options_.repetitions);
+            std::fprintf(file, "  \"benchmarks\": [\n");
+            for (size_t i = 0; i < results_.size(); ++i) {
+                const Result& result = results_[i];
+                const double itemsPerSecond = result.nsPerOp > 0.0 ? result.itemsPerOp * 1e9 / result.nsPerOp : 0.0;
+                std::fprintf(file,
+                             "    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, "
+                             "\"items_per_op\": %.0f, \"items_per_second\": %.1f}%s\n",
+                             result.name.c_str(), result.iterations, result.nsPerOp,
+                             result.itemsPerOp, itemsPerSecond, i + 1 < results_.size() ? "," : "");
+            }
+            std::fprintf(file, "  ]\n}\n");
+
+            return file == stdout || std::fclose(file) == 0;
+        }
+
+    private:
+        template <typename Fn>
+        static double TimeBatch(long long batch, Fn& fn) {
+            const auto start = std::chrono::steady_clock::now();
+            for (long long i = 0; i < batch; ++i) {
+                fn();
+            }
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double>(end - start).count();
+        }
+
+        Options options_;
+        std::vector<Result> results_{};
+    };
+
+    // Map files for the cases that run, written on first use into a
+    // directory of this run's own and removed with it, so a stale or foreign
+    // file is never read back.
+    class BenchMaps {
+    public:
+        BenchMaps() = default;
+        ~BenchMaps() {
+            if (!directory_.empty()) {
+                std::error_code error;
+                std::filesystem::remove_all(directory_, error);
+            }
+        }
+
+        BenchMaps(const BenchMaps&) = delete;
+        BenchMaps& operator=(const BenchMaps&) = delete;
+
+        // An open rectangle of pellets inside a one-tile wall border, with
+        // both player spawns and no ghost spawns.
+        std::string GetOpenMap(int width, int height) {
+            const std::filesystem::path path =
+                GetDirectory() / ("open_" + std::to_string(width) + "x" + std::to_string(height) + ".txt");
+            if (std::filesystem::exists(path)) {
+                return path.string();
+            }
+
+            std::ofstream file(path);
+            std::string row;
+            for (int y = 0; y < height; ++y) {
+                row.assign(width, '.');
+                if (y == 0 || y == height - 1) {
+                    row.assign(width, '#');
+                }
+                row.front() = '#';
+                row.back() = '#';
+                if (y == 1) {
+                    row[1] = 'P';
+                    row[width - 2] = 'Q';
+                }
+                file << row << '\n';
+            }
+            return path.string();
+        }
+
+        // A seeded maze with loops and a few ghost spawns, from the default
+        // generator settings, so every build gets the same one.
+        std::string GetMaze(int width, int height) {
+            const std::filesystem::path path =
+                GetDirectory() / ("maze_" + std::to_string(width) + "x" + std::to_string(height) + ".txt");
+            if (std::filesystem::exists(path)) {
+                return path.string();
+            }
+
+            MazeSettings settings;
+            settings.width = width;
+            settings.height = height;
+            ThreadPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+            Maze maze;
+            GenerateMaze(settings, pool, maze);
+            maze.SaveText(path.string());
+            return path.string();
+        }
+
+    private:
+        const std::filesystem::path& GetDirectory() {
+            if (directory_.empty()) {
+                std::random_device random;
+                char name[32];
+                do {
+                    std::snprintf(name, sizeof(name), "pacmen_bench_%08x%08x", random(), random());
+                    directory_ = std::filesystem::temp_directory_path() / name;
+                } while (!std::filesystem::create_directory(directory_));
+            }
+            return directory_;
+        }
+
+        std::filesystem::path directory_{};
+    };
+
+    void BenchTileMap(Bench& bench, BenchMaps& maps) {
+        struct MapCase { const char* label; int width; int height; bool maze; };
+        const MapCase cases[] = {
+            { "40x16", 40, 16, false }, { "4096x4096", 4096, 4096, false }, { "maze4095x4095", 4095, 4095, true }
+        };
+
+        for (const MapCase& c : cases) {
+            const std::string loadName = std::string("TileMap::LoadFromFile/") + c.label;
+            const std::string compiledName = loadName + "/pmap";
+            const std::string resetName = std::string("TileMap::ResetTiles/") + c.label;
+            if (!bench.Wants(loadName) && !bench.Wants(compiledName) && !bench.Wants(resetName)) {
+                continue;
+            }
+
+            const std::string path = c.maze ? maps.GetMaze(c.width, c.height) : maps.GetOpenMap(c.width, c.height);
+            const double tiles = static_cast<double>(c.width) * c.height;
+
+            TileMap map;
+            map.LoadFromFile(path);
+            bench.Run(loadName, tiles, [&] {
+                Consume(map.LoadFromFile(path) ? 1 : 0);
+            });
+
+            if (bench.Wants(compiledName)) {
+                const std::string compiledPath = path.substr(0, path.size() - 4) + ".pmap";
+                map.SaveCompiled(compiledPath);
+                TileMap compiled;
+                bench.Run(compiledName, tiles, [&] {
+                    Consume(compiled.LoadFromFile(compiledPath) ? 1 : 0);
+                });
+            }
+            bench.Run(resetName, tiles, [&] {
+                map.ResetTiles();
+                Consume(static_cast<uint64_t>(map.GetRemainingPellets()));
+            });
+        }
+    }
+
+    void BenchMazeGenerator(Bench& bench) {
+        const int threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        const std::string name = "GenerateMaze/1023x1023/threads:" + std::to_string(threadCount);
+        if (!bench.Wants(name)) {
+            return;
+        }
+
+        ThreadPool pool(threadCount);
+        MazeSettings settings;
+        settings.width = 1023;
+        settings.height = 1023;
+        Maze maze;
+        bench.Run(name, static_cast<double>(settings.width) * settings.height, [&] {
+            GenerateMaze(settings, pool, maze);
+            Consume(maze.tiles.size());
+        });
+    }
+
+    void BenchGhostSystem(Bench& bench, BenchMaps& maps) {
+        TileMap map;
+
+        const int counts[] = { 6, 1000, 100000 };
+        const GhostKernel kernels[] = { GhostKernel::Scalar, GhostKernel::Avx2 };
+        const GhostSchedule schedules[] = { GhostSchedule::Full, GhostSchedule::Budgeted };
+
+        for (int count : counts) {
+            for (GhostKernel kernel : kernels) {
+                for (GhostSchedule schedule : schedules) {
+                    const std::string name = "GhostSystem::Update/" + std::to_string(count) + "/" + GhostKernelName(kernel)
+                        + (schedule == GhostSchedule::Budgeted ? "/budgeted" : "");
+                    GhostSystem system;
+                    system.SetKernel(kernel);
+                    system.SetSchedule(schedule);
+                    if (system.GetKernel() != kernel || !bench.Wants(name)) {
+                        continue;
+                    }
+                    if (map.GetWidth() == 0) {
+                        map.LoadFromFile(maps.GetOpenMap(256, 256));
+                    }
+
+                    Rng rng{ 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(count) };
+                    GhostArray ghosts;
+                    ghosts.Reserve(count);
+                    for (int i = 0; i < count; ++i) {
+                        Ghost ghost{};
+                        ghost.radius = kTilePixelSize * 0.33f;
+                        ghost.speed = kTilePixelSize * 1.5f;
+                        const int tileX = 1 + static_cast<int>(rng.Next() % (map.GetWidth() - 2));
+                        const int tileY = 1 + static_cast<int>(rng.Next() % (map.GetHeight() - 2));
+                        ghost.position = { (tileX + 0.5f) * kTilePixelSize, (tileY + 0.5f) * kTilePixelSize };
+                        ghosts.Add(ghost);
+                    }
+
+                    Player playerA{};
+                    playerA.radius = kTilePixelSize * 0.35f;
+                    playerA.position = { 1.5f * kTilePixelSize, 1.5f * kTilePixelSize };
+                    Player playerB = playerA;
+                    playerB.position = { (map.GetWidth() - 1.5f) * kTilePixelSize, (map.GetHeight() - 1.5f) * kTilePixelSize };
+
+                    bench.Run(name, count, [&] {
+                        system.Update(ghosts, map, playerA, playerB, 1.0f / 60.0f, kTilePixelSize);
+                    });
+                }
+            }
+        }
+    }
+
+    void BenchCaptureChecks(Bench& bench) {
+        const int counts[] = { 10, 1000, 100000 };
+        for (int count : counts) {
+            // About one ghost per four tiles, like a busy stress map.
+            int side = 4;
+            while (side * side < count * 4) {
+                side *= 2;
+            }
+            const float extent = static_cast<float>(side * kTilePixelSize);
+
+            Rng rng{ 0x2545F4914F6CDD1Dull + static_cast<uint64_t>(count) };
+            GhostArray ghosts;
+            ghosts.Reserve(count);
+            for (int i = 0; i < count; ++i) {
+                Ghost ghost{};
+                ghost.radius = kTilePixelSize * 0.33f;
+                ghost.position = { rng.NextFloat() * extent, rng.NextFloat() * extent };
+                ghosts.Add(ghost);
+            }
+
+            const int playerCounts[] = { 2, 64 };
+            for (int players : playerCounts) {
+                std::vector<Vector2> points(players);
+                for (Vector2& point : points) {
+                    point = { rng.NextFloat() * extent, rng.NextFloat() * extent };
+                }
+                const float radius = kTilePixelSize * 0.35f;
+                const std::string suffix = std::to_string(count) + "/players:" + std::to_string(players);
+
+                bench.Run("CaptureCheck::BruteForce/" + suffix, count, [&] {
+                    for (const Vector2& point : points) {
+                        for (size_t i = 0; i < ghosts.Size(); ++i) {
+                            const float radiusSum = ghosts.radius[i] + radius;
+                            const float dx = ghosts.positionX[i] - point.x;
+                            const float dy = ghosts.positionY[i] - point.y;
+                            if (dx * dx + dy * dy <= radiusSum * radiusSum) {
+                                Consume(1);
+                                break;
+                            }
+                        }
+                    }
+                });
+
+                CaptureGrid grid;
+                bench.Run("CaptureCheck::Grid/" + suffix, count, [&] {
+                    grid.Build(ghosts, static_cast<float>(kTilePixelSize));
+                    for (const Vector2& point : points) {
+                        Consume(grid.AnyOverlap(ghosts, point, radius) ? 1 : 0);
+                    }
+                });
+            }
+        }
+    }
+
+    void BenchPlayer(Bench& bench, BenchMaps& maps) {
+        const std::string moveName = "Simulation::TryMovePlayer";
+        const std::string pickupName = "Simulation::HandlePelletPickup";
+        struct SpawnCase { int count; int separation; };
+        const SpawnCase spawnCases[] = { { 6, 1 }, { 1000, 1 }, { 10000, 3 } };
+        auto spawnName = [](const SpawnCase& c) {
+            return "Simulation::FindFallbackGhostSpawns/512x512/" + std::to_string(c.count)
+                + "/sep:" + std::to_string(c.separation);
+        };
+        bool wanted = bench.Wants(moveName) || bench.Wants(pickupName);
+        for (const SpawnCase& c : spawnCases) {
+            wanted = wanted || bench.Wants(spawnName(c));
+        }
+        if (!wanted) {
+            return;
+        }
+
+        Simulation simulation(kTilePixelSize);
+        simulation.LoadMap(maps.GetOpenMap(512, 512));
+        const float deltaSeconds = 1.0f / 60.0f;
+
+        // Sweeps right and left along the top corridor, bouncing off the
+        // border walls, so both the open and the blocked branch are taken.
+        Vector2 direction{ 1.0f, 0.0f };
+        bench.Run(moveName, 1, [&] {
+            const float before = simulation.GetPlayerA().position.x;
+            SimulationBenchAccess::TryMovePlayer(simulation, direction, deltaSeconds);
+            if (simulation.GetPlayerA().position.x == before) {
+                direction.x = -direction.x;
+            }
+        });
+
+        TileMap& map = SimulationBenchAccess::GetMap(simulation);
+        const int width = map.GetWidth();
+        const int height = map.GetHeight();
+        long long tile = 0;
+        bench.Run(pickupName, 1, [&] {
+            const int x = static_cast<int>(tile % width);
+            const int y = static_cast<int>(tile / width);
+            SimulationBenchAccess::HandlePelletPickup(
+                simulation, Vector2{ (x + 0.5f) * kTilePixelSize, (y + 0.5f) * kTilePixelSize });
+            if (++tile == static_cast<long long>(width) * height) {
+                tile = 0;
+                map.ResetTiles();
+            }
+        });
+
+        std::vector<Vector2> spawns;
+        for (const SpawnCase& c : spawnCases) {
+            SpawnPlacementRules rules{};
+            rules.minDistanceFromPlayers = 8;
+            rules.minSeparation = c.separation;
+            simulation.SetGhostSpawnRules(rules);
+            bench.Run(spawnName(c), c.count, [&] {
+                SimulationBenchAccess::FindFallbackGhostSpawns(simulation, c.count, spawns);
+                Consume(spawns.size());
+            });
+        }
+    }
+
+    void BenchBatchEnv(Bench& bench, BenchMaps& maps) {
+        const int sessionCount = 256;
+        const std::string name = "BatchEnv::Step/64x64/" + std::to_string(sessionCount);
+        if (!bench.Wants(name)) {
+            return;
+        }
+
+        BatchEnv env;
+        BatchEnv::Config config;
+        config.mapPath = maps.GetOpenMap(64, 64);
+        config.sessionCount = sessionCount;
+        if (!env.Initialize(config)) {
+            return;
+        }
+
+        std::vector<uint64_t> observations(env.GetLayout().stride * sessionCount / sizeof(uint64_t));
+        std::vector<uint8_t> actions(static_cast<size_t>(sessionCount) * 2);
+        Rng rng{ 0x5eedu };
+        env.Reset(observations.data());
+
+        bench.Run(name, sessionCount, [&] {
+            for (uint8_t& action : actions) {
+                action = static_cast<uint8_t>(rng.Next() % 5);
+            }
+            env.Step(actions.data(), observations.data());
+        });
+    }
+
+    void BenchRollback(Bench& bench, BenchMaps& maps) {
+        const int ghostCount = 2000;
+        const std::string suffix = "/512x512/" + std::to_string(ghostCount);
+        const std::string saveName = "Simulation::SaveState" + suffix;
+        const std::string loadName = "Simulation::LoadState+SaveState" + suffix;
+        if (!bench.Wants(saveName) && !bench.Wants(loadName)) {
+            return;
+        }
+
+        Simulation simulation(kTilePixelSize);
+        simulation.SetGhostCount(ghostCount);
+        simulation.LoadMap(maps.GetOpenMap(512, 512));
+        simulation.StartMatch();
+
+        // A rollback ring's worth of snapshots, a few ticks apart, so saves
+        // replay a short stretch of the pellet log as they do in play.
+        std::vector<SimulationState> ring(10);
+        InputFrame input{};
+        input.player1Direction = Vector2{ 1.0f, 0.0f };
+        input.player2Direction = Vector2{ 0.0f, 1.0f };
+        for (SimulationState& state : ring) {
+            simulation.Update(input, 1.0f / 60.0f);
+            simulation.SaveState(state);
+        }
+
+        size_t slot = 0;
+        bench.Run(saveName, 1, [&] {
+            simulation.SaveState(ring[slot]);
+            slot = (slot + 1) % ring.size();
+        });
+        // Every load moves the pellet generation on, so this also covers the
+        // full plane copy the next save of each slot makes.
+        bench.Run(loadName, 1, [&] {
+            simulation.LoadState(ring[slot]);
+            simulation.SaveState(ring[(slot + 1) % ring.size()]);
+            slot = (slot + 1) % ring.size();
+        });
+    }
+
+    void PrintUsage(const char* program) {
+        std::printf("usage: %s [--filter substring] [--out path.json] [--min-time seconds] [--repetitions N]\n", program);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            options.minSecondsPerRepetition = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Bench bench(options);
+    BenchMaps maps;
+    BenchTileMap(bench, maps);
+    BenchMazeGenerator(bench);
+    BenchGhostSystem(bench, maps);
+    BenchCaptureChecks(bench);
+    BenchPlayer(bench, maps);
+    BenchBatchEnv(bench, maps);
+    BenchRollback(bench, maps);
+
+    if (!bench.WriteJson()) {
+        std::fprintf(stderr, "Could not write %s\n", options.outputPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,872 @@
+#include "sim/BotInputSource.h"
+#include "sim/InputLog.h"
+#include "sim/Metrics.h"
+#include "sim/MetricsExporter.h"
+#include "sim/NetTransport.h"
+#include "sim/Profiler.h"
+#include "sim/RollbackSession.h"
+#include "sim/SessionRunner.h"
+#include "sim/Simulation.h"
+#include "sim/StateSync.h"
+#include "systems/HierarchicalPathfinder.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::printf("usage: %s [--map path] [--ticks N] [--dt seconds] [--seed N]"
+                    " [--ghosts N] [--kernel auto|scalar|avx2] [--capture brute|grid] [--trace path]"
+                    " [--ai full|budgeted] [--ai-budget N] [--targets chase|mixed]"
+                    " [--record path] [--replay path]"
+                    " [--netplay loopback] [--net-latency ms] [--net-jitter ms] [--net-loss rate] [--net-delay ticks]"
+                    " [--spectators N] [--spectate-hz N]"
+                    " [--metrics-port N] [--metrics-log path] [--metrics-interval seconds]"
+                    " [--ghost-separation N] [--ghost-player-distance N] [--compare-kernels]"
+                    " [--check-paths edits]\n", program);
+    }
+
+    bool ParseKernel(const char* name, GhostKernel& kernel) {
+        if (std::strcmp(name, "auto") == 0) {
+            kernel = GhostKernel::Auto;
+        } else if (std::strcmp(name, "scalar") == 0) {
+            kernel = GhostKernel::Scalar;
+        } else if (std::strcmp(name, "avx2") == 0) {
+            kernel = GhostKernel::Avx2;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void PrintSimulationSummary(const Simulation& simulation) {
+        std::printf("p1 score=%d lives=%d | p2 score=%d lives=%d | pellets left=%d\n",
+                    simulation.GetPlayerA().score, simulation.GetPlayerA().lives,
+                    simulation.GetPlayerB().score, simulation.GetPlayerB().lives,
+                    simulation.GetMap().GetRemainingPellets());
+    }
+
+    // Re-runs a recorded session as fast as possible and checks that it ends
+    // in the recorded state. `name` only labels the output.
+    int RunReplay(InputLog& log, const std::string& name, GhostKernel kernel, CaptureCheck captureCheck) {
+        const InputLogHeader& header = log.GetHeader();
+        Simulation simulation(header.tilePixelSize);
+        simulation.SetGhostCount(header.ghostCount);
+        simulation.SetGhostKernel(kernel);
+        simulation.SetCaptureCheck(captureCheck);
+        simulation.SetGhostSchedule(header.ghostSchedule);
+        simulation.SetGhostScheduleRules(header.ghostScheduleRules);
+        simulation.SetGhostTargeting(header.ghostTargeting);
+        simulation.SetGhostSpawnRules(header.ghostSpawnRules);
+        if (!simulation.LoadMap(header.mapPath)) {
+            std::fprintf(stderr, "Failed to load map: %s\n", header.mapPath.c_str());
+            return 1;
+        }
+
+        InputFrame frame{};
+        float deltaSeconds = 0.0f;
+        double simulatedSeconds = 0.0;
+
+        const auto start = std::chrono::steady_clock::now();
+        while (log.Next(frame, deltaSeconds)) {
+            simulation.Update(frame, deltaSeconds);
+            simulatedSeconds += deltaSeconds;
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const uint64_t ticks = log.GetTickCount();
+        const uint64_t hash = simulation.ComputeStateHash();
+        const bool matches = hash == log.GetFinalStateHash();
+
+        std::printf("replay=%s ticks=%llu seconds=%.3f ticks_per_sec=%.0f realtime_x=%.1f\n",
+                    name.c_str(), static_cast<unsigned long long>(ticks), seconds,
+                    seconds > 0.0 ? ticks / seconds : 0.0,
+                    seconds > 0.0 ? simulatedSeconds / seconds : 0.0);
+        std::printf("state_hash=%016llx expected=%016llx %s\n",
+                    static_cast<unsigned long long>(hash),
+                    static_cast<unsigned long long>(log.GetFinalStateHash()),
+                    matches ? "OK" : "MISMATCH");
+        PrintSimulationSummary(simulation);
+        return matches ? 0 : 2;
+    }
+
+    int RunReplay(const std::string& path, GhostKernel kernel, CaptureCheck captureCheck) {
+        InputLog log;
+        if (!log.Load(path)) {
+            std::fprintf(stderr, "Failed to read replay: %s\n", path.c_str());
+            return 1;
+        }
+        return RunReplay(log, path, kernel, captureCheck);
+    }
+
+    struct KernelComparison {
+        std::string mapPath;
+        long long ticks = 0;
+        float deltaSeconds = 0.0f;
+        uint64_t seed = 0;
+        int ghostCount = 0;
+        CaptureCheck captureCheck = CaptureCheck::BruteForce;
+        GhostSchedule schedule = GhostSchedule::Full;
+        GhostScheduleRules scheduleRules{};
+        GhostTargeting targeting = GhostTargeting::ChaseOnly;
+        SpawnPlacementRules spawnRules{};
+    };
+
+    // Plays the same bot run once per ghost kernel and fails unless every
+    // kernel ends in the same state.
+    int RunKernelComparison(const KernelComparison& run) {
+        if (ResolveGhostKernel(GhostKernel::Avx2) != GhostKernel::Avx2) {
+            std::printf("kernels=scalar only; this CPU or build has no AVX2 kernel to compare\n");
+            return 0;
+        }
+
+        const GhostKernel kernels[] = { GhostKernel::Scalar, GhostKernel::Avx2 };
+        uint64_t hashes[2] = {};
+        for (int k = 0; k < 2; ++k) {
+            Simulation simulation;
+            simulation.SetGhostCount(run.ghostCount);
+            simulation.SetGhostKernel(kernels[k]);
+            simulation.SetCaptureCheck(run.captureCheck);
+            simulation.SetGhostSpawnRules(run.spawnRules);
+            simulation.SetGhostSchedule(run.schedule);
+            simulation.SetGhostScheduleRules(run.scheduleRules);
+            simulation.SetGhostTargeting(run.targeting);
+            if (!simulation.LoadMap(run.mapPath)) {
+                std::fprintf(stderr, "Failed to load map: %s\n", run.mapPath.c_str());
+                return 1;
+            }
+
+            BotInputSource bots(run.seed);
+            const auto start = std::chrono::steady_clock::now();
+            for (long long i = 0; i < run.ticks; ++i) {
+                InputFrame frame = bots.Poll();
+                KeepMatchRunning(simulation, frame);
+                simulation.Update(frame, run.deltaSeconds);
+            }
+            const double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            hashes[k] = simulation.ComputeStateHash();
+            std::printf("kernel=%s seconds=%.3f checksum=%016llx\n", GhostKernelName(kernels[k]), seconds,
+                        static_cast<unsigned long long>(hashes[k]));
+        }
+
+        const bool matches = hashes[0] == hashes[1];
+        std::printf("kernels %s\n", matches ? "OK" : "MISMATCH");
+        return matches ? 0 : 2;
+    }
+
+    // Breadth-first steps from every tile to `target` over `walls`, -1 where
+    // it cannot be reached.
+    void WalkDistances(const std::vector<uint64_t>& walls, int wordsPerRow, int width, int height, int target,
+                       std::vector<int32_t>& distance, std::vector<int32_t>& queue) {
+        auto isWall = [&](int x, int y) {
+            return x < 0 || y < 0 || x >= width || y >= height
+                || ((walls[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1u) != 0;
+        };
+        distance.assign(static_cast<size_t>(width) * height, -1);
+        queue.resize(distance.size());
+        size_t head = 0;
+        size_t tail = 0;
+        distance[target] = 0;
+        queue[tail++] = target;
+        const int steps[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+        while (head < tail) {
+            const int tile = queue[head++];
+            const int x = tile % width;
+            const int y = tile / width;
+            for (const auto& step : steps) {
+                const int nx = x + step[0];
+                const int ny = y + step[1];
+                if (!isWall(nx, ny) && distance[ny * width + nx] < 0) {
+                    distance[ny * width + nx] = distance[tile] + 1;
+                    queue[tail++] = ny * width + nx;
+                }
+            }
+        }
+    }
+
+    // Walks the hierarchical pathfinder between fixed pairs of tiles, then
+    // repeatedly walls off or opens up a patch of the map in place, tells the
+    // pathfinder through InvalidateRegion and walks the pairs again. Every
+    // walk must stay on open tiles and arrive at most a tenth plus two
+    // clusters' width longer than the shortest path, and a target cut off
+    // must be refused from the first step.
+    int RunPathCheck(const std::string& mapPath, int edits, uint64_t seed) {
+        TileMap map;
+        if (!map.LoadFromFile(mapPath)) {
+            std::fprintf(stderr, "Failed to load map: %s\n", mapPath.c_str());
+            return 1;
+        }
+        const int width = map.GetWidth();
+        const int height = map.GetHeight();
+        const int wordsPerRow = map.GetWordsPerRow();
+        std::vector<uint64_t> walls(map.GetWallWords(), map.GetWallWords() + static_cast<size_t>(wordsPerRow) * height);
+        auto isWall = [&](int x, int y) {
+            return ((walls[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1u) != 0;
+        };
+        auto setWall = [&](int x, int y, bool wall) {
+            uint64_t& word = walls[static_cast<size_t>(y) * wordsPerRow + (x >> 6)];
+            const uint64_t bit = uint64_t{ 1 } << (x & 63);
+            word = wall ? word | bit : word & ~bit;
+        };
+
+        // xorshift64*, as the bots use.
+        uint64_t state = seed * 0x9E3779B97F4A7C15ull | 1;
+        auto next = [&state](int bound) {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<int>(((state * 0x2545F4914F6CDD1Dull) >> 33) % static_cast<uint64_t>(bound));
+        };
+
+        constexpr int kPairs = 64;
+        std::vector<std::pair<int, int>> pairs;
+        for (int attempt = 0; attempt < kPairs * 1000 && static_cast<int>(pairs.size()) < kPairs; ++attempt) {
+            const int from = next(width * height);
+            const int to = next(width * height);
+            if (from != to && !isWall(from % width, from / width) && !isWall(to % width, to / width)) {
+                pairs.emplace_back(from, to);
+            }
+        }
+
+        HierarchicalPathfinder pathfinder;
+        pathfinder.Sync(walls.data(), wordsPerRow, width, height, 0);
+        std::vector<int32_t> distance;
+        std::vector<int32_t> queue;
+        long long walks = 0;
+        long long cutOff = 0;
+        long long failures = 0;
+        double worstRatio = 1.0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round <= edits; ++round) {
+            for (const auto& [from, to] : pairs) {
+                if (isWall(from % width, from / width) || isWall(to % width, to / width)) {
+                    continue;
+                }
+                WalkDistances(walls, wordsPerRow, width, height, to, distance, queue);
+                const int shortest = distance[from];
+                int x = from % width;
+                int y = from / width;
+                int steps = 0;
+                const int limit = shortest * 2 + 4 * HierarchicalPathfinder::kClusterTiles;
+                int stepX = 0;
+                int stepY = 0;
+                while (y * width + x != to && steps < limit
+                       && pathfinder.NextStep(x, y, to % width, to / width, stepX, stepY)) {
+                    if (std::abs(stepX - x) + std::abs(stepY - y) != 1 || isWall(stepX, stepY)) {
+                        break;
+                    }
+                    x = stepX;
+                    y = stepY;
+                    ++steps;
+                }
+
+                ++walks;
+                const bool arrived = y * width + x == to;
+                if (shortest < 0) {
+                    ++cutOff;
+                    failures += steps > 0 || arrived ? 1 : 0;
+                } else if (!arrived || steps > shortest + shortest / 10 + 2 * HierarchicalPathfinder::kClusterTiles) {
+                    ++failures;
+                } else if (shortest > 0) {
+                    worstRatio = std::max(worstRatio, static_cast<double>(steps) / shortest);
+                }
+            }
+            if (round == edits) {
+                break;
+            }
+
+            // Alternately wall off a patch on one pair's shortest path, which
+            // breaks the routes cached for it, and open a patch anywhere.
+            const int patch = 3;
+            const auto& [from, to] = pairs[static_cast<size_t>(next(static_cast<int>(pairs.size())))];
+            int centre = next(width * height);
+            if (round % 2 == 0 && !isWall(from % width, from / width) && !isWall(to % width, to / width)) {
+                WalkDistances(walls, wordsPerRow, width, height, to, distance, queue);
+                for (int k = distance[from] / 2, tile = from; k > 0 && tile >= 0; --k) {
+                    // Down the distance gradient, halfway to the target.
+                    const int tx = tile % width;
+                    const int ty = tile / width;
+                    const int around[4] = { tile - 1, tile + 1, tile - width, tile + width };
+                    tile = -1;
+                    for (const int candidate : around) {
+                        const int cx = candidate % width;
+                        const int cy = candidate / width;
+                        if (candidate >= 0 && candidate < width * height && std::abs(cx - tx) + std::abs(cy - ty) == 1
+                            && distance[candidate] == distance[ty * width + tx] - 1) {
+                            tile = candidate;
+                            break;
+                        }
+                    }
+                    centre = tile >= 0 ? tile : centre;
+                }
+            }
+            const int minX = std::clamp(centre % width - patch / 2, 1, std::max(1, width - 1 - patch));
+            const int minY = std::clamp(centre / width - patch / 2, 1, std::max(1, height - 1 - patch));
+            const int maxX = std::min(minX + patch - 1, width - 2);
+            const int maxY = std::min(minY + patch - 1, height - 2);
+            for (int py = minY; py <= maxY; ++py) {
+                for (int px = minX; px <= maxX; ++px) {
+                    setWall(px, py, round % 2 == 0);
+                }
+            }
+            pathfinder.InvalidateRegion(minX, minY, maxX, maxY);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const HierarchicalPathfinder::Stats& stats = pathfinder.GetStats();
+        std::printf("paths=%lld cut_off=%lld edits=%d seconds=%.3f worst_ratio=%.3f route_hits=%llu route_misses=%llu"
+                    " failures=%lld %s\n",
+                    walks, cutOff, edits, seconds, worstRatio,
+                    static_cast<unsigned long long>(stats.pathHits),
+                    static_cast<unsigned long long>(stats.pathMisses), failures, failures == 0 ? "OK" : "MISMATCH");
+        return failures == 0 ? 0 : 2;
+    }
+
+    // Spectators of a bot run, each on its own simulated link to the
+    // server. Once the run ends the server keeps broadcasting the final
+    // state until every spectator shows it.
+    class SpectatorTest {
+    public:
+        SpectatorTest(int count, const LoopbackConditions& conditions, uint64_t seed) {
+            for (int i = 0; i < count; ++i) {
+                networks_.push_back(std::make_unique<LoopbackNetwork>(conditions, seed + static_cast<uint64_t>(i)));
+                clients_.push_back(std::make_unique<SyncClient>(networks_.back()->GetEndpoint(1)));
+                server_.AddClient(networks_.back()->GetEndpoint(0));
+            }
+        }
+
+        void Tick(const Simulation& simulation, double milliseconds, bool broadcast) {
+            for (size_t i = 0; i < clients_.size(); ++i) {
+                networks_[i]->Advance(milliseconds);
+                clients_[i]->Poll();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            server_.Poll();
+            if (broadcast) {
+                server_.Broadcast(simulation);
+            }
+            serverSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            simulatedMilliseconds_ += milliseconds;
+        }
+
+        // Prints bandwidth and server cost; false unless every spectator
+        // ends up showing `simulation` to within the position quantum.
+        bool Finish(const Simulation& simulation, double broadcastMilliseconds) {
+            const double seconds = simulatedMilliseconds_ / 1000.0;
+            const SyncServerStats stats = server_.GetStats();
+            for (int round = 0; round < 1000 && CountInSync(simulation) < clients_.size(); ++round) {
+                Tick(simulation, broadcastMilliseconds, true);
+            }
+            const size_t inSync = CountInSync(simulation);
+
+            const double spectators = static_cast<double>(clients_.size());
+            const double broadcasts = static_cast<double>(std::max<uint64_t>(stats.broadcasts, 1));
+            std::printf("spectators=%zu broadcasts=%llu encodes_per_broadcast=%.2f keyframes=%llu"
+                        " bytes_per_frame=%.1f packets_per_frame=%.2f kbit_per_spectator=%.2f\n",
+                        clients_.size(), static_cast<unsigned long long>(stats.broadcasts),
+                        stats.encodes / broadcasts, static_cast<unsigned long long>(stats.keyframes),
+                        stats.framesSent > 0 ? static_cast<double>(stats.bytesSent) / stats.framesSent : 0.0,
+                        stats.framesSent > 0 ? static_cast<double>(stats.packetsSent) / stats.framesSent : 0.0,
+                        seconds > 0.0 ? stats.bytesSent * 8.0 / 1000.0 / seconds / spectators : 0.0);
+            std::printf("server_us_per_broadcast=%.1f (capture=%.1f encode=%.1f send=%.1f)"
+                        " server_us_per_spectator=%.3f server_core_share=%.4f in_sync=%zu/%zu %s\n",
+                        serverSeconds_ * 1e6 / broadcasts, stats.captureNs / 1e3 / broadcasts,
+                        stats.encodeNs / 1e3 / broadcasts, stats.sendNs / 1e3 / broadcasts,
+                        serverSeconds_ * 1e6 / broadcasts / spectators,
+                        seconds > 0.0 ? serverSeconds_ / seconds : 0.0, inSync, clients_.size(),
+                        inSync == clients_.size() ? "OK" : "MISMATCH");
+            return inSync == clients_.size();
+        }
+
+    private:
+        size_t CountInSync(const Simulation& simulation) const {
+            size_t count = 0;
+            for (const auto& client : clients_) {
+                count += Matches(client->GetView(), simulation) ? 1 : 0;
+            }
+            return count;
+        }
+
+        static bool Close(float viewed, float actual) {
+            return std::fabs(viewed - actual) <= 0.5f / 8.0f + 1e-3f;
+        }
+
+        static bool Matches(const SyncView& view, const Simulation& simulation) {
+            const Player* players[2] = { &simulation.GetPlayerA(), &simulation.GetPlayerB() };
+            const GhostArray& ghosts = simulation.GetGhosts();
+            const TileMap& map = simulation.GetMap();
+            if (view.state != simulation.GetState() || view.tick != static_cast<uint32_t>(simulation.GetTick())
+                || view.ghostX.size() != ghosts.Size() || view.remainingPellets != map.GetRemainingPellets()) {
+                return false;
+            }
+            for (int i = 0; i < 2; ++i) {
+                if (!Close(view.playerPosition[i].x, players[i]->position.x)
+                    || !Close(view.playerPosition[i].y, players[i]->position.y)
+                    || view.playerScore[i] != players[i]->score || view.playerLives[i] != players[i]->lives) {
+                    return false;
+                }
+            }
+            for (size_t i = 0; i < ghosts.Size(); ++i) {
+                if (!Close(view.ghostX[i], ghosts.positionX[i]) || !Close(view.ghostY[i], ghosts.positionY[i])) {
+                    return false;
+                }
+            }
+            const size_t wordCount = static_cast<size_t>(map.GetWordsPerRow()) * map.GetHeight();
+            return view.pellets.size() == wordCount
+                && std::memcmp(view.pellets.data(), map.GetPelletWords(), wordCount * sizeof(uint64_t)) == 0;
+        }
+
+        std::vector<std::unique_ptr<LoopbackNetwork>> networks_{};
+        std::vector<std::unique_ptr<SyncClient>> clients_{};
+        SyncServer server_{};
+        double serverSeconds_ = 0.0;
+        double simulatedMilliseconds_ = 0.0;
+    };
+
+    struct NetplayRun {
+        std::string mapPath;
+        long long ticks = 0;
+        float deltaSeconds = 0.0f;
+        uint64_t seed = 0;
+        int ghostCount = 0;
+        GhostKernel kernel = GhostKernel::Auto;
+        CaptureCheck captureCheck = CaptureCheck::BruteForce;
+        GhostSchedule schedule = GhostSchedule::Full;
+        GhostScheduleRules scheduleRules{};
+        GhostTargeting targeting = GhostTargeting::ChaseOnly;
+        SpawnPlacementRules spawnRules{};
+        LoopbackConditions conditions{};
+        int inputDelay = 0;
+        std::string recordPath;
+    };
+
+    void PrintRollbackStats(int peer, const RollbackSession& session, const Simulation& simulation) {
+        const RollbackStats& stats = session.GetStats();
+        std::printf("peer=%d rollbacks=%llu resimulated_ticks=%llu stalls=%llu packets_sent=%llu packets_received=%llu"
+                    " save_us=avg:%.1f,max:%.1f load_us=avg:%.1f,max:%.1f state_hash=%016llx\n",
+                    peer, static_cast<unsigned long long>(stats.rollbacks),
+                    static_cast<unsigned long long>(stats.resimulatedTicks),
+                    static_cast<unsigned long long>(stats.stalls),
+                    static_cast<unsigned long long>(stats.packetsSent),
+                    static_cast<unsigned long long>(stats.packetsReceived),
+                    stats.saves > 0 ? stats.saveNsTotal / 1e3 / stats.saves : 0.0, stats.saveNsMax / 1e3,
+                    stats.loads > 0 ? stats.loadNsTotal / 1e3 / stats.loads : 0.0, stats.loadNsMax / 1e3,
+                    static_cast<unsigned long long>(simulation.ComputeStateHash()));
+    }
+
+    // Plays two rollback peers against each other over a simulated network,
+    // each with its own bot, then checks that both ended in the same state,
+    // counted the same confirmed ticks into their metrics however often
+    // each rolled back, and that peer 0's recording of the confirmed inputs
+    // replays to it.
+    int RunNetplayLoopback(const NetplayRun& run) {
+        Simulation simulations[2];
+        for (Simulation& simulation : simulations) {
+            simulation.SetGhostCount(run.ghostCount);
+            simulation.SetGhostKernel(run.kernel);
+            simulation.SetCaptureCheck(run.captureCheck);
+            simulation.SetGhostSpawnRules(run.spawnRules);
+            simulation.SetGhostSchedule(run.schedule);
+            simulation.SetGhostScheduleRules(run.scheduleRules);
+            simulation.SetGhostTargeting(run.targeting);
+            if (!simulation.LoadMap(run.mapPath)) {
+                std::fprintf(stderr, "Failed to load map: %s\n", run.mapPath.c_str());
+                return 1;
+            }
+        }
+
+        LoopbackNetwork network(run.conditions, run.seed);
+        RollbackSession sessions[2] = {
+            RollbackSession(simulations[0], network.GetEndpoint(0), 0, run.deltaSeconds),
+            RollbackSession(simulations[1], network.GetEndpoint(1), 1, run.deltaSeconds)
+        };
+        BotInputSource bots[2] = { BotInputSource(run.seed), BotInputSource(run.seed + 1) };
+        InputRecorder recorder;
+        recorder.Begin(InputLogHeader{ run.mapPath, simulations[0].GetTilePixelSize(), run.ghostCount,
+                                       run.schedule, run.scheduleRules, run.targeting, run.spawnRules });
+        sessions[0].SetRecorder(&recorder);
+        Metrics metrics[2];
+        for (int peer = 0; peer < 2; ++peer) {
+            sessions[peer].SetInputDelay(run.inputDelay);
+            sessions[peer].SetMetrics(&metrics[peer]);
+        }
+
+        // Both peers tick on the same virtual clock; the one that is turned
+        // down waits out the step, as a real peer would.
+        const uint64_t ticks = static_cast<uint64_t>(run.ticks);
+        const double stepMilliseconds = run.deltaSeconds * 1000.0;
+        const auto start = std::chrono::steady_clock::now();
+        while (sessions[0].GetTick() < ticks || sessions[1].GetTick() < ticks) {
+            network.Advance(stepMilliseconds);
+            for (int peer = 0; peer < 2; ++peer) {
+                sessions[peer].Poll();
+                if (sessions[peer].GetTick() < ticks) {
+                    InputFrame frame = bots[peer].Poll();
+                    KeepMatchRunning(simulations[peer], frame);
+                    sessions[peer].Advance(frame);
+                }
+            }
+        }
+
+        // Let the last inputs land, resending whatever is lost on the way.
+        const long long maxFlushSteps = 100000;
+        long long flushSteps = 0;
+        while ((sessions[0].GetConfirmedTick() < ticks || sessions[1].GetConfirmedTick() < ticks)
+               && flushSteps++ < maxFlushSteps) {
+            network.Advance(stepMilliseconds);
+            for (RollbackSession& session : sessions) {
+                session.Poll();
+                session.SendInputs();
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        for (RollbackSession& session : sessions) {
+            session.RewindToConfirmed();
+        }
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::printf("netplay=loopback ticks=%llu seconds=%.3f latency_ms=%.1f jitter_ms=%.1f loss=%.3f input_delay=%d"
+                    " packets=%llu lost=%llu confirmed=%llu/%llu\n",
+                    static_cast<unsigned long long>(ticks), seconds, run.conditions.latencyMilliseconds,
+                    run.conditions.jitterMilliseconds, run.conditions.lossRate, run.inputDelay,
+                    static_cast<unsigned long long>(network.GetPacketsSent()),
+                    static_cast<unsigned long long>(network.GetPacketsLost()),
+                    static_cast<unsigned long long>(sessions[0].GetConfirmedTick()),
+                    static_cast<unsigned long long>(sessions[1].GetConfirmedTick()));
+        for (int peer = 0; peer < 2; ++peer) {
+            PrintRollbackStats(peer, sessions[peer], simulations[peer]);
+        }
+        PrintSimulationSummary(simulations[0]);
+
+        const uint64_t hash = simulations[0].ComputeStateHash();
+        const bool confirmed = sessions[0].GetConfirmedTick() == ticks && sessions[1].GetConfirmedTick() == ticks;
+        const bool peersMatch = confirmed && hash == simulations[1].ComputeStateHash();
+        std::printf("peers %s\n", !confirmed ? "UNCONFIRMED" : peersMatch ? "OK" : "MISMATCH");
+        if (!peersMatch) {
+            return 2;
+        }
+        const auto counters = [](const Metrics& peer) {
+            return std::array<uint64_t, 5>{ peer.ticks.load(), peer.pelletsConsumed.load(), peer.captures.load(),
+                                            peer.resets.load(), peer.ghostUpdateTime.GetCount() };
+        };
+        const bool metricsMatch = counters(metrics[0]) == counters(metrics[1]) && metrics[0].ticks.load() == ticks;
+        std::printf("metrics %s ticks=%llu pellets=%llu captures=%llu\n", metricsMatch ? "OK" : "MISMATCH",
+                    static_cast<unsigned long long>(metrics[0].ticks.load()),
+                    static_cast<unsigned long long>(metrics[0].pelletsConsumed.load()),
+                    static_cast<unsigned long long>(metrics[0].captures.load()));
+        if (!metricsMatch) {
+            return 2;
+        }
+
+        // The replay reads the recording from memory; it only goes to disk
+        // when asked for.
+        if (!run.recordPath.empty() && !recorder.Save(run.recordPath, hash)) {
+            std::fprintf(stderr, "Could not write recording to %s\n", run.recordPath.c_str());
+            return 1;
+        }
+        std::vector<uint8_t> bytes;
+        recorder.Serialize(hash, bytes);
+        InputLog log;
+        if (!log.LoadFromBytes(std::move(bytes))) {
+            std::fprintf(stderr, "Could not read back the netplay recording\n");
+            return 1;
+        }
+        return RunReplay(log, run.recordPath.empty() ? "(memory)" : run.recordPath, run.kernel, run.captureCheck);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string mapPath = "builtin:level1";
+    long long ticks = 1000000;
+    float deltaSeconds = 1.0f / 60.0f;
+    unsigned long long seed = 1;
+    int ghostCount = 6;
+    GhostKernel kernel = GhostKernel::Auto;
+    CaptureCheck captureCheck = CaptureCheck::BruteForce;
+    GhostSchedule schedule = GhostSchedule::Full;
+    GhostScheduleRules scheduleRules{};
+    GhostTargeting targeting = GhostTargeting::ChaseOnly;
+    std::string tracePath;
+    std::string recordPath;
+    std::string replayPath;
+    SpawnPlacementRules spawnRules{};
+    MetricsExportOptions metricsOptions{};
+    bool netplay = false;
+    LoopbackConditions netConditions{};
+    int netInputDelay = 0;
+    int spectatorCount = 0;
+    double spectateHz = 30.0;
+    bool compareKernels = false;
+    int pathCheckEdits = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--map") == 0 && hasValue) {
+            mapPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dt") == 0 && hasValue) {
+            deltaSeconds = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ghosts") == 0 && hasValue) {
+            ghostCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--kernel") == 0 && hasValue && ParseKernel(argv[i + 1], kernel)) {
+            ++i;
+        } else if (std::strcmp(argv[i], "--ghost-separation") == 0 && hasValue) {
+            spawnRules.minSeparation = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ghost-player-distance") == 0 && hasValue) {
+            spawnRules.minDistanceFromPlayers = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-port") == 0 && hasValue) {
+            metricsOptions.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--metrics-log") == 0 && hasValue) {
+            metricsOptions.logPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-interval") == 0 && hasValue) {
+            metricsOptions.logIntervalSeconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--netplay") == 0 && hasValue && std::strcmp(argv[i + 1], "loopback") == 0) {
+            netplay = true;
+            ++i;
+        } else if (std::strcmp(argv[i], "--net-latency") == 0 && hasValue) {
+            netConditions.latencyMilliseconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-jitter") == 0 && hasValue) {
+            netConditions.jitterMilliseconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-loss") == 0 && hasValue) {
+            netConditions.lossRate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--net-delay") == 0 && hasValue) {
+            netInputDelay = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spectators") == 0 && hasValue) {
+            spectatorCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spectate-hz") == 0 && hasValue) {
+            spectateHz = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--compare-kernels") == 0) {
+            compareKernels = true;
+        } else if (std::strcmp(argv[i], "--check-paths") == 0 && hasValue) {
+            pathCheckEdits = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--capture") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "brute") == 0) {
+                captureCheck = CaptureCheck::BruteForce;
+            } else if (std::strcmp(name, "grid") == 0) {
+                captureCheck = CaptureCheck::Grid;
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--ai") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "full") == 0) {
+                schedule = GhostSchedule::Full;
+            } else if (std::strcmp(name, "budgeted") == 0) {
+                schedule = GhostSchedule::Budgeted;
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--ai-budget") == 0 && hasValue) {
+            scheduleRules.decisionBudget = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--targets") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "chase") == 0) {
+                targeting = GhostTargeting::ChaseOnly;
+            } else if (std::strcmp(name, "mixed") == 0) {
+                targeting = GhostTargeting::Mixed;
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Profiler::SetThreadName("simulation");
+
+    if (!replayPath.empty()) {
+        const int result = RunReplay(replayPath, kernel, captureCheck);
+        if (!tracePath.empty() && !Profiler::WriteChromeTrace(tracePath)) {
+            std::fprintf(stderr, "Could not write trace to %s (build with -DPACMEN_PROFILE=ON)\n", tracePath.c_str());
+            return 1;
+        }
+        return result;
+    }
+
+    if (pathCheckEdits >= 0) {
+        return RunPathCheck(mapPath, pathCheckEdits, seed);
+    }
+
+    if (compareKernels) {
+        KernelComparison run;
+        run.mapPath = mapPath;
+        run.ticks = ticks;
+        run.deltaSeconds = deltaSeconds;
+        run.seed = seed;
+        run.ghostCount = ghostCount;
+        run.captureCheck = captureCheck;
+        run.schedule = schedule;
+        run.scheduleRules = scheduleRules;
+        run.targeting = targeting;
+        run.spawnRules = spawnRules;
+        return RunKernelComparison(run);
+    }
+
+    if (netplay) {
+        NetplayRun run;
+        run.mapPath = mapPath;
+        run.ticks = ticks;
+        run.deltaSeconds = deltaSeconds;
+        run.seed = seed;
+        run.ghostCount = ghostCount;
+        run.kernel = kernel;
+        run.captureCheck = captureCheck;
+        run.schedule = schedule;
+        run.scheduleRules = scheduleRules;
+        run.targeting = targeting;
+        run.spawnRules = spawnRules;
+        run.conditions = netConditions;
+        run.inputDelay = netInputDelay;
+        run.recordPath = recordPath;
+        const int result = RunNetplayLoopback(run);
+        if (!tracePath.empty() && !Profiler::WriteChromeTrace(tracePath)) {
+            std::fprintf(stderr, "Could not write trace to %s (build with -DPACMEN_PROFILE=ON)\n", tracePath.c_str());
+            return 1;
+        }
+        return result;
+    }
+
+    Simulation simulation;
+    simulation.SetGhostCount(ghostCount);
+    simulation.SetGhostKernel(kernel);
+    simulation.SetCaptureCheck(captureCheck);
+    simulation.SetGhostSpawnRules(spawnRules);
+    simulation.SetGhostSchedule(schedule);
+    simulation.SetGhostScheduleRules(scheduleRules);
+    simulation.SetGhostTargeting(targeting);
+    if (!simulation.LoadMap(mapPath)) {
+        std::fprintf(stderr, "Failed to load map: %s\n", mapPath.c_str());
+        return 1;
+    }
+
+    // Soak runs publish tick times and counters while they run; otherwise
+    // nothing is timed per tick.
+    Metrics metrics;
+    MetricsExporter metricsExporter;
+    const bool exportMetrics = metricsOptions.port > 0 || !metricsOptions.logPath.empty();
+    if (exportMetrics) {
+        simulation.SetMetrics(&metrics);
+        if (!metricsExporter.Start(metrics, metricsOptions)) {
+            std::fprintf(stderr, "Could not serve metrics on 127.0.0.1:%d\n", metricsOptions.port);
+        }
+    }
+
+    InputRecorder recorder;
+    if (!recordPath.empty()) {
+        recorder.Begin(InputLogHeader{ mapPath, simulation.GetTilePixelSize(), ghostCount, schedule, scheduleRules,
+                                       targeting, spawnRules });
+    }
+
+    // The network conditions apply to every spectator's link. Broadcasts
+    // go out on the simulation clock, at the nearest whole tick.
+    std::unique_ptr<SpectatorTest> spectators;
+    const double tickMilliseconds = deltaSeconds * 1000.0;
+    const long long ticksPerBroadcast =
+        spectateHz > 0.0 ? std::max(1LL, std::llround(1.0 / (spectateHz * deltaSeconds))) : 1;
+    if (spectatorCount > 0) {
+        spectators = std::make_unique<SpectatorTest>(spectatorCount, netConditions, seed);
+    }
+
+    BotInputSource bots(seed);
+    long long matches = 0;
+    long long ghostSteps = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < ticks; ++i) {
+        InputFrame frame = bots.Poll();
+
+        if (KeepMatchRunning(simulation, frame)) {
+            ++matches;
+        } else if (simulation.GetState() == GameState::Playing) {
+            ghostSteps += static_cast<long long>(simulation.GetGhosts().Size());
+        }
+
+        if (!recordPath.empty()) {
+            recorder.Record(frame, deltaSeconds);
+        }
+        if (exportMetrics) {
+            const auto updateStart = std::chrono::steady_clock::now();
+            simulation.Update(frame, deltaSeconds);
+            metrics.updateTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - updateStart).count());
+        } else {
+            simulation.Update(frame, deltaSeconds);
+        }
+        if (spectators) {
+            spectators->Tick(simulation, tickMilliseconds, (i + 1) % ticksPerBroadcast == 0);
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    metricsExporter.Stop();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double ticksPerSecond = seconds > 0.0 ? ticks / seconds : 0.0;
+    const double realTimeFactor = ticksPerSecond * deltaSeconds;
+    const double ghostsPerSecond = seconds > 0.0 ? ghostSteps / seconds : 0.0;
+
+    std::printf("ticks=%lld seconds=%.3f ticks_per_sec=%.0f realtime_x=%.1f matches=%lld\n",
+                ticks, seconds, ticksPerSecond, realTimeFactor, matches);
+    std::printf("kernel=%s ghosts=%d ghosts_per_sec=%.0f checksum=%016llx\n",
+                GhostKernelName(simulation.GetGhostKernel()), ghostCount, ghostsPerSecond,
+                static_cast<unsigned long long>(simulation.ComputeStateHash()));
+    if (schedule == GhostSchedule::Budgeted) {
+        const GhostScheduleStats& stats = simulation.GetGhostScheduleStats();
+        std::printf("ai=budgeted budget=%d decisions_per_tick=%.1f last_tick_decisions=%u"
+                    " last_tick_deferred=%u overrun_ticks=%llu\n",
+                    scheduleRules.decisionBudget,
+                    stats.ticks > 0 ? static_cast<double>(stats.totalDecisions) / stats.ticks : 0.0,
+                    stats.decisions, stats.deferred,
+                    static_cast<unsigned long long>(stats.overrunTicks));
+    }
+    if (targeting == GhostTargeting::Mixed) {
+        const HierarchicalPathfinder::Stats& stats = simulation.GetPathfinderStats();
+        std::printf("targets=mixed route_hits=%llu route_misses=%llu field_hits=%llu field_misses=%llu"
+                    " clusters_built=%llu nodes_expanded=%llu\n",
+                    static_cast<unsigned long long>(stats.pathHits),
+                    static_cast<unsigned long long>(stats.pathMisses),
+                    static_cast<unsigned long long>(stats.fieldHits),
+                    static_cast<unsigned long long>(stats.fieldMisses),
+                    static_cast<unsigned long long>(stats.clustersBuilt),
+                    static_cast<unsigned long long>(stats.nodesExpanded));
+    }
+    PrintSimulationSummary(simulation);
+    const bool spectatorsInSync = !spectators || spectators->Finish(simulation, tickMilliseconds * ticksPerBroadcast);
+
+    if (!recordPath.empty() && !recorder.Save(recordPath, simulation.ComputeStateHash())) {
+        std::fprintf(stderr, "Could not write recording to %s\n", recordPath.c_str());
+        return 1;
+    }
+
+    if (!tracePath.empty() && !Profiler::WriteChromeTrace(tracePath)) {
+        std::fprintf(stderr, "Could not write trace to %s (build with -DPACMEN_PROFILE=ON)\n", tracePath.c_str());
+        return 1;
+    }
+    return spectatorsInSync ? 0 : 2;
+}
@@ -0,0 +1,66 @@
+#include "game/TileMap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Compiles a text map into the binary .pmap format that TileMap::LoadFromFile
+// memory-maps at startup, and checks the result loads back identically.
+
+namespace {
+    bool SameMap(const TileMap& a, const TileMap& b) {
+        if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight() ||
+            a.GetRemainingPellets() != b.GetRemainingPellets() ||
+            a.HasPlayerSpawnA() != b.HasPlayerSpawnA() ||
+            a.HasPlayerSpawnB() != b.HasPlayerSpawnB() ||
+            a.GetGhostSpawns().size() != b.GetGhostSpawns().size()) {
+            return false;
+        }
+
+        for (int y = 0; y < a.GetHeight(); ++y) {
+            for (int x = 0; x < a.GetWidth(); ++x) {
+                if (a.GetTile(x, y) != b.GetTile(x, y)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::printf("usage: %s input.txt output.pmap\n", argv[0]);
+        return 1;
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+
+    TileMap source;
+    if (!source.LoadFromFile(inputPath)) {
+        std::fprintf(stderr, "Failed to load map: %s\n", inputPath.c_str());
+        return 1;
+    }
+
+    if (!source.SaveCompiled(outputPath)) {
+        std::fprintf(stderr, "Failed to write: %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    TileMap compiled;
+    const bool loaded = compiled.LoadFromFile(outputPath);
+    const auto end = std::chrono::steady_clock::now();
+
+    if (!loaded || !SameMap(source, compiled)) {
+        std::fprintf(stderr, "Compiled map does not match its source: %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    std::printf("%s -> %s: %dx%d, %d pellets, %zu ghost spawns, loads in %.3f ms\n",
+                inputPath.c_str(), outputPath.c_str(), compiled.GetWidth(), compiled.GetHeight(),
+                compiled.GetRemainingPellets(), compiled.GetGhostSpawns().size(),
+                std::chrono::duration<double, std::milli>(end - start).count());
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "sim/MazeGenerator.h"
+#include "sim/Profiler.h"
+#include "sim/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Generates a seeded maze map once per thread count, reports how long each
+// run took and checks every run produced the same tiles, then writes the
+// map in the text format TileMap loads.
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::printf("usage: %s --out path [--width N] [--height N] [--seed N] [--density 0..1] [--loops 0..1]"
+                    " [--ghosts N] [--region N] [--threads 1,2,4,...] [--trace path]\n", program);
+    }
+
+    std::vector<int> ParseThreadCounts(const char* text) {
+        std::vector<int> counts;
+        const char* cursor = text;
+        while (*cursor != '\0') {
+            char* end = nullptr;
+            const long value = std::strtol(cursor, &end, 10);
+            if (end == cursor || value <= 0) {
+                return {};
+            }
+            counts.push_back(static_cast<int>(value));
+            cursor = (*end == ',') ? end + 1 : end;
+        }
+        return counts;
+    }
+}
+
+int main(int argc, char** argv) {
+    MazeSettings settings;
+    std::string outputPath;
+    std::string tracePath;
+    std::vector<int> threadCounts{ static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) };
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+            settings.width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+            settings.height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            settings.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--density") == 0 && hasValue) {
+            settings.density = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--loops") == 0 && hasValue) {
+            settings.loopRate = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--ghosts") == 0 && hasValue) {
+            settings.ghostCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--region") == 0 && hasValue) {
+            settings.regionCells = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threadCounts = ParseThreadCounts(argv[++i]);
+            if (threadCounts.empty()) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (outputPath.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Profiler::SetThreadName("main");
+    Maze maze;
+    uint64_t firstHash = 0;
+    bool consistent = true;
+    double baselineSeconds = 0.0;
+    for (size_t run = 0; run < threadCounts.size(); ++run) {
+        ThreadPool pool(threadCounts[run]);
+        const auto start = std::chrono::steady_clock::now();
+        GenerateMaze(settings, pool, maze);
+        const auto end = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const uint64_t hash = maze.ComputeHash();
+        if (run == 0) {
+            firstHash = hash;
+            baselineSeconds = seconds;
+        }
+        consistent = consistent && hash == firstHash;
+        std::printf("threads=%d size=%dx%d seconds=%.3f mtiles_per_sec=%.1f speedup=%.2f hash=%016llx\n",
+                    threadCounts[run], maze.width, maze.height, seconds,
+                    seconds > 0.0 ? static_cast<double>(maze.tiles.size()) / seconds / 1e6 : 0.0,
+                    seconds > 0.0 ? baselineSeconds / seconds : 0.0, static_cast<unsigned long long>(hash));
+    }
+
+    size_t open = 0;
+    size_t ghosts = 0;
+    for (const char tile : maze.tiles) {
+        open += tile != '#' ? 1 : 0;
+        ghosts += tile == 'G' ? 1 : 0;
+    }
+    std::printf("open_tiles=%.1f%% ghost_spawns=%zu %s\n", 100.0 * open / maze.tiles.size(), ghosts,
+                consistent ? "OK" : "MISMATCH");
+
+    if (!maze.SaveText(outputPath)) {
+        std::fprintf(stderr, "Could not write %s\n", outputPath.c_str());
+        return 1;
+    }
+    if (!tracePath.empty() && !Profiler::WriteChromeTrace(tracePath)) {
+        std::fprintf(stderr, "Could not write trace to %s (build with -DPACMEN_PROFILE=ON)\n", tracePath.c_str());
+        return 1;
+    }
+    return consistent ? 0 : 2;
+}
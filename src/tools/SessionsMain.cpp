@@ -0,0 +1,140 @@
+#include "sim/Profiler.h"
+#include "sim/SessionRunner.h"
+#include "sim/ThreadPool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs the same set of bot sessions once per thread count and reports
+// aggregate session-ticks/sec, speedup over one thread and scaling
+// efficiency. The combined state hash must not change with the thread count.
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::printf("usage: %s [--map path] [--sessions N] [--ticks N] [--ghosts N] [--seed N]"
+                    " [--threads 1,2,4,...] [--slice N] [--trace path]\n", program);
+    }
+
+    std::vector<int> ParseThreadCounts(const char* text) {
+        std::vector<int> counts;
+        const char* cursor = text;
+        while (*cursor != '\0') {
+            char* end = nullptr;
+            const long value = std::strtol(cursor, &end, 10);
+            if (end == cursor || value <= 0) {
+                return {};
+            }
+            counts.push_back(static_cast<int>(value));
+            cursor = (*end == ',') ? end + 1 : end;
+        }
+        return counts;
+    }
+
+    // 1, 2, 4, ... up to and including the hardware thread count.
+    std::vector<int> DefaultThreadCounts() {
+        const int hardware = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> counts;
+        for (int count = 1; count < hardware; count *= 2) {
+            counts.push_back(count);
+        }
+        counts.push_back(hardware);
+        return counts;
+    }
+}
+
+int main(int argc, char** argv) {
+    SessionConfig config;
+    int sessionCount = 0;
+    uint64_t ticks = 20000;
+    uint64_t slice = 256;
+    std::vector<int> threadCounts = DefaultThreadCounts();
+    std::string tracePath;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--map") == 0 && hasValue) {
+            config.mapPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--sessions") == 0 && hasValue) {
+            sessionCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ghosts") == 0 && hasValue) {
+            config.ghostCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--slice") == 0 && hasValue) {
+            slice = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threadCounts = ParseThreadCounts(argv[++i]);
+            if (threadCounts.empty()) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (sessionCount <= 0) {
+        // Several sessions per core leaves room for stealing to even out load.
+        int maxThreads = 1;
+        for (int count : threadCounts) {
+            maxThreads = std::max(maxThreads, count);
+        }
+        sessionCount = maxThreads * 4;
+    }
+
+    double baselineRate = 0.0;
+    int baselineThreads = 0;
+    uint64_t expectedHash = 0;
+    bool consistent = true;
+
+    for (int threads : threadCounts) {
+        SessionRunner runner;
+        if (!runner.Initialize(config, sessionCount)) {
+            std::fprintf(stderr, "Failed to load map: %s\n", config.mapPath.c_str());
+            return 1;
+        }
+
+        ThreadPool pool(threads);
+        const auto start = std::chrono::steady_clock::now();
+        runner.Run(pool, ticks, slice);
+        const auto end = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const double rate = seconds > 0.0 ? runner.GetTotalTicks() / seconds : 0.0;
+        if (baselineThreads == 0) {
+            baselineRate = rate;
+            baselineThreads = threads;
+            expectedHash = runner.ComputeCombinedHash();
+        }
+
+        // Efficiency is per-thread throughput relative to the first row.
+        const double speedup = baselineRate > 0.0 ? rate / baselineRate : 0.0;
+        const double efficiency = speedup * baselineThreads / threads;
+        const uint64_t hash = runner.ComputeCombinedHash();
+        consistent = consistent && hash == expectedHash;
+
+        std::printf("threads=%d sessions=%d session_ticks=%llu seconds=%.3f session_ticks_per_sec=%.0f"
+                    " speedup=%.2f efficiency=%.2f matches=%llu hash=%016llx%s\n",
+                    threads, runner.GetSessionCount(),
+                    static_cast<unsigned long long>(runner.GetTotalTicks()), seconds, rate,
+                    speedup, efficiency, static_cast<unsigned long long>(runner.GetTotalMatches()),
+                    static_cast<unsigned long long>(hash), hash == expectedHash ? "" : " MISMATCH");
+    }
+
+    if (!tracePath.empty() && !Profiler::WriteChromeTrace(tracePath)) {
+        std::fprintf(stderr, "Could not write trace to %s (build with -DPACMEN_PROFILE=ON)\n", tracePath.c_str());
+        return 1;
+    }
+    return consistent ? 0 : 2;
+}